@@ -0,0 +1,550 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * accord_bench.c - run the benchmark configurations in the bench directory
+ *				and compare their performance with a stored baseline
+ *
+ *				Usage (from the bench directory):
+ *				../bin/accord_bench.out ACCORD [--runs N] [--tolerance T] [--save]
+ *				where ACCORD is an AcCoRD executable that was built with
+ *				-DACCORD_PROFILE (src/build_accord_bench builds it as
+ *				"../bin/accord_profile.out"). Every benchmark listed in
+ *				bench_suite.txt is run N times (default 1) with its fixed
+ *				seed and the fastest run is kept. The results are printed as
+ *				JSON. With --save, they are also written to
+ *				bench_baseline.txt. Otherwise, they are compared with
+ *				bench_baseline.txt, every metric that is worse than the
+ *				baseline by more than the fraction T (default 0.1) is listed
+ *				in "Regressions", and the exit status is 1 if there are any
+ *
+ *				Metrics of each benchmark:
+ *				WallTime - seconds to run the simulation (incl. start up)
+ *				MicroMolStepRate - microscopic molecule diffusion steps per
+ *					second of WallTime
+ *				MesoEventRate - mesoscopic diffusion and reaction events per
+ *					second of WallTime
+ *				PeakRSS - largest resident memory of the simulation (bytes)
+ *				OutputBytes - size of the simulation output file
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#define _DEFAULT_SOURCE // for wait4(), clock_gettime()
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h> // for DBL_MAX
+#include <time.h> // for clock_gettime()
+#include <sys/types.h>
+#include <sys/stat.h> // for stat(), mkdir()
+#include <sys/time.h>
+#include <sys/resource.h> // for struct rusage
+#include <sys/wait.h> // for wait4()
+#include <fcntl.h> // for open()
+#include <unistd.h> // for fork(), execl()
+#include "cJSON.h"
+
+//
+// Constant definitions
+//
+
+#define SUITE_NAME "bench_suite.txt"
+#define BASELINE_NAME "bench_baseline.txt"
+#define RESULT_DIR "results"
+
+// Default fraction by which a metric can be worse than the baseline
+#define DEFAULT_TOLERANCE 0.1
+
+// Number of metrics compared with the baseline
+#define NUM_METRIC 5
+
+//
+// Data Type Declarations
+//
+
+/* The benchResult structure has the measurements of one benchmark.
+*/
+struct benchResult {
+	double wallTime; // Shortest wall time of the runs (seconds)
+	uint64_t peakRSS; // Largest resident memory of the runs (bytes)
+	uint64_t numMicroMolStep; // Microscopic molecule diffusion steps
+	uint64_t numMesoEvent; // Mesoscopic diffusion and reaction events
+	uint64_t outputBytes; // Size of output file
+};
+
+//
+// "Private" Declarations
+//
+
+// Names of metrics and whether larger values are better
+static const char * METRIC_NAME[NUM_METRIC] = {
+	"WallTime", "MicroMolStepRate", "MesoEventRate", "PeakRSS", "OutputBytes"};
+static const bool METRIC_HIGHER_BETTER[NUM_METRIC] = {
+	false, true, true, false, false};
+
+// Read a whole text file. Returns NULL if the file cannot be read
+static char * readTextFile(const char * fileName);
+
+// Current wall time in seconds (from an arbitrary start)
+static double wallNow(void);
+
+// Run one simulation with output to the terminal suppressed
+static void runAccord(const char * accordName,
+	const char * configName,
+	const unsigned int seed,
+	double * wallTime,
+	uint64_t * peakRSS);
+
+// Read the profile counters from the summary file of a simulation
+static void readSummary(const char * outputName,
+	struct benchResult * result);
+
+// Find a number in a JSON object or exit with an error
+static double readNumber(cJSON * obj,
+	const char * name,
+	const char * fileName);
+
+// Find the size of the output file of a simulation
+static uint64_t findOutputBytes(const char * outputName);
+
+// Create the JSON object with the metrics of one benchmark
+static cJSON * createResultJSON(const char * name,
+	const struct benchResult * result);
+
+// Compare the metrics of one benchmark with its baseline. Add the relative
+// changes to the benchmark's object and the names of regressions to the array.
+// Returns the number of regressions
+static unsigned int compareWithBaseline(cJSON * curBench,
+	cJSON * baseBench,
+	const double tolerance,
+	cJSON * regressions);
+
+//
+// Definitions
+//
+
+int main(int argc, char *argv[])
+{
+	char * accordName;
+	char * suiteText, * configText, * baselineText, * outText;
+	char * outputName;
+	cJSON * suite, * benchArray, * curBench, * config, * outputFilename;
+	cJSON * name, * configName, * seed, * baseName;
+	cJSON * root, * resultArray, * curResult, * regressions;
+	cJSON * baseline = NULL, * baseArray, * baseBench;
+	int curArg, numBench, curBenchInd, numBase, curBase;
+	unsigned int runs = 1, curRun, numRegression = 0;
+	double tolerance = DEFAULT_TOLERANCE;
+	double wallTime;
+	uint64_t peakRSS;
+	bool bSave = false;
+	struct benchResult result;
+	FILE * baselineFile;
+
+	if(argc < 2)
+	{
+		fprintf(stderr, "Usage: %s ACCORD [--runs N] [--tolerance T] [--save]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	accordName = argv[1];
+	for(curArg = 2; curArg < argc; curArg++)
+	{
+		if(strcmp(argv[curArg], "--save") == 0)
+			bSave = true;
+		else if(strcmp(argv[curArg], "--runs") == 0 && curArg + 1 < argc)
+			runs = (unsigned int) atoi(argv[++curArg]);
+		else if(strcmp(argv[curArg], "--tolerance") == 0 && curArg + 1 < argc)
+			tolerance = atof(argv[++curArg]);
+		else
+		{
+			fprintf(stderr, "ERROR: Unknown argument \"%s\".\n", argv[curArg]);
+			return EXIT_FAILURE;
+		}
+	}
+	if(runs < 1)
+		runs = 1;
+
+	suiteText = readTextFile(SUITE_NAME);
+	if(suiteText == NULL)
+	{
+		fprintf(stderr, "ERROR: Cannot read \"%s\". Run from the bench directory.\n",
+			SUITE_NAME);
+		return EXIT_FAILURE;
+	}
+	suite = cJSON_Parse(suiteText);
+	benchArray = (suite == NULL) ? NULL : cJSON_GetObjectItem(suite, "Benchmarks");
+	if(benchArray == NULL || benchArray->type != cJSON_Array)
+	{
+		fprintf(stderr, "ERROR: \"%s\" does not have a \"Benchmarks\" array.\n",
+			SUITE_NAME);
+		return EXIT_FAILURE;
+	}
+
+	// Simulations write to "results" in the current directory if it exists
+	if(mkdir(RESULT_DIR, S_IRWXU) != 0 && errno != EEXIST)
+	{
+		fprintf(stderr, "ERROR: \"%s\" directory could not be created.\n", RESULT_DIR);
+		return EXIT_FAILURE;
+	}
+
+	root = cJSON_CreateObject();
+	cJSON_AddStringToObject(root, "Accord", accordName);
+	cJSON_AddNumberToObject(root, "Runs", runs);
+	cJSON_AddItemToObject(root, "Benchmarks", resultArray = cJSON_CreateArray());
+
+	numBench = cJSON_GetArraySize(benchArray);
+	for(curBenchInd = 0; curBenchInd < numBench; curBenchInd++)
+	{
+		curBench = cJSON_GetArrayItem(benchArray, curBenchInd);
+		name = cJSON_GetObjectItem(curBench, "Name");
+		configName = cJSON_GetObjectItem(curBench, "Config");
+		seed = cJSON_GetObjectItem(curBench, "Seed");
+		if(name == NULL || name->type != cJSON_String
+			|| configName == NULL || configName->type != cJSON_String
+			|| seed == NULL || seed->type != cJSON_Number || seed->valueint < 1)
+		{
+			fprintf(stderr, "ERROR: Benchmark %d needs a \"Name\", \"Config\", and positive \"Seed\".\n",
+				curBenchInd);
+			return EXIT_FAILURE;
+		}
+
+		// Find the name of the output files
+		configText = readTextFile(configName->valuestring);
+		config = (configText == NULL) ? NULL : cJSON_Parse(configText);
+		outputFilename = (config == NULL) ?
+			NULL : cJSON_GetObjectItem(config, "Output Filename");
+		if(outputFilename == NULL || outputFilename->type != cJSON_String)
+		{
+			fprintf(stderr, "ERROR: Cannot read \"Output Filename\" from \"%s\".\n",
+				configName->valuestring);
+			return EXIT_FAILURE;
+		}
+		outputName = malloc(strlen(RESULT_DIR) + strlen(outputFilename->valuestring) + 20);
+		if(outputName == NULL)
+		{
+			fprintf(stderr, "ERROR: Memory allocation for output name.\n");
+			return EXIT_FAILURE;
+		}
+		sprintf(outputName, "%s/%s_SEED%d", RESULT_DIR,
+			outputFilename->valuestring, seed->valueint);
+		cJSON_Delete(config);
+		free(configText);
+
+		// Run simulation
+		fprintf(stderr, "Running \"%s\" ...\n", name->valuestring);
+		result.wallTime = DBL_MAX;
+		result.peakRSS = 0;
+		for(curRun = 0; curRun < runs; curRun++)
+		{
+			runAccord(accordName, configName->valuestring,
+				(unsigned int) seed->valueint, &wallTime, &peakRSS);
+			if(wallTime < result.wallTime)
+				result.wallTime = wallTime;
+			if(peakRSS > result.peakRSS)
+				result.peakRSS = peakRSS;
+		}
+		readSummary(outputName, &result);
+		result.outputBytes = findOutputBytes(outputName);
+		cJSON_AddItemToArray(resultArray,
+			createResultJSON(name->valuestring, &result));
+		free(outputName);
+	}
+
+	if(bSave)
+	{
+		outText = cJSON_Print(root);
+		if((baselineFile = fopen(BASELINE_NAME, "w")) == NULL)
+		{
+			fprintf(stderr, "ERROR: Cannot write \"%s\".\n", BASELINE_NAME);
+			return EXIT_FAILURE;
+		}
+		fprintf(baselineFile, "%s\n", outText);
+		fclose(baselineFile);
+		free(outText);
+		fprintf(stderr, "Baseline written to \"%s\".\n", BASELINE_NAME);
+	} else
+	{
+		baselineText = readTextFile(BASELINE_NAME);
+		if(baselineText != NULL)
+			baseline = cJSON_Parse(baselineText);
+		baseArray = (baseline == NULL) ?
+			NULL : cJSON_GetObjectItem(baseline, "Benchmarks");
+		if(baseArray == NULL || baseArray->type != cJSON_Array)
+		{
+			fprintf(stderr, "WARNING: No baseline in \"%s\". Results are not compared.\n",
+				BASELINE_NAME);
+		} else
+		{
+			cJSON_AddItemToObject(root, "Regressions",
+				regressions = cJSON_CreateArray());
+			numBase = cJSON_GetArraySize(baseArray);
+			for(curBenchInd = 0; curBenchInd < numBench; curBenchInd++)
+			{
+				curResult = cJSON_GetArrayItem(resultArray, curBenchInd);
+				name = cJSON_GetObjectItem(curResult, "Name");
+				for(curBase = 0; curBase < numBase; curBase++)
+				{
+					baseBench = cJSON_GetArrayItem(baseArray, curBase);
+					baseName = cJSON_GetObjectItem(baseBench, "Name");
+					if(baseName != NULL && baseName->type == cJSON_String
+						&& strcmp(baseName->valuestring, name->valuestring) == 0)
+					{
+						numRegression += compareWithBaseline(curResult,
+							baseBench, tolerance, regressions);
+						break;
+					}
+				}
+			}
+		}
+		if(baseline != NULL)
+			cJSON_Delete(baseline);
+		if(baselineText != NULL)
+			free(baselineText);
+	}
+
+	outText = cJSON_Print(root);
+	printf("%s\n", outText);
+	free(outText);
+	cJSON_Delete(root);
+	cJSON_Delete(suite);
+	free(suiteText);
+
+	return (numRegression > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// Read a whole text file. Returns NULL if the file cannot be read
+static char * readTextFile(const char * fileName)
+{
+	FILE * file;
+	long fileLength;
+	char * text;
+
+	if((file = fopen(fileName, "r")) == NULL)
+		return NULL;
+	fseek(file, 0, SEEK_END);
+	fileLength = ftell(file);
+	rewind(file);
+	text = malloc(fileLength + 1);
+	if(text == NULL)
+	{
+		fclose(file);
+		return NULL;
+	}
+	fileLength = (long) fread(text, 1, fileLength, file);
+	text[fileLength] = '\0';
+	fclose(file);
+	return text;
+}
+
+// Current wall time in seconds (from an arbitrary start)
+static double wallNow(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) now.tv_sec + 1e-9 * now.tv_nsec;
+}
+
+// Run one simulation with output to the terminal suppressed
+static void runAccord(const char * accordName,
+	const char * configName,
+	const unsigned int seed,
+	double * wallTime,
+	uint64_t * peakRSS)
+{
+	char seedString[16];
+	pid_t pid;
+	int status, devNull;
+	struct rusage usage;
+	double startTime;
+
+	sprintf(seedString, "%u", seed);
+	startTime = wallNow();
+	pid = fork();
+	if(pid < 0)
+	{
+		fprintf(stderr, "ERROR: Cannot start simulation.\n");
+		exit(EXIT_FAILURE);
+	}
+	if(pid == 0)
+	{
+		devNull = open("/dev/null", O_WRONLY);
+		if(devNull >= 0)
+		{
+			dup2(devNull, STDOUT_FILENO);
+			close(devNull);
+		}
+		execl(accordName, accordName, configName, seedString, (char *) NULL);
+		fprintf(stderr, "ERROR: Cannot run \"%s\".\n", accordName);
+		_exit(127);
+	}
+	if(wait4(pid, &status, 0, &usage) != pid
+		|| !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+	{
+		fprintf(stderr, "ERROR: Simulation of \"%s\" failed.\n", configName);
+		exit(EXIT_FAILURE);
+	}
+	*wallTime = wallNow() - startTime;
+	*peakRSS = (uint64_t) usage.ru_maxrss * 1024; // ru_maxrss is in kB
+}
+
+// Read the profile counters from the summary file of a simulation
+static void readSummary(const char * outputName,
+	struct benchResult * result)
+{
+	char * summaryName, * summaryText;
+	const char * summaryEnd;
+	cJSON * summaryStart, * summary, * profile, * phase, * counter;
+
+	summaryName = malloc(strlen(outputName) + 13);
+	if(summaryName == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation for summary name.\n");
+		exit(EXIT_FAILURE);
+	}
+	sprintf(summaryName, "%s_summary.txt", outputName);
+	summaryText = readTextFile(summaryName);
+	if(summaryText == NULL)
+	{
+		fprintf(stderr, "ERROR: Cannot read \"%s\".\n", summaryName);
+		exit(EXIT_FAILURE);
+	}
+
+	// Summary file has 2 JSON objects. "Profile" is in the second
+	summaryStart = cJSON_ParseWithOpts(summaryText, &summaryEnd, 0);
+	summary = (summaryStart == NULL) ? NULL : cJSON_Parse(summaryEnd);
+	profile = (summary == NULL) ? NULL : cJSON_GetObjectItem(summary, "Profile");
+	if(profile == NULL)
+	{
+		fprintf(stderr, "ERROR: \"%s\" has no \"Profile\". AcCoRD must be built with -DACCORD_PROFILE.\n",
+			summaryName);
+		exit(EXIT_FAILURE);
+	}
+	phase = cJSON_GetObjectItem(profile, "Phase");
+	counter = cJSON_GetObjectItem(profile, "Counter");
+	result->numMicroMolStep =
+		(uint64_t) readNumber(counter, "MicroMolStep", summaryName);
+	result->numMesoEvent = (uint64_t)
+		(readNumber(cJSON_GetObjectItem(phase, "MesoDiffusion"), "Count", summaryName)
+		+ readNumber(cJSON_GetObjectItem(phase, "MesoChemRxn"), "Count", summaryName));
+
+	cJSON_Delete(summary);
+	cJSON_Delete(summaryStart);
+	free(summaryText);
+	free(summaryName);
+}
+
+// Find a number in a JSON object or exit with an error
+static double readNumber(cJSON * obj,
+	const char * name,
+	const char * fileName)
+{
+	cJSON * item = (obj == NULL) ? NULL : cJSON_GetObjectItem(obj, name);
+
+	if(item == NULL || item->type != cJSON_Number)
+	{
+		fprintf(stderr, "ERROR: \"%s\" is missing from \"%s\".\n", name, fileName);
+		exit(EXIT_FAILURE);
+	}
+	return item->valuedouble;
+}
+
+// Find the size of the output file of a simulation
+static uint64_t findOutputBytes(const char * outputName)
+{
+	char * fileName;
+	struct stat fileStat;
+	uint64_t numBytes = 0;
+
+	fileName = malloc(strlen(outputName) + 8);
+	if(fileName == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation for output name.\n");
+		exit(EXIT_FAILURE);
+	}
+	sprintf(fileName, "%s.txt", outputName);
+	if(stat(fileName, &fileStat) == 0)
+		numBytes = (uint64_t) fileStat.st_size;
+	else
+	{ // Output may be compressed
+		strcat(fileName, ".gz");
+		if(stat(fileName, &fileStat) == 0)
+			numBytes = (uint64_t) fileStat.st_size;
+	}
+	free(fileName);
+	return numBytes;
+}
+
+// Create the JSON object with the metrics of one benchmark
+static cJSON * createResultJSON(const char * name,
+	const struct benchResult * result)
+{
+	cJSON * obj = cJSON_CreateObject();
+
+	cJSON_AddStringToObject(obj, "Name", name);
+	cJSON_AddNumberToObject(obj, "WallTime", result->wallTime);
+	cJSON_AddNumberToObject(obj, "MicroMolStep", (double) result->numMicroMolStep);
+	cJSON_AddNumberToObject(obj, "MicroMolStepRate",
+		(double) result->numMicroMolStep / result->wallTime);
+	cJSON_AddNumberToObject(obj, "MesoEvent", (double) result->numMesoEvent);
+	cJSON_AddNumberToObject(obj, "MesoEventRate",
+		(double) result->numMesoEvent / result->wallTime);
+	cJSON_AddNumberToObject(obj, "PeakRSS", (double) result->peakRSS);
+	cJSON_AddNumberToObject(obj, "OutputBytes", (double) result->outputBytes);
+	return obj;
+}
+
+// Compare the metrics of one benchmark with its baseline. Add the relative
+// changes to the benchmark's object and the names of regressions to the array.
+// Returns the number of regressions
+static unsigned int compareWithBaseline(cJSON * curBench,
+	cJSON * baseBench,
+	const double tolerance,
+	cJSON * regressions)
+{
+	unsigned short i;
+	unsigned int numRegression = 0;
+	cJSON * changeObj, * curItem, * baseItem;
+	double change;
+	char * regressionName;
+	const char * benchName = cJSON_GetObjectItem(curBench, "Name")->valuestring;
+
+	cJSON_AddItemToObject(curBench, "Change", changeObj = cJSON_CreateObject());
+	for(i = 0; i < NUM_METRIC; i++)
+	{
+		curItem = cJSON_GetObjectItem(curBench, METRIC_NAME[i]);
+		baseItem = cJSON_GetObjectItem(baseBench, METRIC_NAME[i]);
+		if(baseItem == NULL || baseItem->type != cJSON_Number
+			|| baseItem->valuedouble <= 0.)
+			continue; // Metric does not apply to benchmark
+
+		change = curItem->valuedouble / baseItem->valuedouble - 1.;
+		cJSON_AddNumberToObject(changeObj, METRIC_NAME[i], change);
+		if(METRIC_HIGHER_BETTER[i])
+			change = -change; // Positive change is now worse
+		if(change > tolerance)
+		{
+			regressionName = malloc(strlen(benchName) + strlen(METRIC_NAME[i]) + 2);
+			if(regressionName == NULL)
+			{
+				fprintf(stderr, "ERROR: Memory allocation for regression name.\n");
+				exit(EXIT_FAILURE);
+			}
+			sprintf(regressionName, "%s.%s", benchName, METRIC_NAME[i]);
+			cJSON_AddItemToArray(regressions, cJSON_CreateString(regressionName));
+			free(regressionName);
+			numRegression++;
+		}
+	}
+	return numRegression;
+}
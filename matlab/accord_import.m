@@ -33,6 +33,9 @@ function [data, config] = accord_import(fileName, seedRange, bWrite)
 % Revision LATEST_RELEASE
 % - added bWrite input argument to control whether output is saved to
 % mat-file
+% - added reading of compressed output files
+% - added decoding of quantized molecule positions
+% - added import of absorbed molecule counts
 %
 % Revision v0.4.1
 % - changed output filename convention and location for increased
@@ -111,6 +114,10 @@ data.numPassiveRecord = summary{2}.NumberPassiveRecord;
 data.passiveRecordID = zeros(1,data.numPassiveRecord);
 data.passiveRecordBTime = zeros(1,data.numPassiveRecord);
 data.passiveRecordMaxCountLength = zeros(1,data.numPassiveRecord);
+data.passiveRecordBAbsorb = zeros(1,data.numPassiveRecord);
+data.passiveRecordMaxAbsorbCount = zeros(1,data.numPassiveRecord);
+data.passiveRecordAbsorbCount = cell(1,data.numPassiveRecord);
+data.passiveRecordAbsorbTime = cell(1,data.numPassiveRecord);
 passiveDoubleStr = cell(1,data.numPassiveRecord);
 passiveCountStr = cell(1,data.numPassiveRecord);
 data.passiveRecordNumMolType = zeros(1,data.numPassiveRecord);
@@ -119,10 +126,24 @@ data.passiveRecordBPos = cell(1,data.numPassiveRecord);
 data.passiveRecordTime = cell(1,data.numPassiveRecord);
 data.passiveRecordCount = cell(1,data.numPassiveRecord);
 data.passiveRecordPos = cell(1,data.numPassiveRecord);
+data.passiveRecordPosRes = zeros(1,data.numPassiveRecord);
+data.passiveRecordPosOrigin = zeros(data.numPassiveRecord,3);
 for i = 1:data.numPassiveRecord
     data.passiveRecordID(i) = summary{2}.RecordInfo(i).ID;
     data.passiveRecordBTime(i) = summary{2}.RecordInfo(i).bRecordTime;
     data.passiveRecordMaxCountLength(i) = summary{2}.RecordInfo(i).MaxCountLength;
+    if isfield(summary{2}.RecordInfo(i), 'MaxAbsorbCount')
+        % Actor records the molecules that it absorbs
+        data.passiveRecordBAbsorb(i) = summary{2}.RecordInfo(i).bRecordAbsorb;
+        data.passiveRecordMaxAbsorbCount(i) = summary{2}.RecordInfo(i).MaxAbsorbCount;
+    end
+    if isfield(summary{2}.RecordInfo(i), 'PositionResolution') ...
+            && summary{2}.RecordInfo(i).PositionResolution > 0
+        % Positions are quantized to a grid
+        data.passiveRecordPosRes(i) = summary{2}.RecordInfo(i).PositionResolution;
+        data.passiveRecordPosOrigin(i,:) = ...
+            summary{2}.RecordInfo(i).PositionOriginCell * data.passiveRecordPosRes(i);
+    end
     passiveDoubleStr{i} = repmat('%f',1,data.passiveRecordMaxCountLength(i));
     passiveCountStr{i} = repmat('%u64',1,data.passiveRecordMaxCountLength(i));
     data.passiveRecordNumMolType(i) = summary{2}.RecordInfo(i).NumMolTypeObs;
@@ -135,10 +156,20 @@ for i = 1:data.numPassiveRecord
     data.passiveRecordCount{i} = zeros(data.numRepeat,data.passiveRecordNumMolType(i),...
         data.passiveRecordMaxCountLength(i));
     data.passiveRecordPos{i} = cell(1,data.passiveRecordNumMolType(i));
+    if data.passiveRecordBAbsorb(i)
+        data.passiveRecordAbsorbCount{i} = zeros(data.numRepeat,data.passiveRecordNumMolType(i));
+        data.passiveRecordAbsorbTime{i} = cell(1,data.passiveRecordNumMolType(i));
+    end
     for j = 1:data.passiveRecordNumMolType(i)
         data.passiveRecordMolID{i}(j) = summary{2}.RecordInfo(i).MolObsID(j);
         data.passiveRecordBPos{i}(j) = summary{2}.RecordInfo(i).bRecordPos(j);
-        if data.passiveRecordBPos{i}(j)
+        if data.passiveRecordBAbsorb(i)
+            % Absorption times and positions have one entry per realization
+            data.passiveRecordAbsorbTime{i}{j} = cell(data.numRepeat,1);
+            if data.passiveRecordBPos{i}(j)
+                data.passiveRecordPos{i}{j} = cell(data.numRepeat,1);
+            end
+        elseif data.passiveRecordBPos{i}(j)
             data.passiveRecordPos{i}{j} = cell(data.numRepeat,data.passiveRecordMaxCountLength(i));
         end
     end
@@ -150,7 +181,15 @@ end
 curReal = 1;
 for s = 1:data.numSeed
     seed = seedRange(s);
-    fid = fopen([fileName '_SEED' num2str(seed) '.txt']);
+    if isfield(summary{1}, 'OutputCodec') ...
+            && strcmp(summary{1}.OutputCodec, 'Deflate')
+        % Output is compressed. Decompress a temporary copy
+        outFile = gunzip([fileName '_SEED' num2str(seed) '.txt.gz'], tempdir);
+        fid = fopen(outFile{1});
+    else
+        outFile = {};
+        fid = fopen([fileName '_SEED' num2str(seed) '.txt']);
+    end
     for r = 1:data.numRepeatSingle
         % Read in realization line
         textscan(fid, '%*[^\n]', 1);
@@ -165,6 +204,44 @@ for s = 1:data.numSeed
         for i = 1:data.numPassiveRecord
             % Scan in passive actor label line
             textscan(fid, '%*[^\n]', 1);
+            if data.passiveRecordBAbsorb(i)
+                % Actor lists the molecules that it absorbed
+                for j = 1:data.passiveRecordNumMolType(i)
+                    % Read in molecule type line AND absorption count label line
+                    textscan(fid, '%*[^\n]', 2);
+                    % Read in number of absorbed molecules
+                    content = textscan(fid, '%u64', 1, 'CollectOutput',1);
+                    numAbsorb = double(content{1});
+                    data.passiveRecordAbsorbCount{i}(curReal,j) = numAbsorb;
+                    % Read in absorption time label
+                    textscan(fid, '%*[^\n]', 1);
+                    % Read in absorption times
+                    data.passiveRecordAbsorbTime{i}{j}{curReal} = zeros(numAbsorb,1);
+                    if numAbsorb > 0
+                        content = textscan(fid, '%f', numAbsorb, 'CollectOutput',1);
+                        data.passiveRecordAbsorbTime{i}{j}{curReal} = content{1};
+                    end
+                    if data.passiveRecordBPos{i}(j)
+                        % Positions are being recorded. Read in Position label
+                        textscan(fid, '%*[^\n]', 1);
+                        data.passiveRecordPos{i}{j}{curReal} = zeros(numAbsorb,3);
+                        % Read in opening round bracket of position list
+                        textscan(fid, '%*[(]', 1);
+                        for l = 1:numAbsorb
+                            % Scan to start of coordinate
+                            textscan(fid, '%*[(]', 1);
+                            % Read in coordinates of current molecule
+                            content = textscan(fid, '%f', 3, 'CollectOutput',1,'Delimiter',',');
+                            data.passiveRecordPos{i}{j}{curReal}(l,:) = content{:};
+                            % Scan to start of coordinate
+                            textscan(fid, '%*[)]', 1);
+                        end
+                        % Scan in next newline
+                        textscan(fid, '%*[^\n]', 1);
+                    end
+                end
+                continue;
+            end
             if data.passiveRecordBTime(i)
                 % Time is being recorded. Read in time label
                 textscan(fid, '%*[^\n]', 1);
@@ -186,6 +263,18 @@ for s = 1:data.numSeed
                         % Read in opening round bracket associated with
                         % current count
                         textscan(fid, '%*[(]', 1);
+                        if data.passiveRecordPosRes(i) > 0 ...
+                                && data.passiveRecordCount{i}(curReal,j,k) > 0
+                            % Read in differences between grid cell codes
+                            content = textscan(fid, '%u64', ...
+                                data.passiveRecordCount{i}(curReal,j,k), 'CollectOutput',1);
+                            data.passiveRecordPos{i}{j}{curReal,k} = ...
+                                decodePosition(cumsum(content{1}), ...
+                                data.passiveRecordPosOrigin(i,:), data.passiveRecordPosRes(i));
+                            % Scan in next newline
+                            textscan(fid, '%*[^\n]', 1);
+                            continue;
+                        end
                         for l = 1:data.passiveRecordCount{i}(curReal,j,k)
                             % Scan to start of coordinate
                             textscan(fid, '%*[(]', 1);
@@ -204,10 +293,28 @@ for s = 1:data.numSeed
         curReal = curReal + 1;
     end
     fclose(fid);
+    if ~isempty(outFile)
+        delete(outFile{1});
+    end
 end
 
 %% Write output to a .mat file
 if bWrite
     [~,configName,~] = fileparts(data.configName);
     save([configName '_out'], 'data', 'config');
+end
+
+end
+
+function coor = decodePosition(key, origin, res)
+% Convert the Morton codes of grid cells to the coordinates of the cell
+% centres. Bit 3*b+d of a code is bit b of the cell index along dimension d
+coor = zeros(length(key),3);
+for d = 1:3
+    idx = zeros(length(key),1);
+    for b = 0:20
+        idx = idx + double(bitand(bitshift(key, -(3*b+d-1)), uint64(1))) * 2^b;
+    end
+    coor(:,d) = origin(d) + (idx + 0.5) * res;
+end
 end
\ No newline at end of file
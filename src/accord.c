@@ -9,10 +9,29 @@
  *
  * accord.c - main file
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added advection of microscopic molecules by a region flow field that is read from a
+ * memory-mapped velocity grid
+ * - indexed the timer heap with 32-bit IDs and stored the keys inline
+ * - batched passive actor observations that occur at the same time
+ * - shared one count of each region's molecules among the passive actors that contain
+ * the region
+ * - drew the observations of partial mesoscopic subvolumes from a binomial distribution
+ * - recorded observed molecule positions in a coordinate buffer of each passive actor
+ * - added logging of molecules captured by absorbing and receptor surfaces
+ * - wrote realization output on a separate thread
+ * - added optional deflate compression of the output file
+ * - added quantized and delta-encoded recording of molecule positions
+ * - added opt-in profiling of simulation phases
+ * - added periodic telemetry records
+ * - allocated observations from an arena of each list that is reset every realization
+ * - added optional cache of subvolume neighbours on disk
+ * - added seed and parameter sweeps that run in one process
+ *
  * Revision v0.5 (2016-04-15)
  * - corrected display of simulation end time
  * - added display of initialization start time
@@ -57,33 +76,62 @@
 #include "timer_accord.h" // for timer creation and sorting
 #include "global_param.h" // for common global parameters
 #include "file_io.h" // For I/O with config and output files
+#include "output_writer.h" // For writing output while simulating
+#include "profile.h" // For optional measurement of simulation phases
+#include "telemetry.h" // For periodic records of simulation progress
+#include "geometry_cache.h" // For re-use of subvolume neighbours between runs
 const char CONFIG_NAME[] = "accord_config_sample.txt"; // TEMP - will be loaded from input
 
-int main(int argc, char *argv[]) {
-	int i, j; // generic indices
-	uint64_t k;
+// Environment that is built once and shared by every simulation of a
+// configuration (i.e., of a sweep)
+struct environment3D {
+	struct region * regionArray;
 	uint32_t numSub; // Total number of subvolumes in system
-	uint32_t curSub; // Index of subvolume where next reaction occurs
-	uint32_t curSubID; // Current subvolume in actor list
-	uint32_t destSub; // Index of destination subvolume (for diffusion)
-	uint32_t destMeso; // Index of destination in mesoscopic list
-	unsigned short curRegion; // Region of current subvolume
-	unsigned short destRegion; // Region of destination subvolume (for diffusion)
-	unsigned short curRegionID; // Current region in actor list
-	unsigned short faceDir; // Index in direction array to place molecule
-	// (from micro to meso)
-	unsigned int curRepeat; // Current simulation realization
-	double tCur; // Current overall simulation time
-	double tMeso, tMicro; // MESO and MICRO regime simulation times
-	double point[3]; // Coordinates of new micro molecules created by 0th order rxn
-	bool bNeedPoint; // Need to keep looking for a valid micro location
+	struct subvolume3D * subvolArray;
+	uint32_t (*subCoorInd)[3]; // List (within region) index coordinates for each subvolume
+	uint32_t **** subID; // Subvolume indices in master list
+	uint32_t (**subIDSize)[2]; // Reader array for subID
+	uint32_t numMesoSub;
+	struct mesoSubvolume3D * mesoSubArray;
+	uint32_t * heap_subvolID;
+	uint32_t (*heap_childID)[2];
+	bool (*b_heap_childValid)[2];
+	unsigned int num_heap_levels;
+	short NUM_ACTORS_ACTIVE, NUM_ACTORS_PASSIVE;
+	short numActorRecord;
+	short * actorRecordID; // Array of IDs of actors whose observations are recorded
+	struct actorStruct3D * actorCommonArray;
+	struct actorActiveStruct3D * actorActiveArray;
+	struct actorPassiveStruct3D * actorPassiveArray;
+	struct observerMap * observerMapArray;
+};
 
-	// Timer and progress variables
+// Build the regions, subvolumes and actors of a configuration
+static void buildEnvironment(struct simSpec3D spec,
+		struct environment3D * env);
+
+// Recalculate the parts of the environment that depend on parameters that
+// can change between the simulations of a sweep
+static void resetEnvironment(struct simSpec3D spec,
+		struct environment3D * env);
+
+// Free the memory of the environment
+static void deleteEnvironment(struct simSpec3D spec,
+		struct environment3D * env);
+
+// Run one simulation of a configuration in an environment that was already
+// built
+static void runSimulation(struct simSpec3D spec, const char * configName,
+		struct environment3D * env);
+
+int main(int argc, char *argv[]) {
+	unsigned int numRun, curRun; // Simulations in sweep of configuration
+	struct environment3D env; // Environment shared by simulations
+
+	// Timer variables
 	time_t timer;
 	char timeBuffer[26]; // Array for clock time
 	struct tm* timeInfo; // Stucture of timer info
-	unsigned int updateFreq;
-	double fracComplete;
 
 	printf("AcCoRD (Actor-based Communication via Reaction-Diffusion)\n");
 	printf("Version v0.5 (2016-04-15) (public beta)\n");
@@ -121,57 +169,39 @@ int main(int argc, char *argv[]) {
 		loadConfig(CONFIG_NAME, 0, &spec);
 	}
 
-	uint64_t numMolChange[spec.NUM_MOL_TYPES]; // Number of molecules changed by mesoscopic event
-	for (i = 0; i < spec.NUM_MOL_TYPES; i++)
-		numMolChange[i] = 0; // Initialize elements to 0
-	bool bTrue[spec.NUM_MOL_TYPES]; // Array of all true values
-	bool bFalse[spec.NUM_MOL_TYPES];
-	for (i = 0; i < spec.NUM_MOL_TYPES; i++) {
-		bTrue[i] = true;
-		bFalse[i] = false;
-	}
+	// Build the environment with the parameters of the first simulation
+	numRun = numSweepRun(&spec);
+	applySweepRun(&spec, 0);
+	buildEnvironment(spec, &env);
 
-	// MESO parameters
-	uint32_t numMesoSub;
-	uint32_t curMeso;
-	double new_time, old_prop, old_time;
-	double prop_sum, rand_prop;
-	unsigned short curRxn; // Index of current reaction to fire
-	uint64_t numMesoSteps;
-	unsigned short curMolType; // Current type of molecule diffusing
-
-	// MICRO parameters
-	ListMol3D microMolList[spec.NUM_REGIONS][spec.NUM_MOL_TYPES];
-	ListMolRecent3D microMolListRecent[spec.NUM_REGIONS][spec.NUM_MOL_TYPES]; // For molecules created at
-	// at an arbitrary time
-	for (i = 0; i < spec.NUM_REGIONS; i++) {
-		for (j = 0; j < spec.NUM_MOL_TYPES; j++) {
-			initializeListMol(&microMolList[i][j]);
-			initializeListMolRecent(&microMolListRecent[i][j]);
+	// Run every simulation of the sweep (only one if there is no sweep)
+	for (curRun = 0; curRun < numRun; curRun++) {
+		if (curRun > 0) {
+			applySweepRun(&spec, curRun);
+			resetEnvironment(spec, &env);
 		}
+		if (numRun > 1)
+			printf("\nStarting simulation %u of %u in sweep (\"%s\").\n",
+					curRun + 1, numRun, spec.OUTPUT_NAME);
+		runSimulation(spec, (argc > 1) ? argv[1] : CONFIG_NAME, &env);
 	}
-	double micro_sigma[spec.NUM_REGIONS][spec.NUM_MOL_TYPES];
-	double delta_flow[spec.NUM_REGIONS];
-	uint64_t curMol;
-	uint64_t numMol;
-	unsigned short curZerothRxn, curFirstRxn, curSecondRxn;
-	bool bCheckCount;
-	uint32_t numMicroMolCheck[spec.NUM_MOL_TYPES];
-	uint32_t sumMicroMolCheck;
+	deleteEnvironment(spec, &env);
 
-	// Hybrid parameters
-	uint32_t curBoundSub; // Index of subvolume in region boundary list
+	deleteConfig(spec);
 
-	// Actor parameters
-	short NUM_ACTORS_ACTIVE, NUM_ACTORS_PASSIVE;
-	short curActor, curPassive, curActive;
-	unsigned short curMolPassive;
-	short numActorRecord, curActorRecord;
-	short curActorRecordID;
-	short * actorRecordID; // Array of IDs of actors whose observations are recorded
-						   // TODO: Should these IDs be from actor list or passive list?
+	printf("Done!");
+	return 0;
+}
 
-	clock_t startTime, endTime; // Time record keeping
+// Build the regions, subvolumes and actors of a configuration
+static void buildEnvironment(struct simSpec3D spec,
+		struct environment3D * env) {
+	int i, j; // generic indices
+	uint32_t numSub; // Total number of subvolumes in system
+	uint32_t numMesoSub;
+	short NUM_ACTORS_ACTIVE, NUM_ACTORS_PASSIVE;
+	short numActorRecord;
+	short * actorRecordID;
 
 	double DIFF_COEF[spec.NUM_REGIONS][spec.NUM_MOL_TYPES];
 	for (i = 0; i < spec.NUM_REGIONS; i++) {
@@ -180,22 +210,14 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
-	//
-	// STEP 2: Validate Configuration
-	//
-
-	//
-	// STEP 3: Initialize Simulation Environment
-	//
-
-	//
-	// 3-A Initialize Mesoscopic Environment
-	//
-
 	// Initialize array of region information
 	printf("Initializing region parameters.\n");
 	printf("Number of regions: %u\n", spec.NUM_REGIONS);
-	struct region regionArray[spec.NUM_REGIONS];
+	struct region * regionArray = malloc(spec.NUM_REGIONS * sizeof(struct region));
+	if (regionArray == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation for region parameters.\n");
+		exit(EXIT_FAILURE);
+	}
 	initializeRegionArray(regionArray, spec.subvol_spec, spec.NUM_REGIONS,
 			spec.NUM_MOL_TYPES, spec.SUBVOL_BASE_SIZE, DIFF_COEF, spec.MAX_RXNS,
 			spec.chem_rxn);
@@ -208,6 +230,7 @@ int main(int argc, char *argv[]) {
 	allocateSubvolArray(numSub, &subvolArray);
 
 	// Allocate temporary arrays for managing subvolume validity and placement
+	// (kept to recalculate diffusion rates for later simulations of a sweep)
 	uint32_t (*subCoorInd)[3]; // List (within region) index coordinates for each subvolume
 	uint32_t **** subID; // Subvolume indices in master list
 	uint32_t (**subIDSize)[2]; // Reader array for subID
@@ -218,10 +241,18 @@ int main(int argc, char *argv[]) {
 	//deleteSubvolHelper(subCoorInd, subID, subIDSize, spec.NUM_REGIONS, regionArray);
 	//allocateSubvolHelper(numSub, &subCoorInd, &subID, &subIDSize, spec.NUM_REGIONS, regionArray);
 
+	// Read subvolume neighbours found by a previous run of the same environment
+	struct geometryCache geomCache;
+	initializeGeometryCache(&geomCache, spec.GEOMETRY_CACHE_DIR,
+			spec.NUM_REGIONS, spec.subvol_spec, spec.SUBVOL_BASE_SIZE, numSub);
+
 	// Build subvolume array from subvolume specifications
 	buildSubvolArray(numSub, &numMesoSub, subvolArray, spec.subvol_spec,
 			regionArray, spec.NUM_REGIONS, spec.NUM_MOL_TYPES, spec.MAX_RXNS,
-			spec.SUBVOL_BASE_SIZE, DIFF_COEF, subCoorInd, subID, subIDSize);
+			spec.SUBVOL_BASE_SIZE, DIFF_COEF, subCoorInd, subID, subIDSize,
+			geomCache.numNeigh, geomCache.neighID);
+	saveGeometryCache(&geomCache, numSub, subvolArray);
+	deleteGeometryCache(&geomCache);
 
 	// Determine rates associated with chemical reaction events
 	// Record dependencies (i.e., if a given rxn fires, what propensities need to be updated?)
@@ -268,25 +299,225 @@ int main(int argc, char *argv[]) {
 	printf("Number of active actors: %u\n", NUM_ACTORS_ACTIVE);
 	printf("Number of passive actors: %u\n", NUM_ACTORS_PASSIVE);
 
+	// Map passive actors to the microscopic regions that they observe
+	struct observerMap * observerMapArray;
+	initializeObserverMap(spec.NUM_REGIONS, spec.NUM_MOL_TYPES, regionArray,
+			actorCommonArray, NUM_ACTORS_PASSIVE, actorPassiveArray,
+			&observerMapArray);
+
+	// Keep the environment for every simulation
+	env->regionArray = regionArray;
+	env->numSub = numSub;
+	env->subvolArray = subvolArray;
+	env->subCoorInd = subCoorInd;
+	env->subID = subID;
+	env->subIDSize = subIDSize;
+	env->numMesoSub = numMesoSub;
+	env->mesoSubArray = mesoSubArray;
+	env->heap_subvolID = heap_subvolID;
+	env->heap_childID = heap_childID;
+	env->b_heap_childValid = b_heap_childValid;
+	env->num_heap_levels = num_heap_levels;
+	env->NUM_ACTORS_ACTIVE = NUM_ACTORS_ACTIVE;
+	env->NUM_ACTORS_PASSIVE = NUM_ACTORS_PASSIVE;
+	env->numActorRecord = numActorRecord;
+	env->actorRecordID = actorRecordID;
+	env->actorCommonArray = actorCommonArray;
+	env->actorActiveArray = actorActiveArray;
+	env->actorPassiveArray = actorPassiveArray;
+	env->observerMapArray = observerMapArray;
+}
+
+// Recalculate the parts of the environment that depend on parameters that
+// can change between the simulations of a sweep
+static void resetEnvironment(struct simSpec3D spec,
+		struct environment3D * env) {
+	int i, j; // generic indices
+
+	double DIFF_COEF[spec.NUM_REGIONS][spec.NUM_MOL_TYPES];
+	for (i = 0; i < spec.NUM_REGIONS; i++) {
+		for (j = 0; j < spec.NUM_MOL_TYPES; j++) {
+			DIFF_COEF[i][j] = spec.DIFF_COEF[j];
+		}
+	}
+
+	// Diffusion and reaction rates
+	resetRegionRates(env->regionArray, spec.NUM_REGIONS, spec.NUM_MOL_TYPES,
+			DIFF_COEF, spec.MAX_RXNS, spec.chem_rxn);
+	if (spec.NUM_REGIONS > 1)
+		findSubvolDiffRate(env->numSub, env->subvolArray, env->regionArray,
+				spec.NUM_REGIONS, spec.NUM_MOL_TYPES, spec.SUBVOL_BASE_SIZE,
+				DIFF_COEF, env->subCoorInd);
+
+	// Actor modulation strengths and start times, and positions in bit
+	// sequences
+	resetActorParam(spec.NUM_ACTORS, env->actorCommonArray, spec.actorSpec,
+			env->NUM_ACTORS_ACTIVE, env->actorActiveArray);
+}
+
+// Free the memory of the environment
+static void deleteEnvironment(struct simSpec3D spec,
+		struct environment3D * env) {
 	// Delete temporary arrays for managing subvolume validity and placement
-	deleteSubvolHelper(subCoorInd, subID, subIDSize, spec.NUM_REGIONS,
-			regionArray);
+	deleteSubvolHelper(env->subCoorInd, env->subID, env->subIDSize,
+			spec.NUM_REGIONS, env->regionArray);
+
+	deleteObserverMap(spec.NUM_REGIONS, env->observerMapArray);
+	deleteActor(spec.NUM_ACTORS, env->actorCommonArray, env->regionArray,
+			env->NUM_ACTORS_ACTIVE, env->actorActiveArray,
+			env->NUM_ACTORS_PASSIVE, env->actorPassiveArray,
+			env->actorRecordID);
+	heapMesoDelete(env->numSub, env->heap_subvolID, env->heap_childID,
+			env->b_heap_childValid);
+	deleteSubvolArray(env->numSub, env->subvolArray, spec.NUM_MOL_TYPES,
+			spec.NUM_REGIONS, env->regionArray);
+	deleteMesoSubArray(env->numMesoSub, env->mesoSubArray);
+	delete_boundary_region_(spec.NUM_REGIONS, spec.NUM_MOL_TYPES,
+			env->regionArray);
+	free(env->regionArray);
+}
 
-	ListMol3D molListPassive3D[spec.NUM_MOL_TYPES];
-	for (j = 0; j < spec.NUM_MOL_TYPES; j++) {
-		initializeListMol(&molListPassive3D[j]);
+static void runSimulation(struct simSpec3D spec, const char * configName,
+		struct environment3D * env) {
+	int i, j; // generic indices
+	uint64_t k;
+	uint32_t numSub; // Total number of subvolumes in system
+	uint32_t curSub; // Index of subvolume where next reaction occurs
+	uint32_t curSubID; // Current subvolume in actor list
+	uint32_t destSub; // Index of destination subvolume (for diffusion)
+	uint32_t destMeso; // Index of destination in mesoscopic list
+	unsigned short curRegion; // Region of current subvolume
+	unsigned short destRegion; // Region of destination subvolume (for diffusion)
+	unsigned short curRegionID; // Current region in actor list
+	unsigned short faceDir; // Index in direction array to place molecule
+	// (from micro to meso)
+	unsigned int curRepeat; // Current simulation realization
+	double tCur; // Current overall simulation time
+	double tMeso, tMicro; // MESO and MICRO regime simulation times
+	double point[3]; // Coordinates of new micro molecules created by 0th order rxn
+	double * molPosCoor; // Coordinates of molecules observed in meso subvolume
+	bool bNeedPoint; // Need to keep looking for a valid micro location
+
+	// Timer and progress variables
+	time_t timer;
+	char timeBuffer[26]; // Array for clock time
+	struct tm* timeInfo; // Stucture of timer info
+	unsigned int updateFreq;
+	double fracComplete;
+
+	PROFILE_CLEAR();
+
+	uint64_t numMolChange[spec.NUM_MOL_TYPES]; // Number of molecules changed by mesoscopic event
+	for (i = 0; i < spec.NUM_MOL_TYPES; i++)
+		numMolChange[i] = 0; // Initialize elements to 0
+	bool bTrue[spec.NUM_MOL_TYPES]; // Array of all true values
+	bool bFalse[spec.NUM_MOL_TYPES];
+	for (i = 0; i < spec.NUM_MOL_TYPES; i++) {
+		bTrue[i] = true;
+		bFalse[i] = false;
 	}
 
+	// MESO parameters
+	uint32_t numMesoSub;
+	uint32_t curMeso;
+	double new_time, old_prop, old_time;
+	double prop_sum, rand_prop;
+	unsigned short curRxn; // Index of current reaction to fire
+	uint64_t numMesoSteps;
+	unsigned short curMolType; // Current type of molecule diffusing
+
+	// MICRO parameters
+	ListMol3D microMolList[spec.NUM_REGIONS][spec.NUM_MOL_TYPES];
+	ListMolRecent3D microMolListRecent[spec.NUM_REGIONS][spec.NUM_MOL_TYPES]; // For molecules created at
+	// at an arbitrary time
+	for (i = 0; i < spec.NUM_REGIONS; i++) {
+		for (j = 0; j < spec.NUM_MOL_TYPES; j++) {
+			initializeListMol(&microMolList[i][j]);
+			initializeListMolRecent(&microMolListRecent[i][j]);
+		}
+	}
+	double micro_sigma[spec.NUM_REGIONS][spec.NUM_MOL_TYPES];
+	double delta_flow[spec.NUM_REGIONS];
+	uint64_t curMol;
+	uint64_t numMol;
+	unsigned short curZerothRxn, curFirstRxn, curSecondRxn;
+	bool bCheckCount;
+	uint32_t numMicroMolCheck[spec.NUM_MOL_TYPES];
+	uint32_t sumMicroMolCheck;
+
+	// Hybrid parameters
+	uint32_t curBoundSub; // Index of subvolume in region boundary list
+
+	// Actor parameters
+	short NUM_ACTORS_ACTIVE, NUM_ACTORS_PASSIVE;
+	short curActor, curPassive, curActive;
+	unsigned short curMolPassive;
+	short numActorRecord, curActorRecord;
+	short curActorRecordID;
+	short numPassiveBatch, curBatch; // Passive actors observing at the same time
+	short * actorRecordID; // Array of IDs of actors whose observations are recorded
+						   // TODO: Should these IDs be from actor list or passive list?
+
+	clock_t startTime, endTime; // Time record keeping
+
+	double DIFF_COEF[spec.NUM_REGIONS][spec.NUM_MOL_TYPES];
+	for (i = 0; i < spec.NUM_REGIONS; i++) {
+		for (j = 0; j < spec.NUM_MOL_TYPES; j++) {
+			DIFF_COEF[i][j] = spec.DIFF_COEF[j];
+		}
+	}
+
+	//
+	// STEP 2: Validate Configuration
+	//
+
+	//
+	// STEP 3: Initialize Simulation Environment
+	//
+
+	//
+	// 3-A Initialize Mesoscopic Environment
+	//
+
+	// Use the regions, subvolumes and actors built for every simulation
+	struct region * regionArray = env->regionArray;
+	numSub = env->numSub;
+	struct subvolume3D * subvolArray = env->subvolArray;
+	numMesoSub = env->numMesoSub;
+	struct mesoSubvolume3D * mesoSubArray = env->mesoSubArray;
+	uint32_t * heap_subvolID = env->heap_subvolID;
+	uint32_t (*heap_childID)[2] = env->heap_childID;
+	bool (*b_heap_childValid)[2] = env->b_heap_childValid;
+	unsigned int num_heap_levels = env->num_heap_levels;
+	NUM_ACTORS_ACTIVE = env->NUM_ACTORS_ACTIVE;
+	NUM_ACTORS_PASSIVE = env->NUM_ACTORS_PASSIVE;
+	numActorRecord = env->numActorRecord;
+	actorRecordID = env->actorRecordID;
+	struct actorStruct3D * actorCommonArray = env->actorCommonArray;
+	struct actorActiveStruct3D * actorActiveArray = env->actorActiveArray;
+	struct actorPassiveStruct3D * actorPassiveArray = env->actorPassiveArray;
+	struct observerMap * observerMapArray = env->observerMapArray;
+	short passiveBatch[NUM_ACTORS_PASSIVE + 1]; // IDs of passive actors observing together
+
+	// Log molecules captured by surfaces in the regions of actors that record them
+	struct captureLog3D captureLog;
+	initializeCaptureLog(spec.NUM_REGIONS, &captureLog);
+	bool bLogCapture = findCaptureLogRegions(NUM_ACTORS_PASSIVE,
+			actorCommonArray, actorPassiveArray, &captureLog);
+
 	// Create arrays to store the maximum number of bits of each
-	// active actor and each recorded passive actor.
+	// active actor and each recorded passive actor, and the maximum
+	// number of molecules absorbed by each recorded absorbing actor.
 	// Will be appended to output file to assist importing into Matlab
 	uint32_t maxActiveBits[NUM_ACTORS_ACTIVE];
 	uint32_t maxPassiveObs[numActorRecord];
+	uint32_t maxAbsorbCount[numActorRecord];
 
 	// Create array of linked lists for recording actor observations
 	ListObs3D observationArray[numActorRecord];
 	for (curActor = 0; curActor < numActorRecord; curActor++) {
 		maxPassiveObs[curActor] = 0;
+		maxAbsorbCount[curActor] = 0;
 		initializeListObs(&observationArray[curActor],
 				actorPassiveArray[actorCommonArray[actorRecordID[curActor]].passiveID].numMolRecordID);
 	}
@@ -295,29 +526,28 @@ int main(int argc, char *argv[]) {
 	}
 
 	// Create timer heap	
-	short NUM_TIMERS = spec.NUM_ACTORS + 1 + 1; // NUM_ACTORS + (ANY MESO?) + (ANY MICRO?)
-	short * heapTimer; // Heap of timer IDs
+	uint32_t NUM_TIMERS = (uint32_t) spec.NUM_ACTORS + 1 + 1; // NUM_ACTORS + (ANY MESO?) + (ANY MICRO?)
+	struct timerHeapNode * heapTimer; // Heap of timers
 	struct timerStruct * timerArray; // timer values for simulation
-	short MESO_TIMER_ID = spec.NUM_ACTORS; // ID of meso timer in timer array
-	short MICRO_TIMER_ID = spec.NUM_ACTORS + 1; // ID of (first) micro timer in timer array
-	short curTimer; // ID of current timer
+	uint32_t MESO_TIMER_ID = spec.NUM_ACTORS; // ID of meso timer in timer array
+	uint32_t MICRO_TIMER_ID = spec.NUM_ACTORS + 1; // ID of (first) micro timer in timer array
+	uint32_t curTimer; // ID of current timer
 	bool bRecordPos;
-	short (*heapTimerChildID)[2];
-	bool (*b_heapTimerChildValid)[2];
 	allocateTimerArray(NUM_TIMERS, &timerArray);
 	initializeTimerArray(NUM_TIMERS, timerArray);
-	allocateTimerHeapArray(NUM_TIMERS, &heapTimer, &heapTimerChildID,
-			&b_heapTimerChildValid);
-	heapTimerFindChildren(NUM_TIMERS, heapTimerChildID, b_heapTimerChildValid);
-	unsigned int numHeapTimerLevels = (unsigned int) ceil(log2(NUM_TIMERS+1));
+	allocateTimerHeapArray(NUM_TIMERS, &heapTimer);
 
 	// Open output text file	
 	FILE * out, *outSummary;
 
-	if (argc > 1)
-		initializeOutput(&out, &outSummary, argv[1], spec);
-	else
-		initializeOutput(&out, &outSummary, CONFIG_NAME, spec);
+	initializeOutput(&out, &outSummary, configName, spec);
+
+	// Realizations are written to the output file by a separate thread
+	struct outputWriter writer;
+	startOutputWriter(&writer, out, &spec, numActorRecord, actorRecordID,
+			NUM_ACTORS_ACTIVE, NUM_ACTORS_PASSIVE, actorCommonArray,
+			actorActiveArray, actorPassiveArray, maxActiveBits, maxPassiveObs,
+			maxAbsorbCount);
 
 	//
 	// 3-B Initialize Microscopic Environment
@@ -348,9 +578,13 @@ int main(int argc, char *argv[]) {
 
 	printf("Starting simulation at %s.\n", timeBuffer);
 	startTime = clock();
+	struct telemetry telemetry;
+	initializeTelemetry(&telemetry, spec.TELEMETRY_NAME,
+			spec.TELEMETRY_INTERVAL);
 	for (curRepeat = 0; curRepeat < spec.NUM_REPEAT; curRepeat++) {
 
 		// Initialize current realization
+		PROFILE_START(PROFILE_RESET);
 
 		//
 		// Mesoscopic Initialization
@@ -383,11 +617,7 @@ int main(int argc, char *argv[]) {
 					emptyListMol(&microMolList[i][j]);
 					initializeListMol(&microMolList[i][j]);
 				}
-				if (!isListMol3DRecentEmpty(&microMolListRecent[i][j])) { // Molecule list is not empty
-																		  // Free memory and re-allocate empty list
-					emptyListMol3DRecent(&microMolListRecent[i][j]);
-					initializeListMolRecent(&microMolListRecent[i][j]);
-				}
+				clearListMol3DRecent(&microMolListRecent[i][j]); // Keep memory for re-use
 			}
 		}
 		// Reset start times for zeroth order reactions in micro regions
@@ -421,16 +651,11 @@ int main(int argc, char *argv[]) {
 				actorCommonArray, MESO_TIMER_ID, tMeso, MICRO_TIMER_ID,
 				spec.DT_MICRO);
 		// Initialize heap for timers
-		heapTimerBuild(NUM_TIMERS, timerArray, heapTimer, numHeapTimerLevels,
-				heapTimerChildID, b_heapTimerChildValid);
+		heapTimerBuild(NUM_TIMERS, timerArray, heapTimer);
 
 		// Reset observation lists
 		for (curActor = 0; curActor < numActorRecord; curActor++) {
-			if (!isListEmptyObs(&observationArray[curActor])) {
-				emptyListObs(&observationArray[curActor]);
-				initializeListObs(&observationArray[curActor],
-						actorPassiveArray[actorCommonArray[actorRecordID[curActor]].passiveID].numMolRecordID);
-			}
+			clearListObs(&observationArray[curActor]);
 		}
 
 		// Initialize runtime parameters
@@ -439,37 +664,46 @@ int main(int argc, char *argv[]) {
 
 		numMesoSteps = 0ULL;
 
-		while (timerArray[heapTimer[0]].nextTime <= spec.TIME_FINAL) {
-			if (numMesoSub > 0) {
-				// Update meso timer in timer heap
-				heapTimerUpdate(NUM_TIMERS, timerArray, heapTimer,
-						timerArray[MESO_TIMER_ID].heapID, heapTimerChildID,
-						b_heapTimerChildValid);
-			}
+		// Molecule counts of previous realization are out of date
+		invalidateAllObserverCounts(spec.NUM_REGIONS, spec.NUM_MOL_TYPES,
+				observerMapArray);
+		PROFILE_STOP(PROFILE_RESET);
+
+		while (heapTimer[0].nextTime <= spec.TIME_FINAL) {
+			curTimer = heapTimer[0].timerID;
+
+			// Write telemetry if due. Clock is checked at every micro step
+			if (telemetry.name != NULL
+					&& bTelemetryDue(&telemetry, curTimer > (uint32_t) spec.NUM_ACTORS))
+				writeTelemetry(&telemetry, false, curRepeat, spec.NUM_REPEAT,
+						tCur, numMesoSteps, getOutputBytes(&writer),
+						spec.NUM_REGIONS, spec.NUM_MOL_TYPES, regionArray,
+						microMolList, numSub, subvolArray);
 
 			// Determine the next type of step in the simulation
-			if (heapTimer[0] < spec.NUM_ACTORS) { // Next step is by an Actor
+			if (curTimer < (uint32_t) spec.NUM_ACTORS) { // Next step is by an Actor
 
-				tCur = timerArray[heapTimer[0]].nextTime;
+				tCur = timerArray[curTimer].nextTime;
 
-				if (actorCommonArray[heapTimer[0]].spec.bActive) { // Actor is active. Place molecules or create a release object (which
+				if (actorCommonArray[curTimer].spec.bActive) { // Actor is active. Place molecules or create a release object (which
 																   // will place molecules) as specified
 
-					curActive = actorCommonArray[heapTimer[0]].activeID;
+					curActive = actorCommonArray[curTimer].activeID;
 
 					// Is next action the start of a new release?
 					if (actorActiveArray[curActive].bNextActionNewRelease) { // Determine the parameters of the new release
-						actorCommonArray[heapTimer[0]].curAction++;
+						PROFILE_START(PROFILE_NEW_RELEASE);
+						actorCommonArray[curTimer].curAction++;
 
-						newRelease(&actorCommonArray[heapTimer[0]],
+						newRelease(&actorCommonArray[curTimer],
 								&actorActiveArray[curActive],
-								timerArray[heapTimer[0]].nextTime);
-						if (actorCommonArray[heapTimer[0]].spec.bIndependent) {
-							if (!actorCommonArray[heapTimer[0]].spec.bMaxAction
-									|| actorCommonArray[heapTimer[0]].curAction
-											< actorCommonArray[heapTimer[0]].spec.numMaxAction)
+								timerArray[curTimer].nextTime);
+						if (actorCommonArray[curTimer].spec.bIndependent) {
+							if (!actorCommonArray[curTimer].spec.bMaxAction
+									|| actorCommonArray[curTimer].curAction
+											< actorCommonArray[curTimer].spec.numMaxAction)
 								actorActiveArray[curActive].nextNewReleaseTime +=
-										actorCommonArray[heapTimer[0]].spec.actionInterval;
+										actorCommonArray[curTimer].spec.actionInterval;
 							else
 								actorActiveArray[curActive].nextNewReleaseTime =
 										INFINITY;
@@ -477,174 +711,171 @@ int main(int argc, char *argv[]) {
 							actorActiveArray[curActive].nextNewReleaseTime =
 									INFINITY;
 						}
+						PROFILE_STOP(PROFILE_NEW_RELEASE);
 					} else { // Next action is the release of molecules from a current release
-						fireEmission(&actorCommonArray[heapTimer[0]],
+						PROFILE_START(PROFILE_EMISSION);
+						fireEmission(&actorCommonArray[curTimer],
 								&actorActiveArray[curActive], regionArray,
 								spec.NUM_REGIONS, subvolArray, mesoSubArray,
 								numMesoSub, spec.NUM_MOL_TYPES,
 								microMolListRecent, tMicro, heap_subvolID,
 								heap_childID, b_heap_childValid);
+						invalidateAllObserverCounts(spec.NUM_REGIONS,
+								spec.NUM_MOL_TYPES, observerMapArray);
 						// Updated mesoscopic time
 						if (numMesoSub > 0) {
-							timerArray[MESO_TIMER_ID].nextTime =
-									mesoSubArray[heap_subvolID[0]].t_rxn;
+							updateTimer(MESO_TIMER_ID, NUM_TIMERS, timerArray, heapTimer,
+									mesoSubArray[heap_subvolID[0]].t_rxn);
 							tMeso = mesoSubArray[heap_subvolID[0]].t_rxn;
 						}
+						PROFILE_STOP(PROFILE_EMISSION);
 					}
 
 					// Update next time associated with actor
 					if (actorActiveArray[curActive].nextNewReleaseTime
 							< actorActiveArray[curActive].nextEmissionTime) { // Next event will be a new release
 						actorActiveArray[curActive].bNextActionNewRelease = true;
-						timerArray[heapTimer[0]].nextTime =
-								actorActiveArray[curActive].nextNewReleaseTime;
+						updateTimer(curTimer, NUM_TIMERS, timerArray, heapTimer,
+								actorActiveArray[curActive].nextNewReleaseTime);
 					} else { // Next event will be an emission from a current release
 						actorActiveArray[curActive].bNextActionNewRelease =
 								false;
-						timerArray[heapTimer[0]].nextTime =
-								actorActiveArray[curActive].nextEmissionTime;
+						updateTimer(curTimer, NUM_TIMERS, timerArray, heapTimer,
+								actorActiveArray[curActive].nextEmissionTime);
 					}
-					actorCommonArray[heapTimer[0]].nextTime =
-							timerArray[heapTimer[0]].nextTime;
+					actorCommonArray[curTimer].nextTime =
+							timerArray[curTimer].nextTime;
 
 				} else { // Actor is passive. Make required observations as specified
 
-					// Initialize molecule list for coordinates
-					for (j = 0; j < spec.NUM_MOL_TYPES; j++) {
-						initializeListMol(&molListPassive3D[j]);
-					}
+					// Gather the passive actors that observe at this time and
+					// are next in the timer heap, so that they observe together
+					PROFILE_START(PROFILE_OBSERVATION);
+					numPassiveBatch = 0;
+					do {
+						curPassive = actorCommonArray[curTimer].passiveID;
+						passiveBatch[numPassiveBatch++] = curPassive;
+						actorPassiveArray[curPassive].bObserveNow = true;
+						for (curMolPassive = 0;
+								curMolPassive
+										< actorPassiveArray[curPassive].numMolRecordID;
+								curMolPassive++) {
+							actorPassiveArray[curPassive].curMolObs[curMolPassive] =
+									0ULL;
+						}
 
-					curPassive = actorCommonArray[heapTimer[0]].passiveID;
-					curActorRecord = actorPassiveArray[curPassive].recordID;
-					for (curMolPassive = 0;
-							curMolPassive
-									< actorPassiveArray[curPassive].numMolRecordID;
-							curMolPassive++) { // Determine type of molecule being observed
-						curMolType =
-								actorPassiveArray[curPassive].molRecordID[curMolPassive];
-						// Will molecule coordinates be recorded
-						bRecordPos =
-								actorCommonArray[heapTimer[0]].spec.bRecordPos[curMolPassive];
-
-						actorPassiveArray[curPassive].curMolObs[curMolPassive] =
-								0ULL;
-						// Search for molecules in each region in actor
-						for (curRegionID = 0;
-								curRegionID
-										< actorCommonArray[heapTimer[0]].numRegion;
-								curRegionID++) {
-							curRegion =
-									actorCommonArray[heapTimer[0]].regionID[curRegionID];
-							if (regionArray[curRegion].spec.bMicro) { // Search through region's molecule list
-								actorPassiveArray[curPassive].curMolObs[curMolPassive] +=
-										recordMolecules(
-												&microMolList[curRegion][curMolType],
-												&molListPassive3D[curMolPassive],
-												actorCommonArray[heapTimer[0]].regionInterType[curRegionID],
-												actorCommonArray[heapTimer[0]].regionInterBound[curRegionID],
-												bRecordPos,
-												actorCommonArray[heapTimer[0]].bRegionInside[curRegionID])
-												+ recordMoleculesRecent(
-														&microMolListRecent[curRegion][curMolType],
-														&molListPassive3D[curMolPassive],
-														actorCommonArray[heapTimer[0]].regionInterType[curRegionID],
-														actorCommonArray[heapTimer[0]].regionInterBound[curRegionID],
-														bRecordPos,
-														actorCommonArray[heapTimer[0]].bRegionInside[curRegionID]);
-							} else { // Search through subvolumes inside actor
-								for (curSubID = 0;
-										curSubID
-												< actorCommonArray[heapTimer[0]].numSub[curRegionID];
-										curSubID++) {
-									curSub =
-											actorCommonArray[heapTimer[0]].subID[curRegionID][curSubID];
-									numMol =
-											subvolArray[curSub].num_mol[curMolType];
-									if (actorPassiveArray[curPassive].fracSubInActor[curRegionID][curSubID]
-											< 1.) { // Roll die to see whether each molecule is in actor
-										for (curMol = 0; curMol < numMol;
-												curMol++) {
-											// Roll die to see whether molecule is within actor
-											if (mt_drand()
-													< actorPassiveArray[curPassive].fracSubInActor[curRegionID][curSubID]) {
-												actorPassiveArray[curPassive].curMolObs[curMolPassive]++;
-
-												// Add molecule position
-												if (bRecordPos) {
-													uniformPointVolume(point,
-															regionArray[curRegion].subShape,
-															actorPassiveArray[curPassive].subInterBound[curRegionID][curSubID],
-															false, 0);
-													if (!addMolecule(
-															&molListPassive3D[curMolPassive],
-															point[0], point[1],
-															point[2])) { // Creation of molecule failed
-														fprintf(stderr,"ERROR: Memory allocation to create molecule %"
-																PRIu64 " of %" PRIu64" of type %u being observed by actor %u in region %u.\n",
-																curMol, numMol, curMolType, heapTimer[0], curRegion);
-														exit(EXIT_FAILURE);
-													}
-												}
-											}
+						// Update timer structure array
+						// (actor's time is updated after its observation is recorded)
+						if (actorCommonArray[curTimer].spec.bIndependent) { // Actor is independent. Next action time is known
+							updateTimer(curTimer, NUM_TIMERS, timerArray, heapTimer,
+									timerArray[curTimer].nextTime
+									+ actorCommonArray[curTimer].spec.actionInterval);
+						} else { // Actor is dependent. Next action time is unknown
+							updateTimer(curTimer, NUM_TIMERS, timerArray, heapTimer,
+									INFINITY);
+						}
+						curTimer = heapTimer[0].timerID;
+					} while (heapTimer[0].nextTime == tCur
+							&& curTimer < (uint32_t) spec.NUM_ACTORS
+							&& !actorCommonArray[curTimer].spec.bActive);
+
+					// Search microscopic regions once for all actors in batch
+					observeMicroRegions(spec.NUM_REGIONS, spec.NUM_MOL_TYPES,
+							regionArray, observerMapArray, microMolList,
+							microMolListRecent, actorCommonArray,
+							actorPassiveArray);
+
+					for (curBatch = 0; curBatch < numPassiveBatch; curBatch++) {
+						curPassive = passiveBatch[curBatch];
+						curActor = actorPassiveArray[curPassive].actorID;
+						curActorRecord = actorPassiveArray[curPassive].recordID;
+						for (curMolPassive = 0;
+								curMolPassive
+										< actorPassiveArray[curPassive].numMolRecordID;
+								curMolPassive++) { // Determine type of molecule being observed
+							curMolType =
+									actorPassiveArray[curPassive].molRecordID[curMolPassive];
+							// Will molecule coordinates be recorded
+							bRecordPos =
+									actorCommonArray[curActor].spec.bRecordPos[curMolPassive];
+
+							// Search for molecules in each mesoscopic region in actor
+							for (curRegionID = 0;
+									curRegionID
+											< actorCommonArray[curActor].numRegion;
+									curRegionID++) {
+								curRegion =
+										actorCommonArray[curActor].regionID[curRegionID];
+								if (!regionArray[curRegion].spec.bMicro) { // Search through subvolumes inside actor
+									for (curSubID = 0;
+											curSubID
+													< actorCommonArray[curActor].numSub[curRegionID];
+											curSubID++) {
+										curSub =
+												actorCommonArray[curActor].subID[curRegionID][curSubID];
+										numMol =
+												subvolArray[curSub].num_mol[curMolType];
+										if (actorPassiveArray[curPassive].fracSubInActor[curRegionID][curSubID]
+												< 1.) { // Only some molecules in subvolume are within actor
+											// Each molecule is independently in the actor with probability equal
+											// to the fraction of the subvolume in the actor
+											numMol =
+													rd_binomial(numMol,
+															actorPassiveArray[curPassive].fracSubInActor[curRegionID][curSubID]);
 										}
-									} else { // All molecules in subvolume are within actor
 										actorPassiveArray[curPassive].curMolObs[curMolPassive] +=
 												numMol;
 
-										// Add molecule position
-										if (bRecordPos) {
+										// Add molecule positions directly to actor's buffer
+										if (bRecordPos && numMol > 0) {
+											molPosCoor =
+													reserveMolPos(
+															&actorPassiveArray[curPassive].molPosBuffer[curMolPassive],
+															numMol);
+											if (molPosCoor == NULL) { // Creation of molecules failed
+												fprintf(stderr,"ERROR: Memory allocation to record %"
+														PRIu64 " molecules of type %u being observed by actor %u in region %u.\n",
+														numMol, curMolType, curActor, curRegion);
+												exit(EXIT_FAILURE);
+											}
 											for (curMol = 0; curMol < numMol;
 													curMol++) {
-												uniformPointVolume(point,
+												uniformPointVolume(&molPosCoor[3*curMol],
 														regionArray[curRegion].subShape,
 														actorPassiveArray[curPassive].subInterBound[curRegionID][curSubID],
 														false, 0);
-												if (!addMolecule(
-														&molListPassive3D[curMolPassive],
-														point[0], point[1],
-														point[2])) { // Creation of molecule failed
-													fprintf(stderr,"ERROR: Memory allocation to create molecule %"
-															PRIu64 " of %" PRIu64" of type %u being created by actor %u in region %u.\n",
-															curMol, numMol, curMolType, heapTimer[0], curRegion);
-													exit(EXIT_FAILURE);
-												}
 											}
 										}
+									} // Search over subvolumes in region
+								}
 
-									}
-								} // Search over subvolumes in region
-							}
-
-						} // Search over regions in actor
-					}
+							} // Search over regions in actor
+						}
 
-					if (curActorRecord < SHRT_MAX) { // Add observation data to the observation list
-						addObservation(&observationArray[curActorRecord],
-								((actorCommonArray[heapTimer[0]].spec.bRecordTime) ?
-										1 : 0),
-								actorPassiveArray[curPassive].numMolRecordID,
-								&actorCommonArray[heapTimer[0]].nextTime,
-								actorPassiveArray[curPassive].curMolObs,
-								molListPassive3D);
-					}
-					// Empty molecule list for coordinates
-					for (j = 0; j < spec.NUM_MOL_TYPES; j++) {
-						emptyListMol(&molListPassive3D[j]);
-					}
+						if (curActorRecord < SHRT_MAX) { // Add observation data to the observation list
+							addObservation(&observationArray[curActorRecord],
+									((actorCommonArray[curActor].spec.bRecordTime) ?
+											1 : 0),
+									actorPassiveArray[curPassive].numMolRecordID,
+									&actorCommonArray[curActor].nextTime,
+									actorPassiveArray[curPassive].curMolObs,
+									actorPassiveArray[curPassive].molPosBuffer,
+									actorPassiveArray[curPassive].posQuant);
+						}
 
-					// Update timer structure array
-					if (actorCommonArray[heapTimer[0]].spec.bIndependent) { // Actor is independent. Next action time is known
-						actorCommonArray[heapTimer[0]].nextTime +=
-								actorCommonArray[heapTimer[0]].spec.actionInterval;
-						timerArray[heapTimer[0]].nextTime +=
-								actorCommonArray[heapTimer[0]].spec.actionInterval;
-					} else { // Actor is dependent. Next action time is unknown
-						actorCommonArray[heapTimer[0]].nextTime = INFINITY;
-						timerArray[heapTimer[0]].nextTime = INFINITY;
+						// Update time of actor's next observation
+						if (actorCommonArray[curActor].spec.bIndependent) {
+							actorCommonArray[curActor].nextTime +=
+									actorCommonArray[curActor].spec.actionInterval;
+						} else {
+							actorCommonArray[curActor].nextTime = INFINITY;
+						}
+						actorPassiveArray[curPassive].bObserveNow = false;
 					}
+					PROFILE_STOP(PROFILE_OBSERVATION);
 				}
 
-			} else if (heapTimer[0] > spec.NUM_ACTORS) { // Next step is in Micro regime
+			} else if (curTimer > (uint32_t) spec.NUM_ACTORS) { // Next step is in Micro regime
 
 				// Update Overall Time
 				tCur = tMicro;
@@ -652,6 +883,7 @@ int main(int argc, char *argv[]) {
 				// Execute zeroth order reactions to generate new molecules
 				// and add to list of recently-created molecules
 				// TODO: Move into a chem_rxn.c or micro_molecule.c function
+				PROFILE_START(PROFILE_ZEROTH_RXN);
 				for (i = 0; i < spec.NUM_REGIONS; i++) {
 					if (!regionArray[i].spec.bMicro)
 						continue;
@@ -663,6 +895,7 @@ int main(int argc, char *argv[]) {
 
 							// Determine reaction index in master region reaction list
 							curRxn = regionArray[i].zerothRxn[curZerothRxn];
+							PROFILE_COUNT(PROFILE_ZEROTH_RXN_EVENT, 1);
 
 							// Create molecules as specified by
 							// regionArray[i].numMolChange[curRxn]
@@ -693,8 +926,11 @@ fprintf									(stderr,"ERROR: Memory allocation to create molecule %"
 					}
 				}
 
+				PROFILE_STOP(PROFILE_ZEROTH_RXN);
+
 				// Execute first order reactions on all molecules
 				// (both recently-created and "old")
+				PROFILE_START(PROFILE_FIRST_RXN);
 				for (i = 0; i < spec.NUM_REGIONS; i++) {
 					if (!regionArray[i].spec.bMicro
 							|| regionArray[i].numFirstRxn < 1)
@@ -744,9 +980,15 @@ fprintf									(stderr,"ERROR: Memory allocation to create molecule %"
 					}
 				}
 
+				PROFILE_STOP(PROFILE_FIRST_RXN);
+
 				//Update flow velocity according to its acceleration
+				PROFILE_START(PROFILE_FLOW);
 				for (i = 0; i < spec.NUM_REGIONS; i++)
-					if (regionArray[i].spec.bMicro) {
+					if (regionArray[i].flowField != NULL) {
+						// Velocity is sampled from the field for each molecule
+						delta_flow[i] = spec.DT_MICRO;
+					} else if (regionArray[i].spec.bMicro) {
 						delta_flow[i] =
 								spec.DT_MICRO
 										* (regionArray[i].spec.flowVelocity
@@ -762,24 +1004,36 @@ fprintf									(stderr,"ERROR: Memory allocation to create molecule %"
 															* tCur);
 					}
 
+				PROFILE_STOP(PROFILE_FLOW);
+
 				// Diffuse all microscopic molecules to valid locations and merge
 				// 2 sets of molecule lists into 1
+				PROFILE_START(PROFILE_DIFFUSION);
 				diffuseMolecules(spec.NUM_REGIONS, spec.NUM_MOL_TYPES,
 						microMolList, microMolListRecent, regionArray,
 						mesoSubArray, subvolArray, micro_sigma, delta_flow,
-						DIFF_COEF);
+						DIFF_COEF, bLogCapture ? &captureLog : NULL);
+				PROFILE_STOP(PROFILE_DIFFUSION);
+				invalidateAllObserverCounts(spec.NUM_REGIONS,
+						spec.NUM_MOL_TYPES, observerMapArray);
+				if (bLogCapture && captureLog.numCapture > 0) {
+					logCapturedMolecules(tCur, &captureLog, NUM_ACTORS_PASSIVE,
+							actorCommonArray, actorPassiveArray);
+				}
 
 				if (numMesoSub > 0) {
 					// Check whether any subvolumes must be updated due to added molecules
 					// from microscopic regime
+					PROFILE_START(PROFILE_MESO_BOUNDARY);
 					updateMesoSubBoundary(numSub, numMesoSub, mesoSubArray,
 							subvolArray, regionArray, bTrue, tCur,
 							spec.NUM_REGIONS, spec.NUM_MOL_TYPES, heap_subvolID,
 							heap_childID, b_heap_childValid);
+					PROFILE_STOP(PROFILE_MESO_BOUNDARY);
 
 					// Update timer structure array
-					timerArray[MESO_TIMER_ID].nextTime =
-							mesoSubArray[heap_subvolID[0]].t_rxn;
+					updateTimer(MESO_TIMER_ID, NUM_TIMERS, timerArray, heapTimer,
+							mesoSubArray[heap_subvolID[0]].t_rxn);
 					tMeso = mesoSubArray[heap_subvolID[0]].t_rxn;
 				}
 
@@ -787,7 +1041,8 @@ fprintf									(stderr,"ERROR: Memory allocation to create molecule %"
 				tMicro += spec.DT_MICRO;
 
 				// Update timer structure array
-				timerArray[MICRO_TIMER_ID].nextTime += spec.DT_MICRO;
+				updateTimer(MICRO_TIMER_ID, NUM_TIMERS, timerArray, heapTimer,
+						timerArray[MICRO_TIMER_ID].nextTime + spec.DT_MICRO);
 			} else { // Next step is in Meso regime
 				numMesoSteps++;
 				// Update Overall Time
@@ -811,6 +1066,7 @@ fprintf									(stderr,"ERROR: Memory allocation to create molecule %"
 				// "Fire" reaction event				
 				if (curRxn < mesoSubArray[curMeso].firstChemRxn) { // Event is diffusion to a neighbor
 																   // Need to determine type of molecule and destination
+					PROFILE_START(PROFILE_MESO_DIFFUSION);
 					if (spec.NUM_MOL_TYPES > 1) { // Need to use division operators to determine destination
 						curMolType = curRxn / subvolArray[curSub].num_neigh;
 						destSub = subvolArray[curSub].neighID[curRxn
@@ -845,6 +1101,7 @@ fprintf									(stderr,"ERROR: Memory allocation to create molecule %"
 								destRegion, regionArray, curSub);
 
 						if (curBoundSub < UINT32_MAX) {
+							PROFILE_COUNT(PROFILE_MESO_TO_MICRO, 1);
 							// Add new molecule to random location next to source subvolume
 							if (regionArray[curRegion].boundSubNumFace[destRegion][curBoundSub]
 									> 0) {
@@ -872,6 +1129,8 @@ fprintf									(stderr,"ERROR: Memory allocation to create molecule %"
 										curMolType, curRegion, destRegion);
 								exit(EXIT_FAILURE);
 							}
+							invalidateObserverCount(spec.NUM_MOL_TYPES,
+									&observerMapArray[destRegion]);
 						} else {
 							// Error
 							fprintf(stderr,"ERROR: Molecule was supposed to transition out of subvolume %" PRIu32 " in region %u and into region %u but this subvolume could not be found in the list of subvolumes along the boundary between the two regions.\n", curSub, curRegion, destRegion);
@@ -895,11 +1154,13 @@ fprintf									(stderr,"ERROR: Memory allocation to create molecule %"
 
 					// Reset numMolChange array for next diffusion event
 					numMolChange[0] = 0ULL;
+					PROFILE_STOP(PROFILE_MESO_DIFFUSION);
 
 				} else if (curRxn
 						< mesoSubArray[curMeso].firstChemRxn
 								+ regionArray[curRegion].numChemRxn) { // Event is a chemical reaction
 																	   // Shift reaction ID by number of diffusion events
+					PROFILE_START(PROFILE_MESO_CHEM_RXN);
 					curRxn -= mesoSubArray[curMeso].firstChemRxn;
 					// TODO: Simplify by storing reactants and products of each reaction
 					for (curMolType = 0; curMolType < spec.NUM_MOL_TYPES;
@@ -920,28 +1181,32 @@ fprintf									(stderr,"ERROR: Memory allocation to create molecule %"
 							spec.NUM_REGIONS, spec.NUM_MOL_TYPES, regionArray);
 					heapMesoUpdate(numMesoSub, mesoSubArray, heap_subvolID, 0UL,
 							heap_childID, b_heap_childValid); // ALWAYS head node
+					PROFILE_STOP(PROFILE_MESO_CHEM_RXN);
 
 				} else { // ID of reaction is beyond valid range. Error
 					fprintf(stderr,"ERROR: Current mesoscopic event %u in subvolume %" PRIu32 " is invalid.\nSubvolume is number %" PRIu32 " in the mesoscopic list\n", curRxn, curSub, curMeso);
 					exit(EXIT_FAILURE);
 				}
 				// Update timer structure array
-				timerArray[MESO_TIMER_ID].nextTime =
-						mesoSubArray[heap_subvolID[0]].t_rxn;
+				updateTimer(MESO_TIMER_ID, NUM_TIMERS, timerArray, heapTimer,
+						mesoSubArray[heap_subvolID[0]].t_rxn);
 				tMeso = mesoSubArray[heap_subvolID[0]].t_rxn;
 			}
 
-			// Update timer heap
-			heapTimerUpdate(NUM_TIMERS, timerArray, heapTimer, 0,
-					heapTimerChildID, b_heapTimerChildValid);
-
 		}
 
-		// Write realization observations to output file
-		printOneTextRealization(out, spec, curRepeat, observationArray,
-				numActorRecord, actorRecordID, NUM_ACTORS_ACTIVE,
-				actorCommonArray, actorActiveArray, actorPassiveArray,
-				maxActiveBits, maxPassiveObs);
+		// Hand off realization observations to be written to output file
+		PROFILE_START(PROFILE_OUTPUT_WAIT);
+		submitRealization(&writer, curRepeat, observationArray,
+				actorActiveArray, actorPassiveArray);
+		PROFILE_STOP(PROFILE_OUTPUT_WAIT);
+
+		telemetry.numMesoEvent += numMesoSteps;
+		if (bTelemetryDue(&telemetry, true))
+			writeTelemetry(&telemetry, false, curRepeat + 1, spec.NUM_REPEAT,
+					tCur, 0ULL, getOutputBytes(&writer), spec.NUM_REGIONS,
+					spec.NUM_MOL_TYPES, regionArray, microMolList, numSub,
+					subvolArray);
 
 		if ((curRepeat + 1) % updateFreq == 0U) {
 			fracComplete = (double) (curRepeat + 1) / spec.NUM_REPEAT;
@@ -952,6 +1217,12 @@ fprintf									(stderr,"ERROR: Memory allocation to create molecule %"
 							* (1 / fracComplete - 1)/CLOCKS_PER_SEC);
 		}
 	}
+	// Wait for the last realizations to be written
+	finishOutputWriter(&writer);
+	writeTelemetry(&telemetry, true, spec.NUM_REPEAT, spec.NUM_REPEAT,
+			spec.TIME_FINAL, 0ULL, getOutputBytes(&writer), spec.NUM_REGIONS,
+			spec.NUM_MOL_TYPES, regionArray, microMolList, numSub, subvolArray);
+	closeTelemetry(&telemetry);
 	time(&timer);
 	timeInfo = localtime(&timer);
 	strftime(timeBuffer, 26, "%Y-%m-%d %H:%M:%S", timeInfo);
@@ -969,7 +1240,8 @@ fprintf									(stderr,"ERROR: Memory allocation to create molecule %"
 	// Print end time and info used to help Matlab importing
 	printTextEnd(outSummary, NUM_ACTORS_ACTIVE, numActorRecord,
 			actorCommonArray, actorActiveArray, actorPassiveArray,
-			actorRecordID, maxActiveBits, maxPassiveObs);
+			actorRecordID, maxActiveBits, maxPassiveObs, maxAbsorbCount,
+			spec.OUTPUT_CODEC, spec.NUM_REPEAT, writer.chunkOffset);
 
 	//
 	// STEP 6: Free Memory
@@ -985,9 +1257,7 @@ fprintf									(stderr,"ERROR: Memory allocation to create molecule %"
 				spec.OUTPUT_NAME);
 
 	for (curActor = 0; curActor < numActorRecord; curActor++) {
-		if (!isListEmptyObs(&observationArray[curActor])) {
-			emptyListObs(&observationArray[curActor]);
-		}
+		emptyListObs(&observationArray[curActor]);
 	}
 	for (i = 0; i < spec.NUM_REGIONS; i++) {
 		for (j = 0; j < spec.NUM_MOL_TYPES; j++) {
@@ -995,19 +1265,8 @@ fprintf									(stderr,"ERROR: Memory allocation to create molecule %"
 			emptyListMol3DRecent(&microMolListRecent[i][j]);
 		}
 	}
-	deleteActor(spec.NUM_ACTORS, actorCommonArray, regionArray,
-			NUM_ACTORS_ACTIVE, actorActiveArray, NUM_ACTORS_PASSIVE,
-			actorPassiveArray, actorRecordID);
-	heapMesoDelete(numSub, heap_subvolID, heap_childID, b_heap_childValid);
-	heapTimerDelete(heapTimer, heapTimerChildID, b_heapTimerChildValid);
+	deleteOutputWriter(&writer);
+	deleteCaptureLog(&captureLog);
+	heapTimerDelete(heapTimer);
 	deleteTimerHeapArray(timerArray);
-	deleteSubvolArray(numSub, subvolArray, spec.NUM_MOL_TYPES, spec.NUM_REGIONS,
-			regionArray);
-	deleteMesoSubArray(numMesoSub, mesoSubArray);
-	delete_boundary_region_(spec.NUM_REGIONS, spec.NUM_MOL_TYPES, regionArray);
-
-	deleteConfig(spec);
-
-	printf("Done!");
-	return 0;
 }
@@ -9,10 +9,28 @@
  *
  * actor.c - operations on array of actors and its elements
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added placement samplers so that molecules are placed directly instead of by
+ * rejection
+ * - split bulk emissions among subvolumes with one multinomial draw
+ * - placed microscopic actor emissions in batches
+ * - kept active actor releases in an array-backed min-heap
+ * - batched passive actor observations that occur at the same time
+ * - shared one count of each region's molecules among the passive actors that contain
+ * the region
+ * - recorded observed molecule positions in a coordinate buffer of each passive actor
+ * - added logging of molecules captured by absorbing and receptor surfaces
+ * - packed the bits of active actors into words and added reading of bit sequences from
+ * a binary file
+ * - added quantized and delta-encoded recording of molecule positions
+ * - took the nodes of recent molecules from an arena of each list that is cleared every
+ * time step
+ * - added reset of the parameters that can change between the simulations of a sweep
+ *
  * Revision v0.5 (2016-04-15)
  * - added ability to define location of actor by a list of regions
  * - added 2D and surface regions. Regions that have an effective dimension different
@@ -36,11 +54,45 @@
 */
 
 #include "actor.h" // for "Public" declarations
+#include <inttypes.h> // for PRIu64
 
 //
 // "Private" Declarations
 //
 
+// Draw the number of remaining molecules that are placed in one bin of a
+// multinomial split (as a binomial conditioned on the earlier bins)
+static uint64_t drawBinCount(uint64_t * numRemaining,
+	const double cumFracPrev,
+	const double cumFracBin);
+
+// Find grid cell of an observer map that contains a coordinate
+static uint32_t findObserverCellCoor(const struct observerMap * curMap,
+	const double coor,
+	const unsigned short d);
+
+// Count (and record position of) one microscopic molecule for the actors in
+// the current batch of observations that overlap the molecule's grid cell
+static void observeMicroMolecule(const struct observerMap * curMap,
+	ItemMol3D * molecule,
+	ItemMolRecent3D * moleculeRecent,
+	const unsigned short curMolType,
+	struct actorStruct3D actorCommonArray[],
+	struct actorPassiveStruct3D actorPassiveArray[]);
+
+// Add one captured molecule to the absorption log of a passive actor
+static void addAbsorption(struct actorPassiveStruct3D * actorPassive,
+	const short curMolInd,
+	const bool bRecordPos,
+	const double tCur,
+	const struct surfaceCapture3D * capture);
+
+// Create the grid that a passive actor quantizes recorded positions to. The
+// grid covers the bounding box of the actor's intersections with regions
+static void initializePosQuantizer(const struct actorStruct3D * actorCommon,
+	const short curActor,
+	struct posQuantizer ** posQuant);
+
 //
 // Definitions
 //
@@ -223,6 +275,11 @@ void initializeActorCommon(const short NUM_ACTORS,
 			malloc(actorCommonArray[curActor].numRegion*sizeof(unsigned short));
 		actorCommonArray[curActor].regionInterBound =
 			malloc(actorCommonArray[curActor].numRegion*sizeof(double[6]));
+		if(actorCommonArray[curActor].spec.bActive)
+			actorCommonArray[curActor].regionInterSampler =
+				malloc(actorCommonArray[curActor].numRegion*sizeof(struct placementSampler));
+		else // Passive actors do not place molecules
+			actorCommonArray[curActor].regionInterSampler = NULL;
 		actorCommonArray[curActor].regionInterArea =
 			malloc(actorCommonArray[curActor].numRegion*sizeof(double));
 		actorCommonArray[curActor].cumFracActorInRegion =
@@ -234,6 +291,8 @@ void initializeActorCommon(const short NUM_ACTORS,
 			|| actorCommonArray[curActor].numSub == NULL
 			|| actorCommonArray[curActor].regionInterType == NULL
 			|| actorCommonArray[curActor].regionInterBound == NULL
+			|| (actorCommonArray[curActor].spec.bActive
+				&& actorCommonArray[curActor].regionInterSampler == NULL)
 			|| actorCommonArray[curActor].regionInterArea == NULL
 			|| actorCommonArray[curActor].cumFracActorInRegion == NULL
 			|| actorCommonArray[curActor].subID == NULL){
@@ -350,9 +409,21 @@ void initializeActorCommon(const short NUM_ACTORS,
 					actorCommonArray[curActor].numRegionDim++;
 				}
 				
+				// Prepare sampler for placing molecules in the intersection
+				// (it is only used if the actor is active and the region is
+				// microscopic)
+				if(actorCommonArray[curActor].spec.bActive)
+					initializePlacementSampler(
+						&actorCommonArray[curActor].regionInterSampler[curInterRegion],
+						curRegion, regionArray,
+						actorCommonArray[curActor].regionInterType[curInterRegion],
+						actorCommonArray[curActor].regionInterBound[curInterRegion],
+						regionArray[curRegion].effectiveDim
+							!= regionArray[curRegion].dimension);
+				
 				if(regionArray[curRegion].spec.bMicro)
 				{
-					// Currently no structure members exclusive to microscopic regions
+					// Currently no other structure members exclusive to microscopic regions
 				} else if(actorCommonArray[curActor].bRegionInside[curInterRegion])
 				{
 					// All region subvolumes are in the current actor
@@ -582,7 +653,20 @@ void initializeActorActivePassive(const short NUM_ACTORS,
 			malloc(NUM_MOL_TYPES*sizeof(double *));
 		
 		initializeListRelease(&actorActiveArray[curActive].releaseList);
-		initializeListData(&actorActiveArray[curActive].binaryData);
+		initializeBitStream(&actorActiveArray[curActive].binaryData);
+		
+		actorActiveArray[curActive].bitSequence = NULL;
+		if(!actorCommonArray[curActor].spec.bRandBits)
+		{
+			actorActiveArray[curActive].bitSequence = malloc(sizeof(struct bitSequence));
+			if(actorActiveArray[curActive].bitSequence == NULL)
+			{
+				fprintf(stderr,"ERROR: Memory allocation for bit sequence of active actor %u.\n", curActive);
+				exit(EXIT_FAILURE);
+			}
+			loadBitSequence(actorCommonArray[curActor].spec.bitSequenceFile,
+				actorActiveArray[curActive].bitSequence);
+		}
 		
 		if(actorActiveArray[curActive].cumFracActorInSub == NULL ||
 			actorActiveArray[curActive].molType == NULL){
@@ -695,17 +779,62 @@ void initializeActorActivePassive(const short NUM_ACTORS,
 		actorPassiveArray[curPassive].subInterBound =
 			malloc(actorCommonArray[curActor].numRegion
 			*sizeof(double * [6]));
+		actorPassiveArray[curPassive].molRecordInd =
+			malloc(NUM_MOL_TYPES*sizeof(short));
+		actorPassiveArray[curPassive].molPosBuffer =
+			malloc(actorPassiveArray[curPassive].numMolRecordID
+			*sizeof(struct molPosBuffer3D));
+		actorPassiveArray[curPassive].bObserveNow = false;
 		
 		if(actorPassiveArray[curPassive].fracSubInActor == NULL
 			|| actorPassiveArray[curPassive].bRecordMesoAnyPos == NULL
 			|| actorPassiveArray[curPassive].molRecordID == NULL
 			|| actorPassiveArray[curPassive].molRecordPosID == NULL
 			|| actorPassiveArray[curPassive].curMolObs == NULL
-			|| actorPassiveArray[curPassive].subInterBound == NULL){
+			|| actorPassiveArray[curPassive].subInterBound == NULL
+			|| actorPassiveArray[curPassive].molRecordInd == NULL
+			|| actorPassiveArray[curPassive].molPosBuffer == NULL){
 			fprintf(stderr,"ERROR: Memory allocation for structure members of active actor %u.\n", curPassive);
 			exit(EXIT_FAILURE);
 		}
 		
+		for(i = 0; i < actorPassiveArray[curPassive].numMolRecordID; i++)
+		{
+			initializeMolPosBuffer(&actorPassiveArray[curPassive].molPosBuffer[i]);
+		}
+		
+		actorPassiveArray[curPassive].absorbLog = NULL;
+		if(actorCommonArray[curActor].spec.bRecordAbsorb
+			&& actorPassiveArray[curPassive].numMolRecordID > 0)
+		{
+			actorPassiveArray[curPassive].absorbLog =
+				malloc(actorPassiveArray[curPassive].numMolRecordID
+				*sizeof(struct absorptionLog3D));
+			if(actorPassiveArray[curPassive].absorbLog == NULL)
+			{
+				fprintf(stderr,"ERROR: Memory allocation for absorption log of passive actor %u.\n", curPassive);
+				exit(EXIT_FAILURE);
+			}
+			for(i = 0; i < actorPassiveArray[curPassive].numMolRecordID; i++)
+			{
+				actorPassiveArray[curPassive].absorbLog[i].time = NULL;
+				actorPassiveArray[curPassive].absorbLog[i].numEvent = 0;
+				actorPassiveArray[curPassive].absorbLog[i].maxEvent = 0;
+			}
+		}
+		
+		actorPassiveArray[curPassive].posQuant = NULL;
+		if(actorCommonArray[curActor].spec.posResolution > 0.
+			&& !actorCommonArray[curActor].spec.bRecordAbsorb
+			&& actorPassiveArray[curPassive].numMolRecordPosID > 0)
+		{
+			initializePosQuantizer(&actorCommonArray[curActor], curActor,
+				&actorPassiveArray[curPassive].posQuant);
+		}
+		
+		for(curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
+			actorPassiveArray[curPassive].molRecordInd[curMolType] = -1;
+		
 		for(curInterRegion = 0;
 			curInterRegion < actorCommonArray[actorPassiveArray[curPassive].actorID].numRegion;
 			curInterRegion++)
@@ -803,6 +932,7 @@ void initializeActorActivePassive(const short NUM_ACTORS,
 				if (actorCommonArray[curActor].spec.bRecordMol[curMolType])
 				{
 					actorPassiveArray[curPassive].molRecordID[curMolRecord] = curMolType;
+					actorPassiveArray[curPassive].molRecordInd[curMolType] = curMolRecord;
 					if (actorCommonArray[curActor].spec.bRecordPos[curMolType])
 					{
 						actorPassiveArray[curPassive].molRecordPosID[curMolRecord] =
@@ -816,6 +946,34 @@ void initializeActorActivePassive(const short NUM_ACTORS,
 	}
 }
 
+/* Copy the actor parameters that can change between the simulations of a
+* sweep (i.e., the modulation strength and the start time). Bit sequences
+* are read across all realizations of a simulation, so they are rewound
+* here and not in resetActors
+*/
+void resetActorParam(const short NUM_ACTORS,
+	struct actorStruct3D actorCommonArray[],
+	const struct actorStructSpec3D actorCommonSpecArray[],
+	const short NUM_ACTORS_ACTIVE,
+	struct actorActiveStruct3D actorActiveArray[])
+{
+	short curActor;
+	
+	for(curActor = 0; curActor < NUM_ACTORS; curActor++)
+	{
+		actorCommonArray[curActor].spec.modStrength =
+			actorCommonSpecArray[curActor].modStrength;
+		actorCommonArray[curActor].spec.startTime =
+			actorCommonSpecArray[curActor].startTime;
+	}
+	
+	for(curActor = 0; curActor < NUM_ACTORS_ACTIVE; curActor++)
+	{
+		if(actorActiveArray[curActor].bitSequence != NULL)
+			rewindBitSequence(actorActiveArray[curActor].bitSequence);
+	}
+}
+
 /* Reset actor members that vary with each simulation realization
 *
 */
@@ -830,26 +988,24 @@ void resetActors(const short NUM_ACTORS,
 	struct actorPassiveStruct3D actorPassiveArray[])
 {
 	short curActor;
+	unsigned short curMolInd;
 	
 	for(curActor = 0; curActor < NUM_ACTORS; curActor++)
 	{
-		actorCommonArray[curActor].nextTime =
-			actorCommonArray[curActor].spec.startTime;
+		// Actors that log captured molecules never make periodic observations
+		if(!actorCommonArray[curActor].spec.bActive
+			&& actorCommonArray[curActor].spec.bRecordAbsorb)
+			actorCommonArray[curActor].nextTime = INFINITY;
+		else
+			actorCommonArray[curActor].nextTime =
+				actorCommonArray[curActor].spec.startTime;
 		actorCommonArray[curActor].curAction = 0UL;
 	}
 	
 	for(curActor = 0; curActor < NUM_ACTORS_ACTIVE; curActor++)
 	{
-		if(!isListReleaseEmpty(&actorActiveArray[curActor].releaseList))
-		{
-			emptyListRelease(&actorActiveArray[curActor].releaseList);
-			initializeListRelease(&actorActiveArray[curActor].releaseList);
-		}
-		if(!isListDataEmpty(&actorActiveArray[curActor].binaryData))
-		{
-			emptyListData(&actorActiveArray[curActor].binaryData);
-			initializeListData(&actorActiveArray[curActor].binaryData);
-		}
+		clearListRelease(&actorActiveArray[curActor].releaseList);
+		clearBitStream(&actorActiveArray[curActor].binaryData);
 		
 		// First action will be defining a new release and not the actual release of molecules
 		actorActiveArray[curActor].nextNewReleaseTime =
@@ -858,6 +1014,19 @@ void resetActors(const short NUM_ACTORS,
 		actorActiveArray[curActor].nextEmissionTime = INFINITY;
 		actorActiveArray[curActor].nextEmissionIndex = 0;
 	}
+	
+	// Observation lists are emptied, so discard the positions that they refer to
+	for(curActor = 0; curActor < NUM_ACTORS_PASSIVE; curActor++)
+	{
+		for(curMolInd = 0;
+			curMolInd < actorPassiveArray[curActor].numMolRecordID;
+			curMolInd++)
+		{
+			clearMolPosBuffer(&actorPassiveArray[curActor].molPosBuffer[curMolInd]);
+			if(actorPassiveArray[curActor].absorbLog != NULL)
+				actorPassiveArray[curActor].absorbLog[curMolInd].numEvent = 0;
+		}
+	}
 }
 
 /* Free Memory of Common Actors
@@ -877,6 +1046,7 @@ void deleteActor(const short NUM_ACTORS,
 {
 	short curActor, curActive, curPassive;
 	short curInterRegion, curRegion;
+	unsigned short curMolInd;
 	
 	free(actorRecordID);
 	
@@ -906,7 +1076,12 @@ void deleteActor(const short NUM_ACTORS,
 				free(actorActiveArray[curActive].molType);
 			
 			emptyListRelease(&actorActiveArray[curActive].releaseList);
-			emptyListData(&actorActiveArray[curActive].binaryData);
+			deleteBitStream(&actorActiveArray[curActive].binaryData);
+			if(actorActiveArray[curActive].bitSequence != NULL)
+			{
+				deleteBitSequence(actorActiveArray[curActive].bitSequence);
+				free(actorActiveArray[curActive].bitSequence);
+			}
 		}
 		free(actorActiveArray);
 	}
@@ -943,6 +1118,29 @@ void deleteActor(const short NUM_ACTORS,
 				free(actorPassiveArray[curPassive].curMolObs);
 			if(actorPassiveArray[curPassive].subInterBound != NULL)
 				free(actorPassiveArray[curPassive].subInterBound);
+			if(actorPassiveArray[curPassive].molRecordInd != NULL)
+				free(actorPassiveArray[curPassive].molRecordInd);
+			if(actorPassiveArray[curPassive].molPosBuffer != NULL)
+			{
+				for(curMolInd = 0;
+					curMolInd < actorPassiveArray[curPassive].numMolRecordID;
+					curMolInd++)
+					deleteMolPosBuffer(&actorPassiveArray[curPassive].molPosBuffer[curMolInd]);
+				free(actorPassiveArray[curPassive].molPosBuffer);
+			}
+			if(actorPassiveArray[curPassive].absorbLog != NULL)
+			{
+				for(curMolInd = 0;
+					curMolInd < actorPassiveArray[curPassive].numMolRecordID;
+					curMolInd++)
+					free(actorPassiveArray[curPassive].absorbLog[curMolInd].time);
+				free(actorPassiveArray[curPassive].absorbLog);
+			}
+			if(actorPassiveArray[curPassive].posQuant != NULL)
+			{
+				free(actorPassiveArray[curPassive].posQuant->key);
+				free(actorPassiveArray[curPassive].posQuant);
+			}
 		}
 		free(actorPassiveArray);
 	}
@@ -958,6 +1156,9 @@ void deleteActor(const short NUM_ACTORS,
 				if(actorCommonArray[curActor].numSub[curInterRegion] > 0
 					&& actorCommonArray[curActor].subID[curInterRegion] != NULL)
 					free(actorCommonArray[curActor].subID[curInterRegion]);
+				if(actorCommonArray[curActor].regionInterSampler != NULL)
+					deletePlacementSampler(
+						&actorCommonArray[curActor].regionInterSampler[curInterRegion]);
 			}
 					
 			if(actorCommonArray[curActor].regionID != NULL)
@@ -970,6 +1171,8 @@ void deleteActor(const short NUM_ACTORS,
 				free(actorCommonArray[curActor].regionInterType);
 			if(actorCommonArray[curActor].regionInterBound != NULL)
 				free(actorCommonArray[curActor].regionInterBound);
+			if(actorCommonArray[curActor].regionInterSampler != NULL)
+				free(actorCommonArray[curActor].regionInterSampler);
 			if(actorCommonArray[curActor].regionInterArea != NULL)
 				free(actorCommonArray[curActor].regionInterArea);
 			if(actorCommonArray[curActor].cumFracActorInRegion != NULL)
@@ -987,51 +1190,37 @@ void newRelease(const struct actorStruct3D * actorCommon,
 	double curTime)
 {
 	int i; // loop index
-	NodeRelease * curRelease;
 	
 	// Parameters that need to be defined for new release (if there will actually be one)
 	double strength, startTime, endTime, frequency;
 	unsigned short molType;
 	
-	// Generate data
-	ListData newData;
-	initializeListData(&newData);
+	// Generate data. First bit is the most significant bit of the symbol
+	uint64_t symbol = 0;
 	
-	for(i = 0; i < actorCommon->spec.modBits; i++)
+	if (actorCommon->spec.bRandBits)
 	{
-		if (actorCommon->spec.bRandBits)
+		for(i = 0; i < actorCommon->spec.modBits; i++)
 		{
+			symbol <<= 1;
 			if(mt_drand() < actorCommon->spec.probOne)
-			{ // Bit is "1"
-				if(!addData(&newData, true))
-				{
-					fprintf(stderr,"ERROR: Memory allocation for new bit.\n");
-					exit(EXIT_FAILURE);
-				}
-			} else
-			{ // Bit is "0"
-				if(!addData(&newData, false))
-				{
-					fprintf(stderr,"ERROR: Memory allocation for new bit.\n");
-					exit(EXIT_FAILURE);
-				}
-			}
-		} else
-		{
-			// Bits are not random. Read from pre-determined list. TODO
+				symbol |= 1; // Bit is "1"
 		}
+	} else
+	{
+		// Bits are not random. Read from pre-determined sequence
+		symbol = readBitSequence(actorActive->bitSequence, actorCommon->spec.modBits);
 	}
 	
 	// Append newly-generated data to existing data
-	transferData(&actorActive->binaryData, &newData);
+	appendBits(&actorActive->binaryData, symbol, actorCommon->spec.modBits);
 	
 	// Translate new bits into release information, based on modulation scheme
 	switch (actorCommon->spec.modScheme)
 	{
 		case CSK:
 			// CSK: Concentration shift keying. Convert data to an unsigned int value
-			strength = ((double) binaryToDecimal(&newData, actorActive->alphabetSize))
-				* actorCommon->spec.modStrength;
+			strength = ((double) symbol) * actorCommon->spec.modStrength;
 			startTime = 0.;
 			endTime = actorCommon->spec.releaseInterval;
 			frequency = 0.;
@@ -1064,29 +1253,19 @@ void newRelease(const struct actorStruct3D * actorCommon,
 		// Update time of next emission event
 		findNextEmission(actorCommon, actorActive);
 	}
-	
-	// Free memory of new data
-	emptyListData(&newData);
 }
 
 // Find time and index of next release to have an emission
+// The release list is heap-ordered, so the next emission is always the first
 void findNextEmission(const struct actorStruct3D * actorCommon,
 	struct actorActiveStruct3D * actorActive)
 {
-	unsigned int i = 0; // Counter
-	NodeRelease * curRelease = actorActive->releaseList;
-	actorActive->nextEmissionTime = INFINITY;
-
-	while (curRelease != NULL)
-	{
-		if (curRelease->item.nextTime < actorActive->nextEmissionTime)
-		{
-			actorActive->nextEmissionTime = curRelease->item.nextTime;
-			actorActive->nextEmissionIndex = i;
-		}
-		curRelease = curRelease->next;
-		i++;
-	}
+	actorActive->nextEmissionIndex = 0;
+	if (isListReleaseEmpty(&actorActive->releaseList))
+		actorActive->nextEmissionTime = INFINITY;
+	else
+		actorActive->nextEmissionTime =
+			actorActive->releaseList.item[0].nextTime;
 }
 
 // Release molecules for current release at this instant
@@ -1104,53 +1283,45 @@ void fireEmission(const struct actorStruct3D * actorCommon,
 	uint32_t (*heap_childID)[2],
 	bool (*b_heap_childValid)[2])
 {
-	NodeRelease * curRelease = actorActive->releaseList;
-	unsigned int curReleaseInd;
+	ItemRelease * curRelease =
+		&actorActive->releaseList.item[actorActive->nextEmissionIndex];
 	bool bRemoveRelease = false;
 	uint64_t numNewMol;
 	
-	// Traverse release list to the current release
-	for(curReleaseInd = 0;
-		curReleaseInd < actorActive->nextEmissionIndex;
-		curReleaseInd++)
-	{
-		curRelease = curRelease->next;
-	}	
-	
 	// Fire emission and find time of next emission for this release
 	if(actorCommon->spec.bTimeReleaseRand)
 	{
 		// We only release one molecule right now
 		placeMolecules(actorCommon, actorActive, region, NUM_REGIONS,
 			subvolArray, mesoSubArray, numMesoSub, (uint64_t) 1,
-			curRelease->item.molType, NUM_MOL_TYPES, microMolListRecent,
-			curRelease->item.nextTime, tMicro,
+			curRelease->molType, NUM_MOL_TYPES, microMolListRecent,
+			curRelease->nextTime, tMicro,
 			heap_subvolID, heap_childID, b_heap_childValid);
 		
 		
 		// Next emission time must be generated
-		curRelease->item.nextTime +=
-			-log(mt_drand())/curRelease->item.strength;
+		curRelease->nextTime +=
+			-log(mt_drand())/curRelease->strength;
 	} else
 	{
 		if(actorCommon->spec.bNumReleaseRand)
 		{
-			numNewMol = rd_poisson(curRelease->item.strength);
+			numNewMol = rd_poisson(curRelease->strength);
 		} else
 		{
-			numNewMol = (uint64_t) curRelease->item.strength;
+			numNewMol = (uint64_t) curRelease->strength;
 		}
-		// We must place curRelease->item.strength molecules
+		// We must place curRelease->strength molecules
 		placeMolecules(actorCommon, actorActive, region, NUM_REGIONS,
 			subvolArray, mesoSubArray, numMesoSub, numNewMol,
-			curRelease->item.molType, NUM_MOL_TYPES, microMolListRecent,
-			curRelease->item.nextTime, tMicro,
+			curRelease->molType, NUM_MOL_TYPES, microMolListRecent,
+			curRelease->nextTime, tMicro,
 			heap_subvolID, heap_childID, b_heap_childValid);		
 		
 		// Use slot interval
 		if (actorCommon->spec.slotInterval > 0)
 		{
-			curRelease->item.nextTime += actorCommon->spec.slotInterval;
+			curRelease->nextTime += actorCommon->spec.slotInterval;
 		} else
 		{ // slot interval is 0; no need to check for the end of the slot time
 			bRemoveRelease = true;
@@ -1158,10 +1329,14 @@ void fireEmission(const struct actorStruct3D * actorCommon,
 	}
 	
 	if(bRemoveRelease
-		|| curRelease->item.nextTime > curRelease->item.endTime)
+		|| curRelease->nextTime > curRelease->endTime)
 	{ // Release has finished. Remove from list
 		deleteRelease(&actorActive->releaseList,
 			actorActive->nextEmissionIndex);
+	} else
+	{ // Release continues. Move it to its new place in the list
+		updateRelease(&actorActive->releaseList,
+			actorActive->nextEmissionIndex);
 	}
 	
 	// Find time and release of next emission event
@@ -1186,39 +1361,37 @@ void placeMolecules(const struct actorStruct3D * actorCommon,
 	uint32_t (*heap_childID)[2],
 	bool (*b_heap_childValid)[2])
 {
-	short curRegion, curRegionInter, curRegionDim;
-	double uniRV;
-	uint64_t curMolecule;
-	//double tCur = curRelease->item.nextTime;
+	short curRegion, curRegionInter;
+	uint64_t numRegionMol;
+	double cumFracPrev;
+	//double tCur = curRelease->nextTime;
 	
 	if(actorCommon->numRegionDim > 1)
-	{ // Molecules can end up in different regions. Place one at a time
-		for(curMolecule = 0;
-			curMolecule < numNewMol;
-			curMolecule++)
+	{ // Molecules can end up in different regions. Split them between regions
+		// with one multinomial draw and then place each region's share
+		cumFracPrev = 0.;
+		for(curRegionInter = 0;
+			curRegionInter < actorCommon->numRegion && numNewMol > 0;
+			curRegionInter++)
 		{
-			uniRV = mt_drand();
-			for(curRegionInter = 0;
-				actorCommon->cumFracActorInRegion[curRegionInter] < uniRV;
-				curRegionInter++)
-			{ // Scanning regions until we find where molecule must be place
-				if(curRegionInter >= actorCommon->numRegion)
-				{
-					fprintf(stderr,"\nWARNING: New molecule does not have a valid region to be placed in.\n");
-					break; // end for-loop
-				}
-			}
-			// Molecule will be placed in curRegionInter
-			if(curRegionInter < actorCommon->numRegion)
+			numRegionMol = drawBinCount(&numNewMol, cumFracPrev,
+				actorCommon->cumFracActorInRegion[curRegionInter]);
+			cumFracPrev = actorCommon->cumFracActorInRegion[curRegionInter];
+			if(numRegionMol > 0)
 			{
 				curRegion = actorCommon->regionID[curRegionInter];
 				placeMoleculesInRegion(actorCommon, actorActive, region,
 					curRegion, curRegionInter, NUM_REGIONS, subvolArray,
-					mesoSubArray, numMesoSub, (uint64_t) 1, curMolType, NUM_MOL_TYPES,
+					mesoSubArray, numMesoSub, numRegionMol, curMolType, NUM_MOL_TYPES,
 					&microMolListRecent[curRegion][curMolType], tCur, tMicro,
 					heap_subvolID, heap_childID, b_heap_childValid);
 			}
 		}
+		if(numNewMol > 0)
+		{
+			fprintf(stderr,"\nWARNING: %" PRIu64 " new molecule(s) do not have a valid region to be placed in.\n",
+				numNewMol);
+		}
 		
 	} else
 	{ // All molecules are going in the same region.
@@ -1257,73 +1430,66 @@ void placeMoleculesInRegion(const struct actorStruct3D * actorCommon,
 	uint32_t (*heap_childID)[2],
 	bool (*b_heap_childValid)[2])
 {
-	uint64_t curMolecule;
-	double uniRV;
-	uint32_t curSub, curSubInter;
-	bool bNeedPoint;
-	double point[3];
-	bool bSurface = regionArray[curRegion].effectiveDim
-		!= regionArray[curRegion].dimension;
+	uint64_t numSubMol;
+	double cumFracPrev, cumFracSub;
+	uint32_t curSub, curSubInter, numBatch;
+	double point[PLACEMENT_BATCH_SIZE][3];
 		
 	if(regionArray[curRegion].spec.bMicro)
 	{
 		// Add molecules uniformly within micro intersect region
-		for(curMolecule = 0;
-			curMolecule < numNewMol;
-			curMolecule++)
-		{			
-			bNeedPoint = true;
-			while(bNeedPoint)
-			{
-				// Intersection region is defined by actorCommon->regionInterBound
-				// Shape of intersection is defined by actorCommon->regionInterType
-				uniformPointVolume(point, actorCommon->regionInterType[curRegionInter],
-					actorCommon->regionInterBound[curRegionInter], bSurface,
-					regionArray[curRegion].plane);
-				
-				if(bPointInRegionNotChild(curRegion, regionArray, point))
-				{
-					bNeedPoint = false;
-					if(!addMoleculeRecent(microMolListRecent, point[0], point[1],
-						point[2], tMicro - tCur))
-					{ // Creation of molecule failed
-						fprintf(stderr, "ERROR: Memory allocation for new molecule to be placed in region %u.\n", curRegion);
-						exit(EXIT_FAILURE);
-					}
-				}			
+		// Molecules are generated and added in batches
+		while(numNewMol > 0)
+		{
+			numBatch = (numNewMol > PLACEMENT_BATCH_SIZE) ?
+				PLACEMENT_BATCH_SIZE : (uint32_t) numNewMol;
+			
+			// Intersection region is defined by actorCommon->regionInterBound
+			// Shape of intersection is defined by actorCommon->regionInterType
+			generatePlacementPoints(&actorCommon->regionInterSampler[curRegionInter],
+				curRegion, regionArray, numBatch, point);
+			if(!addMoleculesRecent(microMolListRecent, point, numBatch,
+				tMicro - tCur))
+			{ // Creation of molecule failed
+				fprintf(stderr, "ERROR: Memory allocation for new molecule to be placed in region %u.\n", curRegion);
+				exit(EXIT_FAILURE);
 			}
+			numNewMol -= numBatch;
 		}
 	} else
 	{
 		// Find subvolume in region to add molecule
 		if(actorCommon->numSub[curRegionInter] > 1)
-		{ // Molecules could end up in different subvolumes. Place one at a time.
-			for(curMolecule = 0;
-			curMolecule < numNewMol;
-			curMolecule++)
+		{ // Molecules could end up in different subvolumes. Split them between
+			// subvolumes with one multinomial draw so that each subvolume (and
+			// its heap entry) is only updated once
+			cumFracPrev = 0.;
+			for(curSubInter = 0;
+				curSubInter < actorCommon->numSub[curRegionInter] && numNewMol > 0;
+				curSubInter++)
 			{
-				uniRV = mt_drand();
 				if(actorCommon->bRegionInside[curRegionInter])
 				{ // All subvolumes in the region are equally likely because entire region is in the actor
-					curSubInter = (uint32_t) floor(uniRV * actorCommon->numSub[curRegionInter]);
+					cumFracSub = (double) (curSubInter + 1)
+						/ actorCommon->numSub[curRegionInter];
 				} else
 				{ // Need to consider the individual likelihoods for each subvolume
-					for(curSubInter = 0;
-					actorActive->cumFracActorInSub[curRegionInter][curSubInter] < uniRV;
-					curSubInter++)
-					{ // Scanning subvolumes until we find where molecule must be place
-						if(curSubInter >= actorCommon->numSub[curRegionInter])
-						{
-							fprintf(stderr,"\nWARNING: New molecule placed in region %u does not have a valid subvolume to be placed in.\n", curRegion);
-							break; // end for-loop
-						}
-					}
+					cumFracSub = actorActive->cumFracActorInSub[curRegionInter][curSubInter];
+				}
+				numSubMol = drawBinCount(&numNewMol, cumFracPrev, cumFracSub);
+				cumFracPrev = cumFracSub;
+				if(numSubMol > 0)
+				{
+					curSub = actorCommon->subID[curRegionInter][curSubInter];
+					placeMoleculesInSub(regionArray, subvolArray, mesoSubArray,
+						numMesoSub, numSubMol, curMolType, curSub, NUM_MOL_TYPES,
+						tCur, NUM_REGIONS, heap_subvolID, heap_childID, b_heap_childValid);
 				}
-				curSub = actorCommon->subID[curRegionInter][curSubInter];
-				// Molecule will be placed in curSubInter
-				placeMoleculesInSub(regionArray, subvolArray, mesoSubArray,
-					numMesoSub, (uint64_t) 1, curMolType, curSub, NUM_MOL_TYPES,
-					tCur, NUM_REGIONS, heap_subvolID, heap_childID, b_heap_childValid);
+			}
+			if(numNewMol > 0)
+			{
+				fprintf(stderr,"\nWARNING: %" PRIu64 " new molecule(s) placed in region %u do not have a valid subvolume to be placed in.\n",
+					numNewMol, curRegion);
 			}
 		} else
 		{ // All molecules are going in the same subvolume
@@ -1366,6 +1532,28 @@ void placeMoleculesInSub(struct region regionArray[],
 		mesoSubArray[curMeso].heapID, heap_childID, b_heap_childValid);
 }
 
+// Draw the number of remaining molecules that are placed in one bin of a
+// multinomial split (as a binomial conditioned on the earlier bins)
+// Bin covers the cumulative probabilities from cumFracPrev to cumFracBin. Any
+// probability beyond a cumulative value of 1 is not assigned to a bin
+static uint64_t drawBinCount(uint64_t * numRemaining,
+	const double cumFracPrev,
+	const double cumFracBin)
+{
+	uint64_t numBin;
+	
+	if(*numRemaining == 0 || cumFracBin <= cumFracPrev)
+		return 0;
+	
+	if(cumFracBin >= 1.)
+		numBin = *numRemaining; // Bin has all of the remaining probability
+	else
+		numBin = rd_binomial(*numRemaining,
+			(cumFracBin - cumFracPrev)/(1. - cumFracPrev));
+	*numRemaining -= numBin;
+	return numBin;
+}
+
 // Find range of subvolumes to search over for intersection with an actor
 void findSubSearchRange(const struct region regionArray[],
 	const short curRegion,
@@ -1569,4 +1757,625 @@ void findSubSearchRange(const struct region regionArray[],
 	if(*last1 > maxSize[0]) *last1 = maxSize[0];
 	if(*last2 > maxSize[1]) *last2 = maxSize[1];
 	if(*last3 > maxSize[2]) *last3 = maxSize[2];
-}
\ No newline at end of file
+}
+/* Build map of passive actors that observe each microscopic region
+* Only actors that record observations are included. Actors that contain an
+* entire region are listed separately from the grid
+*/
+void initializeObserverMap(const short NUM_REGIONS,
+	const unsigned short NUM_MOL_TYPES,
+	const struct region regionArray[],
+	const struct actorStruct3D actorCommonArray[],
+	const short NUM_ACTORS_PASSIVE,
+	const struct actorPassiveStruct3D actorPassiveArray[],
+	struct observerMap ** observerMapArray)
+{
+	short curRegion, curPassive, curActor;
+	unsigned short curInterRegion, d, curMolType;
+	uint32_t curEntry, numCellTotal, numPerDim;
+	uint32_t c[3], cMin[3], cMax[3];
+	uint32_t curCell;
+	double bound[6];
+	struct observerMap * curMap;
+	
+	*observerMapArray = malloc(NUM_REGIONS*sizeof(struct observerMap));
+	if(*observerMapArray == NULL)
+	{
+		fprintf(stderr,"ERROR: Memory allocation for map of passive actors in each region.\n");
+		exit(EXIT_FAILURE);
+	}
+	
+	for(curRegion = 0; curRegion < NUM_REGIONS; curRegion++)
+	{
+		curMap = &(*observerMapArray)[curRegion];
+		curMap->numEntry = 0;
+		curMap->numWhole = 0;
+		curMap->entry = NULL;
+		curMap->wholeEntry = NULL;
+		curMap->molCount = NULL;
+		curMap->bMolCountValid = NULL;
+		curMap->cellStart = NULL;
+		curMap->cellEntry = NULL;
+		for(d = 0; d < 3; d++)
+		{
+			curMap->numCell[d] = 1;
+			curMap->invCellWidth[d] = 0.;
+		}
+		
+		if(!regionArray[curRegion].spec.bMicro)
+			continue;
+		
+		// Count the actors that observe molecules in this region
+		for(curPassive = 0; curPassive < NUM_ACTORS_PASSIVE; curPassive++)
+		{
+			curActor = actorPassiveArray[curPassive].actorID;
+			if(actorPassiveArray[curPassive].numMolRecordID == 0)
+				continue;
+			for(curInterRegion = 0;
+				curInterRegion < actorCommonArray[curActor].numRegion;
+				curInterRegion++)
+			{
+				if(actorCommonArray[curActor].regionID[curInterRegion] == curRegion)
+					curMap->numEntry++;
+			}
+		}
+		
+		if(curMap->numEntry == 0)
+			continue;
+		
+		curMap->entry = malloc(curMap->numEntry*sizeof(struct observerEntry));
+		curMap->wholeEntry = malloc(curMap->numEntry*sizeof(uint32_t));
+		if(curMap->entry == NULL || curMap->wholeEntry == NULL)
+		{
+			fprintf(stderr,"ERROR: Memory allocation for map of passive actors in region %d.\n",
+				curRegion);
+			exit(EXIT_FAILURE);
+		}
+		
+		curEntry = 0;
+		for(curPassive = 0; curPassive < NUM_ACTORS_PASSIVE; curPassive++)
+		{
+			curActor = actorPassiveArray[curPassive].actorID;
+			if(actorPassiveArray[curPassive].numMolRecordID == 0)
+				continue;
+			for(curInterRegion = 0;
+				curInterRegion < actorCommonArray[curActor].numRegion;
+				curInterRegion++)
+			{
+				if(actorCommonArray[curActor].regionID[curInterRegion] != curRegion)
+					continue;
+				curMap->entry[curEntry].actorID = curActor;
+				curMap->entry[curEntry].passiveID = curPassive;
+				curMap->entry[curEntry].regionInd = curInterRegion;
+				if(actorCommonArray[curActor].bRegionInside[curInterRegion])
+					curMap->wholeEntry[curMap->numWhole++] = curEntry;
+				curEntry++;
+			}
+		}
+		
+		if(curMap->numWhole > 0)
+		{
+			curMap->molCount = malloc(NUM_MOL_TYPES*sizeof(uint64_t));
+			curMap->bMolCountValid = malloc(NUM_MOL_TYPES*sizeof(bool));
+			if(curMap->molCount == NULL || curMap->bMolCountValid == NULL)
+			{
+				fprintf(stderr,"ERROR: Memory allocation for map of passive actors in region %d.\n",
+					curRegion);
+				exit(EXIT_FAILURE);
+			}
+			for(curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
+				curMap->bMolCountValid[curMolType] = false;
+		}
+		
+		// Size grid so that there are about as many cells as binned actors
+		findBoundaryBoundingBox(regionArray[curRegion].spec.shape,
+			regionArray[curRegion].boundary, curMap->bound);
+		numPerDim = (uint32_t) ceil(cbrt((double) (curMap->numEntry - curMap->numWhole)));
+		if(numPerDim < 1)
+			numPerDim = 1;
+		else if(numPerDim > OBSERVER_MAP_MAX_PER_DIM)
+			numPerDim = OBSERVER_MAP_MAX_PER_DIM;
+		numCellTotal = 1;
+		for(d = 0; d < 3; d++)
+		{
+			if(curMap->bound[2*d+1] > curMap->bound[2*d])
+			{
+				curMap->numCell[d] = numPerDim;
+				curMap->invCellWidth[d] = numPerDim /
+					(curMap->bound[2*d+1] - curMap->bound[2*d]);
+			}
+			numCellTotal *= curMap->numCell[d];
+		}
+		
+		curMap->cellStart = calloc(numCellTotal + 1, sizeof(uint32_t));
+		if(curMap->cellStart == NULL)
+		{
+			fprintf(stderr,"ERROR: Memory allocation for map of passive actors in region %d.\n",
+				curRegion);
+			exit(EXIT_FAILURE);
+		}
+		
+		// Count the entries in each cell and find where each cell starts.
+		// Filling the cells moves each start to the start of the next cell,
+		// so the starts are shifted back afterwards
+		for(curEntry = 0; curEntry < curMap->numEntry; curEntry++)
+		{
+			if(actorCommonArray[curMap->entry[curEntry].actorID].bRegionInside[
+				curMap->entry[curEntry].regionInd])
+				continue;
+			findBoundaryBoundingBox(
+				actorCommonArray[curMap->entry[curEntry].actorID].regionInterType[
+				curMap->entry[curEntry].regionInd],
+				actorCommonArray[curMap->entry[curEntry].actorID].regionInterBound[
+				curMap->entry[curEntry].regionInd], bound);
+			for(d = 0; d < 3; d++)
+			{
+				cMin[d] = findObserverCellCoor(curMap, bound[2*d], d);
+				cMax[d] = findObserverCellCoor(curMap, bound[2*d+1], d);
+			}
+			for(c[0] = cMin[0]; c[0] <= cMax[0]; c[0]++)
+				for(c[1] = cMin[1]; c[1] <= cMax[1]; c[1]++)
+					for(c[2] = cMin[2]; c[2] <= cMax[2]; c[2]++)
+						curMap->cellStart[(c[0]*curMap->numCell[1] + c[1])
+							*curMap->numCell[2] + c[2]]++;
+		}
+		for(curCell = 1; curCell <= numCellTotal; curCell++)
+			curMap->cellStart[curCell] += curMap->cellStart[curCell-1];
+		for(curCell = numCellTotal; curCell > 0; curCell--)
+			curMap->cellStart[curCell] = curMap->cellStart[curCell-1];
+		curMap->cellStart[0] = 0;
+		
+		curMap->cellEntry = malloc((curMap->cellStart[numCellTotal] + 1)
+			*sizeof(uint32_t));
+		if(curMap->cellEntry == NULL)
+		{
+			fprintf(stderr,"ERROR: Memory allocation for map of passive actors in region %d.\n",
+				curRegion);
+			exit(EXIT_FAILURE);
+		}
+		
+		for(curEntry = 0; curEntry < curMap->numEntry; curEntry++)
+		{
+			if(actorCommonArray[curMap->entry[curEntry].actorID].bRegionInside[
+				curMap->entry[curEntry].regionInd])
+				continue;
+			findBoundaryBoundingBox(
+				actorCommonArray[curMap->entry[curEntry].actorID].regionInterType[
+				curMap->entry[curEntry].regionInd],
+				actorCommonArray[curMap->entry[curEntry].actorID].regionInterBound[
+				curMap->entry[curEntry].regionInd], bound);
+			for(d = 0; d < 3; d++)
+			{
+				cMin[d] = findObserverCellCoor(curMap, bound[2*d], d);
+				cMax[d] = findObserverCellCoor(curMap, bound[2*d+1], d);
+			}
+			for(c[0] = cMin[0]; c[0] <= cMax[0]; c[0]++)
+				for(c[1] = cMin[1]; c[1] <= cMax[1]; c[1]++)
+					for(c[2] = cMin[2]; c[2] <= cMax[2]; c[2]++)
+					{
+						curCell = (c[0]*curMap->numCell[1] + c[1])
+							*curMap->numCell[2] + c[2];
+						curMap->cellEntry[curMap->cellStart[curCell]++] = curEntry;
+					}
+		}
+		for(curCell = numCellTotal; curCell > 0; curCell--)
+			curMap->cellStart[curCell] = curMap->cellStart[curCell-1];
+		curMap->cellStart[0] = 0;
+	}
+}
+
+// Free memory of observer map
+void deleteObserverMap(const short NUM_REGIONS,
+	struct observerMap observerMapArray[])
+{
+	short curRegion;
+	
+	if(observerMapArray == NULL)
+		return;
+	
+	for(curRegion = 0; curRegion < NUM_REGIONS; curRegion++)
+	{
+		if(observerMapArray[curRegion].entry != NULL)
+			free(observerMapArray[curRegion].entry);
+		if(observerMapArray[curRegion].wholeEntry != NULL)
+			free(observerMapArray[curRegion].wholeEntry);
+		if(observerMapArray[curRegion].molCount != NULL)
+			free(observerMapArray[curRegion].molCount);
+		if(observerMapArray[curRegion].bMolCountValid != NULL)
+			free(observerMapArray[curRegion].bMolCountValid);
+		if(observerMapArray[curRegion].cellStart != NULL)
+			free(observerMapArray[curRegion].cellStart);
+		if(observerMapArray[curRegion].cellEntry != NULL)
+			free(observerMapArray[curRegion].cellEntry);
+	}
+	free(observerMapArray);
+}
+
+// Mark the molecule counts of one region's observer map as out of date
+// Must be called whenever molecules are added to or removed from the region
+void invalidateObserverCount(const unsigned short NUM_MOL_TYPES,
+	struct observerMap * curMap)
+{
+	unsigned short curMolType;
+	
+	if(curMap->bMolCountValid == NULL)
+		return;
+	
+	for(curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
+		curMap->bMolCountValid[curMolType] = false;
+}
+
+// Mark the molecule counts of every region's observer map as out of date
+void invalidateAllObserverCounts(const short NUM_REGIONS,
+	const unsigned short NUM_MOL_TYPES,
+	struct observerMap observerMapArray[])
+{
+	short curRegion;
+	
+	for(curRegion = 0; curRegion < NUM_REGIONS; curRegion++)
+		invalidateObserverCount(NUM_MOL_TYPES, &observerMapArray[curRegion]);
+}
+
+// Count (and record positions of) molecules in microscopic regions for all
+// passive actors in the current batch of observations, visiting each molecule once
+// Counts are added to curMolObs and positions to molPosBuffer of each actor
+void observeMicroRegions(const short NUM_REGIONS,
+	const unsigned short NUM_MOL_TYPES,
+	const struct region regionArray[],
+	struct observerMap observerMapArray[],
+	ListMol3D microMolList[NUM_REGIONS][NUM_MOL_TYPES],
+	ListMolRecent3D microMolListRecent[NUM_REGIONS][NUM_MOL_TYPES],
+	struct actorStruct3D actorCommonArray[],
+	struct actorPassiveStruct3D actorPassiveArray[])
+{
+	short curRegion;
+	unsigned short curMolType;
+	short curMolInd;
+	uint32_t curEntry, curWhole;
+	bool bAnyObs;
+	struct observerMap * curMap;
+	const struct observerEntry * curObs;
+	struct actorPassiveStruct3D * curPassive;
+	NodeMol3D * p_node;
+	NodeMolRecent3D * p_nodeRecent;
+	
+	for(curRegion = 0; curRegion < NUM_REGIONS; curRegion++)
+	{
+		curMap = &observerMapArray[curRegion];
+		if(curMap->numEntry == 0)
+			continue;
+		
+		for(curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
+		{
+			// Is any actor in the batch observing this type in this region?
+			bAnyObs = false;
+			for(curEntry = 0; curEntry < curMap->numEntry; curEntry++)
+			{
+				curPassive = &actorPassiveArray[curMap->entry[curEntry].passiveID];
+				if(curPassive->bObserveNow && curPassive->molRecordInd[curMolType] >= 0)
+				{
+					bAnyObs = true;
+					break;
+				}
+			}
+			if(!bAnyObs)
+				continue;
+			
+			// Actors that contain the entire region observe every molecule.
+			// Unless positions are needed, they use the region's molecule count,
+			// which is only found again after the region's molecules change
+			for(curWhole = 0; curWhole < curMap->numWhole; curWhole++)
+			{
+				curObs = &curMap->entry[curMap->wholeEntry[curWhole]];
+				curPassive = &actorPassiveArray[curObs->passiveID];
+				curMolInd = curPassive->molRecordInd[curMolType];
+				if(!curPassive->bObserveNow || curMolInd < 0)
+					continue;
+				if(!actorCommonArray[curObs->actorID].spec.bRecordPos[curMolInd])
+				{
+					if(!curMap->bMolCountValid[curMolType])
+					{
+						curMap->molCount[curMolType] =
+							recordMolecules(&microMolList[curRegion][curMolType],
+								NULL, 0, NULL, false, true)
+							+ recordMoleculesRecent(&microMolListRecent[curRegion][curMolType],
+								NULL, 0, NULL, false, true);
+						curMap->bMolCountValid[curMolType] = true;
+					}
+					curPassive->curMolObs[curMolInd] += curMap->molCount[curMolType];
+					continue;
+				}
+				curPassive->curMolObs[curMolInd] +=
+					recordMolecules(&microMolList[curRegion][curMolType],
+						&curPassive->molPosBuffer[curMolInd],
+						actorCommonArray[curObs->actorID].regionInterType[curObs->regionInd],
+						actorCommonArray[curObs->actorID].regionInterBound[curObs->regionInd],
+						actorCommonArray[curObs->actorID].spec.bRecordPos[curMolInd],
+						true)
+					+ recordMoleculesRecent(&microMolListRecent[curRegion][curMolType],
+						&curPassive->molPosBuffer[curMolInd],
+						actorCommonArray[curObs->actorID].regionInterType[curObs->regionInd],
+						actorCommonArray[curObs->actorID].regionInterBound[curObs->regionInd],
+						actorCommonArray[curObs->actorID].spec.bRecordPos[curMolInd],
+						true);
+			}
+			
+			if(curMap->numWhole == curMap->numEntry)
+				continue; // All actors contain the entire region
+			
+			// Other actors only test the molecules in the cells that they overlap
+			for(p_node = microMolList[curRegion][curMolType];
+				p_node != NULL; p_node = p_node->next)
+			{
+				observeMicroMolecule(curMap, &p_node->item, NULL, curMolType,
+					actorCommonArray, actorPassiveArray);
+			}
+			for(p_nodeRecent = microMolListRecent[curRegion][curMolType].head;
+				p_nodeRecent != NULL; p_nodeRecent = p_nodeRecent->next)
+			{
+				observeMicroMolecule(curMap, NULL, &p_nodeRecent->item, curMolType,
+					actorCommonArray, actorPassiveArray);
+			}
+		}
+	}
+}
+
+// Find grid cell of an observer map that contains a coordinate
+static uint32_t findObserverCellCoor(const struct observerMap * curMap,
+	const double coor,
+	const unsigned short d)
+{
+	double cell = (coor - curMap->bound[2*d]) * curMap->invCellWidth[d];
+	
+	if(!(cell > 0.))
+		return 0;
+	if(cell >= curMap->numCell[d])
+		return curMap->numCell[d] - 1;
+	return (uint32_t) cell;
+}
+
+// Count (and record position of) one microscopic molecule for the actors in
+// the current batch of observations that overlap the molecule's grid cell
+// Exactly one of molecule and moleculeRecent should be non-NULL
+static void observeMicroMolecule(const struct observerMap * curMap,
+	ItemMol3D * molecule,
+	ItemMolRecent3D * moleculeRecent,
+	const unsigned short curMolType,
+	struct actorStruct3D actorCommonArray[],
+	struct actorPassiveStruct3D actorPassiveArray[])
+{
+	double point[3];
+	uint32_t curCell, k;
+	short curMolInd;
+	bool bObserved;
+	const struct observerEntry * curObs;
+	struct actorPassiveStruct3D * curPassive;
+	
+	if(molecule != NULL)
+	{
+		point[0] = molecule->x;
+		point[1] = molecule->y;
+		point[2] = molecule->z;
+	} else
+	{
+		point[0] = moleculeRecent->x;
+		point[1] = moleculeRecent->y;
+		point[2] = moleculeRecent->z;
+	}
+	
+	curCell = (findObserverCellCoor(curMap, point[0], 0)*curMap->numCell[1]
+		+ findObserverCellCoor(curMap, point[1], 1))*curMap->numCell[2]
+		+ findObserverCellCoor(curMap, point[2], 2);
+	
+	for(k = curMap->cellStart[curCell]; k < curMap->cellStart[curCell+1]; k++)
+	{
+		curObs = &curMap->entry[curMap->cellEntry[k]];
+		curPassive = &actorPassiveArray[curObs->passiveID];
+		curMolInd = curPassive->molRecordInd[curMolType];
+		if(!curPassive->bObserveNow || curMolInd < 0)
+			continue;
+		
+		if(molecule != NULL)
+			bObserved = isMoleculeObserved(molecule,
+				actorCommonArray[curObs->actorID].regionInterType[curObs->regionInd],
+				actorCommonArray[curObs->actorID].regionInterBound[curObs->regionInd]);
+		else
+			bObserved = isMoleculeObservedRecent(moleculeRecent,
+				actorCommonArray[curObs->actorID].regionInterType[curObs->regionInd],
+				actorCommonArray[curObs->actorID].regionInterBound[curObs->regionInd]);
+		if(!bObserved)
+			continue;
+		
+		curPassive->curMolObs[curMolInd]++;
+		if(actorCommonArray[curObs->actorID].spec.bRecordPos[curMolInd]
+			&& !addMolPos(&curPassive->molPosBuffer[curMolInd],
+			point[0], point[1], point[2]))
+		{
+			fprintf(stderr,
+				"ERROR: Memory allocation for recording molecule positions.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+// Mark the surface regions where passive actors log captured molecules
+// Return whether any actor logs captured molecules
+bool findCaptureLogRegions(const short NUM_ACTORS_PASSIVE,
+	const struct actorStruct3D actorCommonArray[],
+	const struct actorPassiveStruct3D actorPassiveArray[],
+	struct captureLog3D * captureLog)
+{
+	short curPassive, curActor;
+	unsigned short curInterRegion;
+	bool bAnyLog = false;
+	
+	for(curPassive = 0; curPassive < NUM_ACTORS_PASSIVE; curPassive++)
+	{
+		if(actorPassiveArray[curPassive].absorbLog == NULL)
+			continue;
+		
+		curActor = actorPassiveArray[curPassive].actorID;
+		for(curInterRegion = 0;
+			curInterRegion < actorCommonArray[curActor].numRegion;
+			curInterRegion++)
+		{
+			captureLog->bRegionLogged[actorCommonArray[curActor].regionID[curInterRegion]] =
+				true;
+		}
+		bAnyLog = true;
+	}
+	
+	return bAnyLog;
+}
+
+// Add the molecules captured in the current microscopic time step to the
+// absorption logs of the passive actors that contain them, then empty the
+// capture log
+void logCapturedMolecules(const double tCur,
+	struct captureLog3D * captureLog,
+	const short NUM_ACTORS_PASSIVE,
+	struct actorStruct3D actorCommonArray[],
+	struct actorPassiveStruct3D actorPassiveArray[])
+{
+	uint32_t curCapture;
+	short curPassive, curActor, curMolInd;
+	unsigned short curInterRegion;
+	const struct surfaceCapture3D * capture;
+	double point[3];
+	
+	for(curCapture = 0; curCapture < captureLog->numCapture; curCapture++)
+	{
+		capture = &captureLog->capture[curCapture];
+		point[0] = capture->x;
+		point[1] = capture->y;
+		point[2] = capture->z;
+		
+		for(curPassive = 0; curPassive < NUM_ACTORS_PASSIVE; curPassive++)
+		{
+			curActor = actorPassiveArray[curPassive].actorID;
+			if(actorPassiveArray[curPassive].absorbLog == NULL
+				|| tCur < actorCommonArray[curActor].spec.startTime)
+				continue;
+			curMolInd = actorPassiveArray[curPassive].molRecordInd[capture->molType];
+			if(curMolInd < 0)
+				continue; // Actor does not record this type of molecule
+			
+			// Was molecule captured inside the actor?
+			// Actors defined by regions contain all of their regions.
+			// Otherwise test the actor's own shape, since a captured molecule
+			// lies on the surface and can fail a strict test against the
+			// surface intersection
+			for(curInterRegion = 0;
+				curInterRegion < actorCommonArray[curActor].numRegion;
+				curInterRegion++)
+			{
+				if(actorCommonArray[curActor].regionID[curInterRegion] != capture->region)
+					continue;
+				if(actorCommonArray[curActor].spec.bDefinedByRegions
+					|| bPointInBoundary(point,
+					actorCommonArray[curActor].spec.shape,
+					actorCommonArray[curActor].spec.boundary))
+				{
+					addAbsorption(&actorPassiveArray[curPassive], curMolInd,
+						actorCommonArray[curActor].spec.bRecordPos[capture->molType],
+						tCur, capture);
+				}
+				break;
+			}
+		}
+	}
+	
+	captureLog->numCapture = 0;
+}
+
+// Add one captured molecule to the absorption log of a passive actor
+static void addAbsorption(struct actorPassiveStruct3D * actorPassive,
+	const short curMolInd,
+	const bool bRecordPos,
+	const double tCur,
+	const struct surfaceCapture3D * capture)
+{
+	struct absorptionLog3D * curLog = &actorPassive->absorbLog[curMolInd];
+	double * newTime;
+	uint64_t newMax;
+	
+	if(curLog->numEvent == curLog->maxEvent)
+	{
+		newMax = (curLog->maxEvent > 0) ? 2*curLog->maxEvent : 64;
+		newTime = realloc(curLog->time, newMax*sizeof(double));
+		if(newTime == NULL)
+		{
+			fprintf(stderr,
+				"ERROR: Memory allocation for logging captured molecules.\n");
+			exit(EXIT_FAILURE);
+		}
+		curLog->time = newTime;
+		curLog->maxEvent = newMax;
+	}
+	curLog->time[curLog->numEvent++] = tCur;
+	
+	if(bRecordPos
+		&& !addMolPos(&actorPassive->molPosBuffer[curMolInd],
+		capture->x, capture->y, capture->z))
+	{
+		fprintf(stderr,
+			"ERROR: Memory allocation for recording molecule positions.\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+// Create the grid that a passive actor quantizes recorded positions to. The
+// grid covers the bounding box of the actor's intersections with regions and
+// its origin is a whole number of grid cells from (0,0,0)
+static void initializePosQuantizer(const struct actorStruct3D * actorCommon,
+	const short curActor,
+	struct posQuantizer ** posQuant)
+{
+	struct posQuantizer * quant;
+	short curInterRegion;
+	double interBox[6];
+	double box[6] = {INFINITY, -INFINITY, INFINITY, -INFINITY,
+		INFINITY, -INFINITY};
+	double numCell;
+	unsigned short d;
+	
+	for(curInterRegion = 0; curInterRegion < actorCommon->numRegion;
+		curInterRegion++)
+	{
+		findBoundaryBoundingBox(actorCommon->regionInterType[curInterRegion],
+			actorCommon->regionInterBound[curInterRegion], interBox);
+		for(d = 0; d < 3; d++)
+		{
+			if(interBox[2*d] < box[2*d])
+				box[2*d] = interBox[2*d];
+			if(interBox[2*d+1] > box[2*d+1])
+				box[2*d+1] = interBox[2*d+1];
+		}
+	}
+	
+	quant = malloc(sizeof(struct posQuantizer));
+	if(quant == NULL)
+	{
+		fprintf(stderr,"ERROR: Memory allocation for position grid of actor %u.\n", curActor);
+		exit(EXIT_FAILURE);
+	}
+	quant->invResolution = 1./actorCommon->spec.posResolution;
+	quant->key = NULL;
+	quant->maxKey = 0;
+	for(d = 0; d < 3; d++)
+	{
+		if(box[2*d] > box[2*d+1])
+			box[2*d+1] = box[2*d] = 0.; // Actor does not overlap any region
+		quant->originCell[d] = floor(box[2*d]*quant->invResolution);
+		quant->origin[d] = quant->originCell[d]*actorCommon->spec.posResolution;
+		numCell = ceil((box[2*d+1] - box[2*d])*quant->invResolution);
+		if(numCell > MAX_POS_CELL)
+		{
+			fprintf(stderr,"ERROR: \"Position Resolution\" of actor %u needs %.0f grid cells along dimension %u but at most %u are allowed. Use a larger resolution.\n",
+				curActor, numCell, d, MAX_POS_CELL);
+			exit(EXIT_FAILURE);
+		}
+		quant->numCell[d] = (numCell < 1.) ? 1 : (uint32_t) numCell;
+	}
+	*posQuant = quant;
+}
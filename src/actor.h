@@ -9,10 +9,24 @@
  *
  * actor.h - operations on array of actors and its elements
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added placement samplers so that molecules are placed directly instead of by
+ * rejection
+ * - kept active actor releases in an array-backed min-heap
+ * - batched passive actor observations that occur at the same time
+ * - shared one count of each region's molecules among the passive actors that contain
+ * the region
+ * - recorded observed molecule positions in a coordinate buffer of each passive actor
+ * - added logging of molecules captured by absorbing and receptor surfaces
+ * - packed the bits of active actors into words and added reading of bit sequences from
+ * a binary file
+ * - added quantized and delta-encoded recording of molecule positions
+ * - added reset of the parameters that can change between the simulations of a sweep
+ *
  * Revision v0.5 (2016-04-15)
  * - added ability to define location of actor by a list of regions
  * - added 2D and surface regions. Regions that have an effective dimension different
@@ -45,12 +59,19 @@
 #include <string.h> // for strlen(), strcmp()
 #include "region.h"
 #include "base.h" // For region adjacency
-#include "micro_molecule.h" // For molecule coordinate linked list
+#include "micro_molecule.h" // For molecule coordinate buffer
 #include "global_param.h" // For region adjacency
 #include "mol_release.h" // For each active actor's linked list of active emissions
 #include "actor_data.h" // For each active actor's linked list of binary data
 #include "subvolume.h"  // For subvolume structure
 
+/*
+* Constant definitions
+*/
+
+// Maximum number of cells along each dimension of an observer map grid
+#define OBSERVER_MAP_MAX_PER_DIM 32
+
 /*
 * Data Type Declarations
 */
@@ -125,9 +146,12 @@ struct actorStructSpec3D { // Configuration parameters
 	double slotInterval;
 	
 	// Is the actor activity defined by independent random bits?
-	// TODO: Need array for defined bits if bRandBits == FALSE
+	// If false, bits are read from bitSequenceFile
 	bool bRandBits;
 	
+	// Name of bit sequence file (NULL if bRandBits)
+	char * bitSequenceFile;
+	
 	// If bRandBits, what is the probability of one bit having value 1
 	double probOne;
 	
@@ -164,6 +188,15 @@ struct actorStructSpec3D { // Configuration parameters
 	// Which molecule types have positions recorded?
 	// (if bWrite == true AND bRecordMol[ID] == true)
 	bool * bRecordPos;
+	
+	// Log each molecule that is captured inside the actor by an absorbing or
+	// receptor surface reaction, instead of making periodic observations
+	// (if bWrite == true)
+	bool bRecordAbsorb;
+	
+	// Width of the grid cells that recorded positions are quantized to
+	// (0 if positions are recorded exactly). Ignored if bRecordAbsorb == true
+	double posResolution;
 };
 
 /* The actorStruct3D structure contains all parameters specific to any 3D
@@ -224,6 +257,11 @@ struct actorStruct3D { // Common actor parameters
 	// Length is numRegion x 6
 	double (* regionInterBound)[6];
 	
+	// Samplers for placing new molecules in the intersection of actor and
+	// region. Only used if region is microscopic
+	// Length is numRegion (NULL if actor is passive)
+	struct placementSampler * regionInterSampler;
+	
 	// Area of intersection of actor and region
 	// Length is numRegion
 	// TODO: May not need to be a permanent structure member; initialization only
@@ -298,11 +336,14 @@ struct actorActiveStruct3D { // Active actor parameters
 	// Index of next emission by a current release of the actor
 	unsigned int nextEmissionIndex;
 	
-	// Linked list for currently active release intervals
+	// Heap of currently active release intervals (ordered by next emission time)
 	ListRelease releaseList;
 	
-	// Random data associated with the actor
-	ListData binaryData;
+	// Data associated with the actor
+	struct bitStream binaryData;
+	
+	// Predetermined bits to transmit (NULL if bits are random)
+	struct bitSequence * bitSequence;
 };
 
 /* The actorPassiveStruct3D structure contains all parameters specific to a passive 3D
@@ -351,6 +392,10 @@ struct actorPassiveStruct3D { // Passive actor parameters
 	// Length is numMolRecordPosID
 	unsigned short * molRecordPosID;
 	
+	// Index of each molecule type in molRecordID (-1 if type is not recorded)
+	// Length is NUM_MOL_TYPES
+	short * molRecordInd;
+	
 	//
 	// "Simulation" parameters (Determined at simulation time)
 	//
@@ -358,6 +403,82 @@ struct actorPassiveStruct3D { // Passive actor parameters
 	// Number of molecules observed in the current observation
 	// Length is numMolRecordID
 	uint64_t * curMolObs;
+	
+	// Positions of molecules observed in the current realization. Observations
+	// refer to the positions that they recorded by their range in the buffer
+	// Length is numMolRecordID
+	struct molPosBuffer3D * molPosBuffer;
+	
+	// Is the actor making an observation in the current batch of observations?
+	bool bObserveNow;
+	
+	// Times that molecules were captured inside the actor (if spec.bRecordAbsorb)
+	// Positions of the captured molecules are stored in the same order in
+	// molPosBuffer. Length is numMolRecordID (NULL if not logging captures)
+	struct absorptionLog3D * absorbLog;
+	
+	// Grid that observed positions are quantized to
+	// (NULL if positions are recorded exactly)
+	struct posQuantizer * posQuant;
+};
+
+/* The absorptionLog3D structure is a growable array of the times that
+* molecules of one type were captured inside a passive actor
+*/
+struct absorptionLog3D {
+	double * time;
+	uint64_t numEvent; // Number of captures logged
+	uint64_t maxEvent; // Number of captures that fit in allocated memory
+};
+
+/* The observerEntry structure identifies the intersection of one passive
+* actor with one microscopic region
+*/
+struct observerEntry {
+	short actorID; // ID of actor in common list
+	
+	short passiveID; // ID of actor in passive list
+	
+	unsigned short regionInd; // Index of region in the actor's list of regions
+};
+
+/* The observerMap structure lists the passive actors that observe molecules
+* in one microscopic region. Actors that contain the entire region are listed
+* separately. The others are binned onto a uniform grid over the region's
+* bounding box, so that a molecule is only tested against actors whose
+* bounding boxes overlap the molecule's grid cell.
+*/
+struct observerMap {
+	// Number of actor intersections with the region
+	uint32_t numEntry;
+	
+	// Actor intersections with the region
+	// Length is numEntry
+	struct observerEntry * entry;
+	
+	// Number and indices of entries whose actor contains the entire region
+	uint32_t numWhole;
+	uint32_t * wholeEntry;
+	
+	// Number of molecules of each type in the region and whether that number
+	// is still valid. Only allocated if numWhole > 0
+	// Length is NUM_MOL_TYPES
+	uint64_t * molCount;
+	bool * bMolCountValid;
+	
+	// Bounding box of grid
+	double bound[6];
+	
+	// Number of grid cells along each dimension
+	uint32_t numCell[3];
+	
+	// Reciprocal of cell width along each dimension (0 if only 1 cell)
+	double invCellWidth[3];
+	
+	// Indices of entries in each cell. Entries in cell c are listed in
+	// cellEntry from cellStart[c] to cellStart[c+1]-1
+	uint32_t * cellStart;
+	uint32_t * cellEntry;
 };
 
 /*
@@ -396,6 +517,15 @@ void initializeActorActivePassive(const short NUM_ACTORS,
 	struct actorPassiveStruct3D actorPassiveArray[],
 	uint32_t subCoorInd[][3]);
 
+// Copy the actor parameters that can change between the simulations of a
+// sweep (i.e., the modulation strength and the start time) and rewind the
+// bit sequences of active actors
+void resetActorParam(const short NUM_ACTORS,
+	struct actorStruct3D actorCommonArray[],
+	const struct actorStructSpec3D actorCommonSpecArray[],
+	const short NUM_ACTORS_ACTIVE,
+	struct actorActiveStruct3D actorActiveArray[]);
+
 void resetActors(const short NUM_ACTORS,
 	struct actorStruct3D actorCommonArray[],
 	const unsigned short NUM_MOL_TYPES,
@@ -488,6 +618,55 @@ void placeMoleculesInSub(struct region regionArray[],
 	uint32_t (*heap_childID)[2],
 	bool (*b_heap_childValid)[2]);
 
+// Build map of passive actors that observe each microscopic region
+void initializeObserverMap(const short NUM_REGIONS,
+	const unsigned short NUM_MOL_TYPES,
+	const struct region regionArray[],
+	const struct actorStruct3D actorCommonArray[],
+	const short NUM_ACTORS_PASSIVE,
+	const struct actorPassiveStruct3D actorPassiveArray[],
+	struct observerMap ** observerMapArray);
+
+void deleteObserverMap(const short NUM_REGIONS,
+	struct observerMap observerMapArray[]);
+
+// Mark the molecule counts of one region's observer map as out of date
+// Must be called whenever molecules are added to or removed from the region
+void invalidateObserverCount(const unsigned short NUM_MOL_TYPES,
+	struct observerMap * curMap);
+
+// Mark the molecule counts of every region's observer map as out of date
+void invalidateAllObserverCounts(const short NUM_REGIONS,
+	const unsigned short NUM_MOL_TYPES,
+	struct observerMap observerMapArray[]);
+
+// Count (and record positions of) molecules in microscopic regions for all
+// passive actors in the current batch of observations, visiting each molecule once
+void observeMicroRegions(const short NUM_REGIONS,
+	const unsigned short NUM_MOL_TYPES,
+	const struct region regionArray[],
+	struct observerMap observerMapArray[],
+	ListMol3D microMolList[NUM_REGIONS][NUM_MOL_TYPES],
+	ListMolRecent3D microMolListRecent[NUM_REGIONS][NUM_MOL_TYPES],
+	struct actorStruct3D actorCommonArray[],
+	struct actorPassiveStruct3D actorPassiveArray[]);
+
+// Mark the surface regions where passive actors log captured molecules
+// Return whether any actor logs captured molecules
+bool findCaptureLogRegions(const short NUM_ACTORS_PASSIVE,
+	const struct actorStruct3D actorCommonArray[],
+	const struct actorPassiveStruct3D actorPassiveArray[],
+	struct captureLog3D * captureLog);
+
+// Add the molecules captured in the current microscopic time step to the
+// absorption logs of the passive actors that contain them, then empty the
+// capture log
+void logCapturedMolecules(const double tCur,
+	struct captureLog3D * captureLog,
+	const short NUM_ACTORS_PASSIVE,
+	struct actorStruct3D actorCommonArray[],
+	struct actorPassiveStruct3D actorPassiveArray[]);
+
 // Find range of subvolumes to search over for intersection with an actor
 void findSubSearchRange(const struct region regionArray[],
 	const short curRegion,
@@ -3,15 +3,21 @@
  * (Actor-based Communication via Reaction-Diffusion)
  *
  * Copyright 2015 Adam Noel. All rights reserved.
- * 
+ *
  * For license details, read LICENSE.txt in the root AcCoRD directory
  * For user documentation, read README.txt in the root AcCoRD directory
  *
- * actor_data.c - linked list of binary data associated with active actor
- * Last revised for AcCoRD v0.4.1
+ * actor_data.c - packed binary data associated with active actor, and
+ *				predetermined bit sequences loaded from a binary file
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - packed the bits of active actors into words and added reading of bit sequences from
+ * a binary file
+ * - added rewinding of bit sequences for the next simulation of a sweep
+ *
  * Revision v0.4.1
  * - improved use and format of error messages
  *
@@ -20,168 +26,159 @@
  *
  * Created 2015-04-08
 */
-
 #include "actor_data.h"
-
-// Local Function Prototypes
-
-static bool addItem(ItemData item, ListData * list);
-
-static void removeItem(NodeData * prevNode, NodeData * curNode);
-
-static void traverse(const ListData * list, void (* p_fun)(ItemData item));
-
-static void copyToNode(ItemData item, NodeData * p_node);
+#include <inttypes.h> // for PRIu64
 
 // Specific Definitions
 
-// Create new data bit
-bool addData(ListData * list,
-	const bool bit)
+// Initialize an empty bit stream
+void initializeBitStream(struct bitStream * stream)
 {
-	
-	ItemData newData = {bit};
-	return addItem(newData, list);
+	stream->word = NULL;
+	stream->numBit = 0;
+	stream->maxWord = 0;
 }
 
-// Copy new list of data bits to end of old list
-void transferData(ListData * oldData,
-	ListData * newData)
+// Append the numBits least significant bits of value (most significant first)
+void appendBits(struct bitStream * stream,
+	const uint64_t value,
+	const unsigned short numBits)
 {
-	NodeData * p_node = newData->head;
-	
-	while(p_node != NULL)
+	uint64_t curWord = stream->numBit / 64;
+	unsigned short numFree = 64 - (unsigned short) (stream->numBit % 64);
+	uint64_t numWordNeeded = (stream->numBit + numBits + 63) / 64;
+	uint64_t newMax;
+	uint64_t * newWord;
+	uint64_t bits = value;
+
+	if(numBits == 0)
+		return;
+	if(numBits < 64)
+		bits &= (UINT64_C(1) << numBits) - 1;
+
+	if(numWordNeeded > stream->maxWord)
 	{
-		if(!addData(oldData, p_node->item.bit))
+		newMax = (stream->maxWord > 0) ? 2*stream->maxWord : 4;
+		if(newMax < numWordNeeded)
+			newMax = numWordNeeded;
+		newWord = realloc(stream->word, newMax*sizeof(uint64_t));
+		if(newWord == NULL)
 		{
-			// Creation of bit failed
-			fprintf(stderr, "ERROR: Memory could not be allocated to add bit to data sequence.\n");
+			fprintf(stderr, "ERROR: Memory could not be allocated to add bits to data sequence.\n");
 			exit(EXIT_FAILURE);
 		}
-		p_node = p_node->next;
+		stream->word = newWord;
+		stream->maxWord = newMax;
 	}
-}
 
-// Convert data in binary list to decimal
-unsigned int binaryToDecimal(const ListData * list,
-	unsigned int alphabetSize)
-{
-	unsigned int curValue = 0U;
-	alphabetSize /= 2U;
-	NodeData * curNode = list->head;
-	
-	while (curNode != NULL)
+	if(numFree == 64)
+		stream->word[curWord] = 0; // Starting a new word
+
+	if(numBits <= numFree)
 	{
-		curValue += ((unsigned int) curNode->item.bit) * alphabetSize;
-		alphabetSize /= 2U;
-		curNode = curNode->next;
+		stream->word[curWord] |= bits << (numFree - numBits);
+	} else
+	{ // Bits are split between current word and next word
+		stream->word[curWord] |= bits >> (numBits - numFree);
+		stream->word[curWord+1] = bits << (64 - (numBits - numFree));
 	}
-		
-	return curValue;
+	stream->numBit += numBits;
 }
 
-// Recursively convert partial data list from binary to decimal. TODO: May not need
-unsigned int binarySubListToDecimal(const NodeData * firstNode,
-	unsigned int * maxValue)
+// Read numBits (at most 64) bits starting at firstBit as an unsigned value
+uint64_t readBits(const struct bitStream * stream,
+	const uint64_t firstBit,
+	const unsigned short numBits)
 {
-	unsigned int curMaxValue, curValue;
-	if (firstNode == NULL)
-	{
-		*maxValue = 1U;
+	uint64_t curWord = firstBit / 64;
+	unsigned short offset = (unsigned short) (firstBit % 64);
+	uint64_t bits;
+
+	if(numBits == 0)
 		return 0;
-	}
-	
-	curValue = binarySubListToDecimal(firstNode->next, &curMaxValue);
-	curValue += ((unsigned int) firstNode->item.bit) * curMaxValue;
-	*maxValue = 2*curMaxValue;
-	return curValue;
+
+	bits = stream->word[curWord] << offset;
+	if(offset + numBits > 64)
+		bits |= stream->word[curWord+1] >> (64 - offset);
+	return bits >> (64 - numBits);
 }
-	
-// General Definitions
 
-// Initialize list
-void initializeListData(ListData * list)
+// Remove all bits from a bit stream (memory is kept for the next realization)
+void clearBitStream(struct bitStream * stream)
 {
-	list->head = NULL;
-	list->tail = NULL;
+	stream->numBit = 0;
 }
 
-// Is the list empty?
-bool isListDataEmpty(const ListData * list)
+// Free memory of a bit stream
+void deleteBitStream(struct bitStream * stream)
 {
-	if(list->head == NULL) return true;
-	return false;
+	if(stream->word != NULL)
+		free(stream->word);
+	initializeBitStream(stream);
 }
 
-// Create new node to hold item and add it to the end of the list
-bool addItem(ItemData item, ListData * list)
+// Load a bit sequence from a binary file
+void loadBitSequence(const char * fileName,
+	struct bitSequence * sequence)
 {
-	NodeData * p_new;
-	
-	p_new = malloc(sizeof(NodeData));
-	if (p_new == NULL)
-		return false;	// Quit on failure of malloc
-		
-	copyToNode(item, p_new);
-	p_new->next = NULL;
-	if(list->tail == NULL)
-	{ // List was empty. This item is first in list
-		list->head = p_new;
-		list->tail = p_new;
-	} else
+	const char * header;
+
+	sequence->fileData = mapFile(fileName, "Bit sequence", 1,
+		&sequence->fileSize, &sequence->bMapped);
+	header = (const char *) sequence->fileData;
+
+	if(sequence->fileSize < BIT_SEQUENCE_HEADER_SIZE
+		|| memcmp(header, BIT_SEQUENCE_MAGIC, 8) != 0)
 	{
-		list->tail->next = p_new; // Point end of list to new node
-		list->tail = p_new;
+		fprintf(stderr, "ERROR: Bit sequence file \"%s\" does not start with a valid header.\n",
+			fileName);
+		exit(EXIT_FAILURE);
 	}
-	return true;
-}
 
-// Remove node from list. In order to do this efficiently, need to pass Nodes
-// and not the start of the list.
-// TODO: Update this function for current list type (it does not currently have the
-// correct free calls but the function is not called so it is not a problem)
-void removeItem(NodeData * prevNode, NodeData * curNode)
-{
-	if (curNode != NULL)
+	memcpy(&sequence->numBit, header + 8, sizeof(uint64_t));
+	if(sequence->numBit < 1
+		|| (sequence->numBit + 7) / 8 > sequence->fileSize - BIT_SEQUENCE_HEADER_SIZE)
 	{
-		if (prevNode != NULL)
-		{
-			// Update pointer of previous node to point to following node
-			prevNode->next = curNode->next;		
-		}
-		free(curNode); // Free memory of node
+		fprintf(stderr, "ERROR: Bit sequence file \"%s\" is too short for its %" PRIu64 " bits.\n",
+			fileName, sequence->numBit);
+		exit(EXIT_FAILURE);
 	}
+
+	sequence->bits = (const unsigned char *) header + BIT_SEQUENCE_HEADER_SIZE;
+	sequence->nextBit = 0;
 }
 
-// Visit each node and execute the function pointed to by p_fun
-// p_fun must be a void function that takes an item as input
-void traverse(const ListData * list, void (* p_fun)(ItemData item))
+// Read the next numBits bits of a bit sequence as an unsigned value
+uint64_t readBitSequence(struct bitSequence * sequence,
+	const unsigned short numBits)
 {
-	NodeData * p_node = list->head;
-	
-	while(p_node != NULL)
+	unsigned short i;
+	uint64_t bits = 0;
+	uint64_t curBit = sequence->nextBit;
+
+	for(i = 0; i < numBits; i++)
 	{
-		(*p_fun)(p_node->item); // Apply function
-		p_node = p_node->next;  // Advance to next item
+		bits = (bits << 1)
+			| ((sequence->bits[curBit / 8] >> (7 - curBit % 8)) & 1U);
+		if(++curBit == sequence->numBit)
+			curBit = 0; // Wrap around to start of sequence
 	}
+	sequence->nextBit = curBit;
+	return bits;
 }
 
-// De-allocate memory of all nodes in the list
-void emptyListData(ListData * list)
+// Read a bit sequence again from its first bit
+void rewindBitSequence(struct bitSequence * sequence)
 {
-	NodeData * p_save;
-	NodeData * p_cur;
-	
-	while(list->head != NULL)
-	{
-		p_save = list->head->next;	// Save address of next node
-		free(list->head);				// Free memory of current node
-		list->head = p_save;			// Advance to next node
-	}
+	sequence->nextBit = 0;
 }
 
-// Copy an item to a node
-static void copyToNode(ItemData item, NodeData * p_node)
+// Free memory (or unmap file) associated with a bit sequence
+void deleteBitSequence(struct bitSequence * sequence)
 {
-	p_node->item = item; // Structure copy
-}
\ No newline at end of file
+	if(sequence->fileData == NULL)
+		return;
+	unmapFile(sequence->fileData, sequence->fileSize, sequence->bMapped);
+	sequence->fileData = NULL;
+	sequence->bits = NULL;
+}
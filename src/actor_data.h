@@ -3,15 +3,21 @@
  * (Actor-based Communication via Reaction-Diffusion)
  *
  * Copyright 2015 Adam Noel. All rights reserved.
- * 
+ *
  * For license details, read LICENSE.txt in the root AcCoRD directory
  * For user documentation, read README.txt in the root AcCoRD directory
  *
- * actor_data.h - linked list of binary data associated with active actor
- * Last revised for AcCoRD v0.4.1
+ * actor_data.h - packed binary data associated with active actor, and
+ *				predetermined bit sequences loaded from a binary file
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - packed the bits of active actors into words and added reading of bit sequences from
+ * a binary file
+ * - added rewinding of bit sequences for the next simulation of a sweep
+ *
  * Revision v0.4.1
  * - improved use and format of error messages
  *
@@ -26,47 +32,97 @@
 #include <stdio.h> // to create and edit files
 #include <stdlib.h> // for exit(), malloc, free, NULL
 #include <stdbool.h> // for C++ bool naming, requires C99
+#include <stdint.h> // for uint64_t
+#include <string.h> // for memcmp()
+#include "file_map.h" // for reading bit sequence files
+
+//
+// Constant definitions
+//
+
+// Bit sequence file layout (all values in native byte order):
+// char[8]		magic string BIT_SEQUENCE_MAGIC (no terminating null)
+// uint64_t		number of bits in the sequence
+// uint8_t[]	bits packed 8 per byte, most significant bit of each byte first
+#define BIT_SEQUENCE_MAGIC "ACBITS01"
+#define BIT_SEQUENCE_HEADER_SIZE 16
+
+//
+// Data Type Declarations
+//
+
+/* The bitStream structure stores the bits generated by an active actor.
+* Bits are packed into 64-bit words with the first bit in the most significant
+* position of the first word, so any symbol of up to 64 bits can be read back
+* with at most two word accesses.
+*/
+struct bitStream {
+	// Packed bits. Unused bits of the last word are zero
+	uint64_t * word;
+
+	// Number of bits stored
+	uint64_t numBit;
 
-// data specific declarations
-struct curData {
-	bool bit;
+	// Number of words allocated
+	uint64_t maxWord;
 };
 
-// General (linked list) type declarations
+/* The bitSequence structure is a predetermined sequence of bits read from a
+* bit sequence file. The bits are read directly from the file contents, which
+* are memory-mapped where possible. Reading wraps around to the start of the
+* sequence after the last bit.
+*/
+struct bitSequence {
+	// Packed bits. Length is numBit/8 rounded up
+	const unsigned char * bits;
+
+	// Number of bits in the sequence
+	uint64_t numBit;
 
-typedef struct curData ItemData;
+	// Index of next bit to be read
+	uint64_t nextBit;
 
-typedef struct node_Data{
-	ItemData item;
-	struct node_Data * next;
-} NodeData;
+	// File contents and whether they were mapped (rather than copied)
+	void * fileData;
+	size_t fileSize;
+	bool bMapped;
+};
 
-typedef struct list_data{
-	NodeData * head; // Pointer to first observation
-	NodeData * tail; // Pointer to most recent observation
-} ListData;
+//
+// Function Declarations
+//
 
-// data specific Prototypes
+// Initialize an empty bit stream
+void initializeBitStream(struct bitStream * stream);
 
-bool addData(ListData * list,
-	const bool bit);
+// Append the numBits least significant bits of value (most significant first)
+void appendBits(struct bitStream * stream,
+	const uint64_t value,
+	const unsigned short numBits);
 
-void transferData(ListData * oldData,
-	ListData * newData);
-	
-unsigned int binaryToDecimal(const ListData * list,
-	unsigned int alphabetSize);
+// Read numBits (at most 64) bits starting at firstBit as an unsigned value
+uint64_t readBits(const struct bitStream * stream,
+	const uint64_t firstBit,
+	const unsigned short numBits);
 
-unsigned int binarySubListToDecimal(const NodeData * firstNode,
-	unsigned int * maxValue);
+// Remove all bits from a bit stream (memory is kept for the next realization)
+void clearBitStream(struct bitStream * stream);
 
-// General Prototypes
+// Free memory of a bit stream
+void deleteBitStream(struct bitStream * stream);
 
-void initializeListData(ListData * list);
+// Load a bit sequence from a binary file
+void loadBitSequence(const char * fileName,
+	struct bitSequence * sequence);
 
-bool isListDataEmpty(const ListData * list);
+// Read the next numBits bits of a bit sequence as an unsigned value
+uint64_t readBitSequence(struct bitSequence * sequence,
+	const unsigned short numBits);
 
-void emptyListData(ListData * list);
+// Read a bit sequence again from its first bit
+void rewindBitSequence(struct bitSequence * sequence);
 
+// Free memory (or unmap file) associated with a bit sequence
+void deleteBitSequence(struct bitSequence * sequence);
 
 #endif // ACTOR_DATA_H
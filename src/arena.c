@@ -0,0 +1,95 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * arena.c - bump allocator for memory that is only needed until the end of
+ *				a realization, so that it can all be released at once
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#include "arena.h"
+
+//
+// Definitions
+//
+
+// Initialize an arena with no blocks
+void initializeArena(struct memArena * arena)
+{
+	arena->head = NULL;
+	arena->cur = NULL;
+	arena->numUsed = 0;
+}
+
+// Allocate memory from an arena. Returns NULL if a new block is needed and
+// cannot be allocated
+void * arenaAlloc(struct memArena * arena,
+	size_t numByte)
+{
+	struct arenaBlock * next, * newBlock;
+	size_t blockSize;
+	void * p_new;
+
+	numByte = (numByte + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+
+	if(arena->cur == NULL || arena->numUsed + numByte > arena->cur->size)
+	{
+		// Move to the next block, which is kept from before the arena was
+		// cleared or is added now
+		next = (arena->cur == NULL) ? arena->head : arena->cur->next;
+		if(next == NULL || next->size < numByte)
+		{
+			blockSize = (arena->cur == NULL) ?
+				ARENA_MIN_BLOCK_SIZE : 2*arena->cur->size;
+			if(blockSize > ARENA_MAX_BLOCK_SIZE)
+				blockSize = ARENA_MAX_BLOCK_SIZE;
+			if(blockSize < numByte)
+				blockSize = numByte;
+			newBlock = malloc(sizeof(struct arenaBlock) + blockSize);
+			if(newBlock == NULL)
+				return NULL;
+			newBlock->size = blockSize;
+			newBlock->next = next;
+			if(arena->cur == NULL)
+				arena->head = newBlock;
+			else
+				arena->cur->next = newBlock;
+			next = newBlock;
+		}
+		arena->cur = next;
+		arena->numUsed = 0;
+	}
+
+	// Memory starts after block header
+	p_new = (unsigned char *) (arena->cur + 1) + arena->numUsed;
+	arena->numUsed += numByte;
+	return p_new;
+}
+
+// Release all memory allocated from an arena but keep its blocks for re-use
+void clearArena(struct memArena * arena)
+{
+	arena->cur = arena->head;
+	arena->numUsed = 0;
+}
+
+// De-allocate the blocks of an arena
+void deleteArena(struct memArena * arena)
+{
+	struct arenaBlock * next;
+
+	while(arena->head != NULL)
+	{
+		next = arena->head->next;
+		free(arena->head);
+		arena->head = next;
+	}
+	initializeArena(arena);
+}
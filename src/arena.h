@@ -0,0 +1,74 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * arena.h - bump allocator for memory that is only needed until the end of
+ *				a realization, so that it can all be released at once
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h> // for malloc, free, size_t
+
+//
+// Constant definitions
+//
+
+// Size of first block of an arena (in bytes). Each new block is twice as
+// large as the previous one, up to ARENA_MAX_BLOCK_SIZE
+#define ARENA_MIN_BLOCK_SIZE 4096
+#define ARENA_MAX_BLOCK_SIZE 1048576
+
+// Alignment of allocations (in bytes)
+#define ARENA_ALIGN 8
+
+//
+// Data Type Declarations
+//
+
+/* The arenaBlock structure is the header of one block of memory in an
+* arena. The memory follows the header.
+*/
+struct arenaBlock {
+	struct arenaBlock * next; // Next block in arena (NULL if last)
+	size_t size; // Bytes of memory in block
+};
+
+/* The memArena structure is a bump allocator. Memory is taken from the end
+* of the current block and is never freed individually. Clearing the arena
+* keeps its blocks for re-use, so it takes constant time.
+*/
+struct memArena {
+	struct arenaBlock * head; // First block (NULL if arena has no blocks)
+	struct arenaBlock * cur; // Block that memory is taken from
+	size_t numUsed; // Bytes used in current block
+};
+
+//
+// Function Declarations
+//
+
+// Initialize an arena with no blocks
+void initializeArena(struct memArena * arena);
+
+// Allocate memory from an arena. Returns NULL if a new block is needed and
+// cannot be allocated
+void * arenaAlloc(struct memArena * arena,
+	size_t numByte);
+
+// Release all memory allocated from an arena but keep its blocks for re-use
+void clearArena(struct memArena * arena);
+
+// De-allocate the blocks of an arena
+void deleteArena(struct memArena * arena);
+
+#endif // ARENA_H
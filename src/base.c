@@ -10,10 +10,16 @@
  * base.c - general utility functions that can apply to different simulation data
  * 			structures
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added boxBoundaryRelation to classify a rectangular box as inside, outside, or cut
+ * by a boundary
+ * - added shape-specific versions of bPointInBoundary
+ * - generated uniform points in spheres directly instead of by rejection
+ *
  * Revision v0.5 (2016-04-15)
  * - filling in cases for 2D Rectangles
  * - added function to calculate boundary surface area. Renamed boundaryArea
@@ -62,33 +68,16 @@ bool bPointInBoundary(const double point[3], const int boundary1Type,
 	switch (boundary1Type) {
 	case RECTANGLE:
 	case RECTANGULAR_BOX:
-		return (point[0] >= boundary1[0] && point[0] <= boundary1[1]
-				&& point[1] >= boundary1[2] && point[1] <= boundary1[3]
-				&& point[2] >= boundary1[4] && point[2] <= boundary1[5]);
+		return bPointInBox(point, boundary1);
 	case SPHERE:
-		return (pointDistance(point, boundary1) <= boundary1[3]);
+		return bPointInSphere(point, boundary1);
 	case CYLINDER:
 		if (boundary1[4] == PLANE_XY) {
-			return (point[2] >= boundary1[2]
-					&& point[2] <= (boundary1[2] + boundary1[5])
-					&& sqrt(
-							squareDBL(point[0] - boundary1[0])
-									+ squareDBL(point[1] - boundary1[1]))
-							<= boundary1[3]);
+			return bPointInCylinderZ(point, boundary1);
 		} else if (boundary1[4] == PLANE_XZ) {
-			return (point[1] >= boundary1[1]
-					&& point[1] <= (boundary1[1] + boundary1[5])
-					&& sqrt(
-							squareDBL(point[0] - boundary1[0])
-									+ squareDBL(point[2] - boundary1[2]))
-							<= boundary1[3]);
+			return bPointInCylinderY(point, boundary1);
 		} else if (boundary1[4] == PLANE_YZ) {
-			return (point[0] >= boundary1[0]
-					&& point[0] <= (boundary1[0] + boundary1[5])
-					&& sqrt(
-							squareDBL(point[1] - boundary1[1])
-									+ squareDBL(point[2] - boundary1[2]))
-							<= boundary1[3]);
+			return bPointInCylinderX(point, boundary1);
 		}
 	default:
 		fprintf(stderr, "ERROR: Cannot find point in shape type %s.\n",
@@ -97,6 +86,156 @@ bool bPointInBoundary(const double point[3], const int boundary1Type,
 	}
 }
 
+// Is point inside of a rectangle or box?
+bool bPointInBox(const double point[3], const double boundary1[]) {
+	return (point[0] >= boundary1[0] && point[0] <= boundary1[1]
+			&& point[1] >= boundary1[2] && point[1] <= boundary1[3]
+			&& point[2] >= boundary1[4] && point[2] <= boundary1[5]);
+}
+
+// Is point inside of a sphere?
+bool bPointInSphere(const double point[3], const double boundary1[]) {
+	return (pointDistance(point, boundary1) <= boundary1[3]);
+}
+
+// Is point inside of a cylinder whose axis is along x?
+// Radial distance is compared as a square to avoid sqrt
+bool bPointInCylinderX(const double point[3], const double boundary1[]) {
+	return (point[0] >= boundary1[0]
+			&& point[0] <= (boundary1[0] + boundary1[5])
+			&& squareDBL(point[1] - boundary1[1])
+					+ squareDBL(point[2] - boundary1[2])
+					<= squareDBL(boundary1[3]));
+}
+
+// Is point inside of a cylinder whose axis is along y?
+bool bPointInCylinderY(const double point[3], const double boundary1[]) {
+	return (point[1] >= boundary1[1]
+			&& point[1] <= (boundary1[1] + boundary1[5])
+			&& squareDBL(point[0] - boundary1[0])
+					+ squareDBL(point[2] - boundary1[2])
+					<= squareDBL(boundary1[3]));
+}
+
+// Is point inside of a cylinder whose axis is along z?
+bool bPointInCylinderZ(const double point[3], const double boundary1[]) {
+	return (point[2] >= boundary1[2]
+			&& point[2] <= (boundary1[2] + boundary1[5])
+			&& squareDBL(point[0] - boundary1[0])
+					+ squareDBL(point[1] - boundary1[1])
+					<= squareDBL(boundary1[3]));
+}
+
+// Find the shape-specific version of bPointInBoundary for a boundary
+// Binding this once avoids switching on the shape for every point tested
+PointInBoundaryFunc findPointInBoundaryFunc(const int boundary1Type,
+		const double boundary1[]) {
+	switch (boundary1Type) {
+	case RECTANGLE:
+	case RECTANGULAR_BOX:
+		return &bPointInBox;
+	case SPHERE:
+		return &bPointInSphere;
+	case CYLINDER:
+		if (boundary1[4] == PLANE_XY)
+			return &bPointInCylinderZ;
+		else if (boundary1[4] == PLANE_XZ)
+			return &bPointInCylinderY;
+		else if (boundary1[4] == PLANE_YZ)
+			return &bPointInCylinderX;
+		return NULL;
+	default:
+		return NULL;
+	}
+}
+
+// Is a rectangular box entirely inside, entirely outside, or cut by a boundary?
+// Boundaries are closed, so a box that only touches a boundary is BOX_PARTIAL
+int boxBoundaryRelation(const double box[6], const int boundary1Type,
+		const double boundary1[]) {
+	unsigned short i;
+	int axis[3];
+	double dNear, dFar, lower, upper;
+	double nearSq = 0.;
+	double farSq = 0.;
+
+	switch (boundary1Type) {
+	case RECTANGLE:
+	case RECTANGULAR_BOX:
+		for (i = 0; i < 3; i++) {
+			if (box[2 * i + 1] < boundary1[2 * i]
+					|| box[2 * i] > boundary1[2 * i + 1])
+				return BOX_OUTSIDE;
+		}
+		for (i = 0; i < 3; i++) {
+			if (box[2 * i] <= boundary1[2 * i]
+					|| box[2 * i + 1] >= boundary1[2 * i + 1])
+				return BOX_PARTIAL;
+		}
+		return BOX_INSIDE;
+	case SPHERE:
+		// Compare nearest and furthest box points with the sphere radius
+		for (i = 0; i < 3; i++) {
+			lower = box[2 * i] - boundary1[i];
+			upper = box[2 * i + 1] - boundary1[i];
+			if (lower > 0.)
+				dNear = lower;
+			else if (upper < 0.)
+				dNear = -upper;
+			else
+				dNear = 0.;
+			dFar = fabs(lower) > fabs(upper) ? fabs(lower) : fabs(upper);
+			nearSq += dNear * dNear;
+			farSq += dFar * dFar;
+		}
+		if (nearSq > boundary1[4])
+			return BOX_OUTSIDE;
+		if (farSq < boundary1[4])
+			return BOX_INSIDE;
+		return BOX_PARTIAL;
+	case CYLINDER:
+		// axis[0] is along the cylinder axis; axis[1] and axis[2] are across it
+		if (boundary1[4] == PLANE_XY) {
+			axis[0] = 2;
+			axis[1] = 0;
+			axis[2] = 1;
+		} else if (boundary1[4] == PLANE_XZ) {
+			axis[0] = 1;
+			axis[1] = 0;
+			axis[2] = 2;
+		} else {
+			axis[0] = 0;
+			axis[1] = 1;
+			axis[2] = 2;
+		}
+		if (box[2 * axis[0] + 1] < boundary1[axis[0]]
+				|| box[2 * axis[0]] > boundary1[axis[0]] + boundary1[5])
+			return BOX_OUTSIDE;
+		for (i = 1; i < 3; i++) {
+			lower = box[2 * axis[i]] - boundary1[axis[i]];
+			upper = box[2 * axis[i] + 1] - boundary1[axis[i]];
+			if (lower > 0.)
+				dNear = lower;
+			else if (upper < 0.)
+				dNear = -upper;
+			else
+				dNear = 0.;
+			dFar = fabs(lower) > fabs(upper) ? fabs(lower) : fabs(upper);
+			nearSq += dNear * dNear;
+			farSq += dFar * dFar;
+		}
+		if (nearSq > squareDBL(boundary1[3]))
+			return BOX_OUTSIDE;
+		if (farSq < squareDBL(boundary1[3])
+				&& box[2 * axis[0]] > boundary1[axis[0]]
+				&& box[2 * axis[0] + 1] < boundary1[axis[0]] + boundary1[5])
+			return BOX_INSIDE;
+		return BOX_PARTIAL;
+	default:
+		return BOX_PARTIAL;
+	}
+}
+
 // Do two sets of boundaries overlap? TODO add full cylinder support
 bool bBoundaryIntersect(const int boundary1Type, const double boundary1[],
 		const int boundary2Type, const double boundary2[],
@@ -943,14 +1082,13 @@ bool bLineHitBoundary(const double p1[3], const double L[3],
 		if (bIntersect) {
 			//TODO: teststuff, improve or remove!
 			if (boundary1[5] == 0.
-					&& sqrt(
-							squareDBL(
-									nearestIntersectPoint[across1]
-											- boundary1[across1])
-									+ squareDBL(
-											nearestIntersectPoint[across2]
-													- boundary1[across2]))
-							> boundary1[3])
+					&& squareDBL(
+							nearestIntersectPoint[across1]
+									- boundary1[across1])
+							+ squareDBL(
+									nearestIntersectPoint[across2]
+											- boundary1[across2])
+							> squareDBL(boundary1[3]))
 				return false;
 
 			*d = minDist;
@@ -1559,6 +1697,8 @@ double distanceToBoundary(const double point[3], const int boundary1Type,
 		const double boundary1[]) {
 	double dist = 0.;
 	double dist2;
+	double distRadial, distAxial;
+	int along, across1, across2;
 
 	switch (boundary1Type) {
 	case RECTANGULAR_BOX:
@@ -1603,6 +1743,37 @@ double distanceToBoundary(const double point[3], const int boundary1Type,
 		if (dist < 0)
 			dist = -dist;
 		return dist;
+	case CYLINDER:
+		if (boundary1[4] == PLANE_XY) {
+			along = 2;
+			across1 = 0;
+			across2 = 1;
+		} else if (boundary1[4] == PLANE_XZ) {
+			along = 1;
+			across1 = 0;
+			across2 = 2;
+		} else {
+			along = 0;
+			across1 = 1;
+			across2 = 2;
+		}
+		// Signed distances outside of the mantle and outside of the end faces
+		// (negative values are inside)
+		distRadial = sqrt(
+				squareDBL(point[across1] - boundary1[across1])
+						+ squareDBL(point[across2] - boundary1[across2]))
+				- boundary1[3];
+		distAxial = boundary1[along] - point[along];
+		dist2 = point[along] - boundary1[along] - boundary1[5];
+		if (dist2 > distAxial)
+			distAxial = dist2;
+		if (distRadial <= 0. && distAxial <= 0.) // Point is inside cylinder
+			return (distRadial > distAxial) ? -distRadial : -distAxial;
+		if (distRadial <= 0.)
+			return distAxial;
+		if (distAxial <= 0.)
+			return distRadial;
+		return sqrt(squareDBL(distRadial) + squareDBL(distAxial));
 	default:
 		fprintf(stderr,
 				"ERROR: Cannot determine the distance from a point to a %s.\n",
@@ -1980,9 +2151,8 @@ double uniformPoint(double rangeMin, double rangeMax) {
 // Find a random coordinate within the specified boundary
 void uniformPointVolume(double point[3], const int boundaryType,
 		const double boundary1[], bool bSurface, const short planeID) {
-	bool bNeedPoint;
 	short curFace;
-	double r, rSq;
+	double r, cosTheta, sinTheta, phi;
 
 	switch (boundaryType) {
 	case RECTANGLE:
@@ -2098,42 +2268,20 @@ void uniformPointVolume(double point[3], const int boundaryType,
 	case CIRCLE:
 		return;
 	case SPHERE:
-		// Use rejection method to create point in sphere
-		bNeedPoint = true;
-		while (bNeedPoint) {
-			point[0] = mt_drand();
-			point[1] = mt_drand();
-			point[2] = mt_drand();
-
-			rSq = squareDBL(point[0]) + squareDBL(point[1])
-					+ squareDBL(point[2]);
-
-			if (rSq < 1.) {
-				// Found valid point. Scale as needed and randomize sign
-				if (mt_drand() > 0.5)
-					point[0] = -point[0];
-				if (mt_drand() > 0.5)
-					point[1] = -point[1];
-				if (mt_drand() > 0.5)
-					point[2] = -point[2];
-
-				if (bSurface) {
-					r = sqrt(rSq);
-					point[0] /= r;
-					point[1] /= r;
-					point[2] /= r;
-				}
-				point[0] = boundary1[0] + point[0] * boundary1[3];
-				point[1] = boundary1[1] + point[1] * boundary1[3];
-				point[2] = boundary1[2] + point[2] * boundary1[3];
-
-				bNeedPoint = false;
-			}
-		}
+		// Invert the CDFs of a uniform point in spherical coordinates.
+		// The cosine of the polar angle is uniform, and the CDF of the
+		// distance from the center is proportional to its cube
+		cosTheta = 2. * mt_drand() - 1.;
+		sinTheta = sqrt(1. - cosTheta * cosTheta);
+		phi = 2. * PI * mt_drand();
+		r = bSurface ? boundary1[3] : boundary1[3] * cbrt(mt_drand());
+		point[0] = boundary1[0] + r * sinTheta * cos(phi);
+		point[1] = boundary1[1] + r * sinTheta * sin(phi);
+		point[2] = boundary1[2] + r * cosTheta;
 		return;
 	case CYLINDER:
-		//use rejection method to create point in cylinder
-		//TODO: new, test and validate
+		// Invert the CDFs of a uniform point in cylindrical coordinates.
+		// The CDF of the distance from the axis is proportional to its square
 
 		//transform coordinates
 		; //dummy statement to allow declarations after a label
@@ -2159,17 +2307,12 @@ void uniformPointVolume(double point[3], const int boundaryType,
 			return;
 		}
 
-		bNeedPoint = true;
-		while (bNeedPoint) {
-			point[along] = uniformPoint(boundary1[along],
-					boundary1[along] + boundary1[5]);
-			point[across1] = uniformPoint(boundary1[across1] - boundary1[3],
-					boundary1[across1] + boundary1[3]);
-			point[across2] = uniformPoint(boundary1[across2] - boundary1[3],
-					boundary1[across2] + boundary1[3]);
-
-			bNeedPoint = !bPointInBoundary(point, boundaryType, boundary1);
-		}
+		point[along] = uniformPoint(boundary1[along],
+				boundary1[along] + boundary1[5]);
+		r = boundary1[3] * sqrt(mt_drand());
+		phi = 2. * PI * mt_drand();
+		point[across1] = boundary1[across1] + r * cos(phi);
+		point[across2] = boundary1[across2] + r * sin(phi);
 		return;
 	default:
 		fprintf(stderr,
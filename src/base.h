@@ -10,10 +10,15 @@
  * base.h - general utility functions that can apply to different simulation data
  * 			structures
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added boxBoundaryRelation to classify a rectangular box as inside, outside, or cut
+ * by a boundary
+ * - added shape-specific versions of bPointInBoundary
+ *
  * Revision v0.5 (2016-04-15)
  * - filling in cases for 2D Rectangles
  * - added function to calculate boundary surface area. Renamed boundaryArea
@@ -52,10 +57,23 @@
 #include "randistrs.h" // For PRNGs
 #include "global_param.h"
 
+//
+// Constant definitions
+//
+
+// Relation of a rectangular box to another boundary
+#define BOX_OUTSIDE 0
+#define BOX_INSIDE 1
+#define BOX_PARTIAL 2
+
 //
 // Data Type Declarations
 //
 
+// Shape-specific test of whether a point is inside of a boundary
+typedef bool (*PointInBoundaryFunc)(const double point[3],
+	const double boundary1[]);
+
 //
 // Function Declarations
 //
@@ -64,6 +82,34 @@
 bool bPointInBoundary(const double point[3],
 	const int boundary1Type,
 	const double boundary1[]);
+
+// Shape-specific versions of bPointInBoundary
+bool bPointInBox(const double point[3],
+	const double boundary1[]);
+
+bool bPointInSphere(const double point[3],
+	const double boundary1[]);
+
+// Cylinders are specialized by the axis that they lie along
+bool bPointInCylinderX(const double point[3],
+	const double boundary1[]);
+
+bool bPointInCylinderY(const double point[3],
+	const double boundary1[]);
+
+bool bPointInCylinderZ(const double point[3],
+	const double boundary1[]);
+
+// Find the shape-specific version of bPointInBoundary for a boundary
+// Returns NULL if the shape is not supported
+PointInBoundaryFunc findPointInBoundaryFunc(const int boundary1Type,
+	const double boundary1[]);
+
+// Is a rectangular box entirely inside, entirely outside, or cut by a boundary?
+// Errs towards BOX_PARTIAL when the answer is not certain
+int boxBoundaryRelation(const double box[6],
+	const int boundary1Type,
+	const double boundary1[]);
 	
 // Do two sets of boundaries intersect?
 bool bBoundaryIntersect(const int boundary1Type,
@@ -1,3 +1,3 @@
 @echo off
 if not exist "..\bin\" mkdir "..\bin"
-gcc accord.c mtwist.c randistrs.c region.c subvolume.c meso.c micro_molecule.c chem_rxn.c actor.c base.c observations.c timer_accord.c mol_release.c actor_data.c file_io.c cJSON.c -std=c99 -g -o "..\bin\accord_win_debug.exe"
\ No newline at end of file
+gcc accord.c mtwist.c randistrs.c region.c subvolume.c meso.c micro_molecule.c chem_rxn.c actor.c base.c observations.c timer_accord.c mol_release.c actor_data.c file_io.c flow_field.c file_map.c output_writer.c shm_output.c profile.c telemetry.c arena.c geometry_cache.c cJSON.c -std=c99 -g -o "..\bin\accord_win_debug.exe"
\ No newline at end of file
@@ -1,3 +1,3 @@
 @echo off
 if not exist "..\bin\" mkdir "..\bin"
-gcc accord.c mtwist.c randistrs.c subvolume.c meso.c micro_molecule.c region.c chem_rxn.c actor.c base.c observations.c timer_accord.c mol_release.c actor_data.c file_io.c cJSON.c -std=c99 -O3 -o "..\bin\accord_win.exe"
\ No newline at end of file
+gcc accord.c mtwist.c randistrs.c subvolume.c meso.c micro_molecule.c region.c chem_rxn.c actor.c base.c observations.c timer_accord.c mol_release.c actor_data.c file_io.c flow_field.c file_map.c output_writer.c shm_output.c profile.c telemetry.c arena.c geometry_cache.c cJSON.c -std=c99 -O3 -o "..\bin\accord_win.exe"
\ No newline at end of file
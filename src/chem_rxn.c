@@ -9,10 +9,13 @@
  *
  * chem_rxn.c - structure for storing chemical reaction properties
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added surface reaction type of each chemical reaction to region structure
+ *
  * Revision v0.5 (2016-04-15)
  * - removed limit on number of molecule types
  * - removed limit on number of products in a reaction
@@ -146,6 +149,8 @@ void initializeRegionChemRxn(const short NUM_REGIONS,
 			malloc(regionArray[i].numChemRxn*sizeof(uint32_t));
 		regionArray[i].rxnRate =
 			malloc(regionArray[i].numChemRxn*sizeof(double));
+		regionArray[i].rxnSurfType =
+			malloc(regionArray[i].numChemRxn*sizeof(short));
 		regionArray[i].zerothRxn =
 			malloc(regionArray[i].numChemRxn*sizeof(unsigned short));
 		regionArray[i].firstRxn =
@@ -180,6 +185,7 @@ void initializeRegionChemRxn(const short NUM_REGIONS,
 			|| regionArray[i].bUpdateProp == NULL
 			|| regionArray[i].rxnOrder == NULL
 			|| regionArray[i].rxnRate == NULL
+			|| regionArray[i].rxnSurfType == NULL
 			|| regionArray[i].zerothRxn == NULL
 			|| regionArray[i].firstRxn == NULL
 			|| regionArray[i].secondRxn == NULL
@@ -259,6 +265,7 @@ void initializeRegionChemRxn(const short NUM_REGIONS,
 			bFoundReactant = false;
 			regionArray[i].numRxnProducts[j] = 0;
 			curRxn = rxnInRegionID[j][i]; // Current reaction in chem_rxn array
+			regionArray[i].rxnSurfType[j] = chem_rxn[curRxn].surfRxnType;
 			
 			if(chem_rxn[curRxn].surfRxnType == RXN_MEMBRANE
 				&& regionArray[i].spec.surfaceType != SURFACE_MEMBRANE)
@@ -545,6 +552,7 @@ void deleteRegionChemRxn(const short NUM_REGIONS,
 		if(regionArray[i].bUpdateProp != NULL) free(regionArray[i].bUpdateProp);
 		if(regionArray[i].rxnOrder != NULL) free(regionArray[i].rxnOrder);
 		if(regionArray[i].rxnRate != NULL) free(regionArray[i].rxnRate);
+		if(regionArray[i].rxnSurfType != NULL) free(regionArray[i].rxnSurfType);
 		if(regionArray[i].zerothRxn != NULL) free(regionArray[i].zerothRxn);
 		if(regionArray[i].firstRxn != NULL) free(regionArray[i].firstRxn);
 		if(regionArray[i].secondRxn != NULL) free(regionArray[i].secondRxn);
@@ -9,10 +9,26 @@
  *
  * file_io.c - interface with JSON configuration files
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added advection of microscopic molecules by a region flow field that is read from a
+ * memory-mapped velocity grid
+ * - recorded observed molecule positions in a coordinate buffer of each passive actor
+ * - added logging of molecules captured by absorbing and receptor surfaces
+ * - packed the bits of active actors into words and added reading of bit sequences from
+ * a binary file
+ * - wrote realization output on a separate thread
+ * - added optional deflate compression of the output file
+ * - added quantized and delta-encoded recording of molecule positions
+ * - added publishing of observations to a shared memory ring buffer
+ * - added opt-in profiling of simulation phases
+ * - added periodic telemetry records
+ * - added optional cache of subvolume neighbours on disk
+ * - added seed and parameter sweeps that run in one process
+ *
  * Revision v0.5 (2016-04-15)
  * - added ability to define location of actor by a list of regions
  * - modified check on number of subvolumes along each dimension of a rectangular region
@@ -48,7 +64,15 @@
  * - header added
  */
 
+#include <math.h> // for INFINITY
 #include "file_io.h"
+#include "profile.h" // for adding profile to summary
+
+// Read an array of numbers that a sweep variant uses instead of parameters of
+// the configuration. Returns NULL if the array is not defined or is invalid
+static double * loadSweepArray(cJSON * variantJSON, const char * name,
+		const int length, const double minValue, const int curVariant,
+		bool * bWarn, int * numWarn);
 
 // Load configuration file
 void loadConfig(const char * CONFIG_NAME, uint32_t customSEED,
@@ -58,7 +82,8 @@ void loadConfig(const char * CONFIG_NAME, uint32_t customSEED,
 	cJSON * configJSON;
 	cJSON *simControl, *environment, *regionSpec, *curObj, *curObjInner,
 			*actorSpec, *actorShape, *actorModScheme, *diffCoef, *chemSpec,
-			*rxnSpec;
+			*rxnSpec, *sweepSpec;
+	struct sweepVariant * curVariant;
 	int arrayLen;
 	char * tempString;
 	int curArrayItem;
@@ -213,6 +238,112 @@ void loadConfig(const char * CONFIG_NAME, uint32_t customSEED,
 				curSpec->SEED);
 	}
 
+	curSpec->OUTPUT_CODEC = OUTPUT_CODEC_NONE;
+	if (cJSON_bItemValid(configJSON, "Output Compression", cJSON_String)) {
+		tempString = stringWrite(
+				cJSON_GetObjectItem(configJSON, "Output Compression")->valuestring);
+		if (strcmp(tempString, "Deflate") == 0) {
+#ifdef ACCORD_USE_ZLIB
+			curSpec->OUTPUT_CODEC = OUTPUT_CODEC_DEFLATE;
+#else
+			bWarn = true;
+			printf(
+					"WARNING %d: AcCoRD was built without zlib, so \"Output Compression\" cannot be \"Deflate\". Output will not be compressed.\n",
+					numWarn++);
+#endif // ACCORD_USE_ZLIB
+		} else if (strcmp(tempString, "None") != 0) {
+			bWarn = true;
+			printf(
+					"WARNING %d: \"Output Compression\" has an invalid value. Output will not be compressed.\n",
+					numWarn++);
+		}
+		free(tempString);
+	} else if (cJSON_GetObjectItem(configJSON, "Output Compression") != NULL) {
+		bWarn = true;
+		printf(
+				"WARNING %d: \"Output Compression\" has an invalid value. Output will not be compressed.\n",
+				numWarn++);
+	}
+
+	curSpec->bShmOutput = false;
+	curSpec->SHM_SIZE = (uint64_t) SHM_SIZE_DEFAULT << 20;
+	if (cJSON_bItemValid(configJSON, "Publish to Shared Memory?",
+			cJSON_True)) {
+		curSpec->bShmOutput = cJSON_GetObjectItem(configJSON,
+				"Publish to Shared Memory?")->valueint;
+#ifndef __linux__
+		if (curSpec->bShmOutput) {
+			bWarn = true;
+			printf(
+					"WARNING %d: Shared memory output is only available on Linux. Observations will not be published.\n",
+					numWarn++);
+			curSpec->bShmOutput = false;
+		}
+#endif // __linux__
+	} else if (cJSON_GetObjectItem(configJSON,
+			"Publish to Shared Memory?") != NULL) {
+		bWarn = true;
+		printf(
+				"WARNING %d: \"Publish to Shared Memory?\" has an invalid value. Assigning default value \"false\".\n",
+				numWarn++);
+	}
+	if (curSpec->bShmOutput) {
+		if (cJSON_bItemValid(configJSON, "Shared Memory Size", cJSON_Number)
+				&& cJSON_GetObjectItem(configJSON, "Shared Memory Size")->valueint
+						> 0) {
+			curSpec->SHM_SIZE = (uint64_t) cJSON_GetObjectItem(configJSON,
+					"Shared Memory Size")->valueint << 20;
+		} else if (cJSON_GetObjectItem(configJSON,
+				"Shared Memory Size") != NULL) {
+			bWarn = true;
+			printf(
+					"WARNING %d: \"Shared Memory Size\" has an invalid value. Assigning default value \"%d\" MiB.\n",
+					numWarn++, SHM_SIZE_DEFAULT);
+		}
+	}
+
+	curSpec->TELEMETRY_NAME = NULL;
+	curSpec->TELEMETRY_INTERVAL = TELEMETRY_INTERVAL_DEFAULT;
+	if (cJSON_bItemValid(configJSON, "Telemetry File", cJSON_String)
+			&& strlen(cJSON_GetObjectItem(configJSON, "Telemetry File")->valuestring)
+					> 0) {
+		curSpec->TELEMETRY_NAME = stringWrite(
+				cJSON_GetObjectItem(configJSON, "Telemetry File")->valuestring);
+	} else if (cJSON_GetObjectItem(configJSON, "Telemetry File") != NULL) {
+		bWarn = true;
+		printf(
+				"WARNING %d: \"Telemetry File\" has an invalid value. Telemetry will not be written.\n",
+				numWarn++);
+	}
+	if (curSpec->TELEMETRY_NAME != NULL) {
+		if (cJSON_bItemValid(configJSON, "Telemetry Interval", cJSON_Number)
+				&& cJSON_GetObjectItem(configJSON, "Telemetry Interval")->valuedouble
+						> 0) {
+			curSpec->TELEMETRY_INTERVAL = cJSON_GetObjectItem(configJSON,
+					"Telemetry Interval")->valuedouble;
+		} else if (cJSON_GetObjectItem(configJSON,
+				"Telemetry Interval") != NULL) {
+			bWarn = true;
+			printf(
+					"WARNING %d: \"Telemetry Interval\" has an invalid value. Assigning default value \"%d\" seconds.\n",
+					numWarn++, TELEMETRY_INTERVAL_DEFAULT);
+		}
+	}
+
+	curSpec->GEOMETRY_CACHE_DIR = NULL;
+	if (cJSON_bItemValid(configJSON, "Geometry Cache Directory", cJSON_String)
+			&& strlen(cJSON_GetObjectItem(configJSON,
+					"Geometry Cache Directory")->valuestring) > 0) {
+		curSpec->GEOMETRY_CACHE_DIR = stringWrite(
+				cJSON_GetObjectItem(configJSON, "Geometry Cache Directory")->valuestring);
+	} else if (cJSON_GetObjectItem(configJSON,
+			"Geometry Cache Directory") != NULL) {
+		bWarn = true;
+		printf(
+				"WARNING %d: \"Geometry Cache Directory\" has an invalid value. Geometry will not be cached.\n",
+				numWarn++);
+	}
+
 	if (!cJSON_bItemValid(simControl, "Number of Repeats", cJSON_Number)
 			|| cJSON_GetObjectItem(simControl, "Number of Repeats")->valueint
 					< 0) { // Config file does not list a valid Number of Repeats
@@ -1297,6 +1428,22 @@ void loadConfig(const char * CONFIG_NAME, uint32_t customSEED,
 
 		}
 
+		// Optional flow field (replaces the other flow parameters)
+		curSpec->subvol_spec[curArrayItem].flowFieldFile = NULL;
+		if (cJSON_bItemValid(curObj, "Flow Field File", cJSON_String)) {
+			if (!curSpec->subvol_spec[curArrayItem].bMicro
+					|| curSpec->subvol_spec[curArrayItem].type
+							!= REGION_NORMAL) {
+				bWarn = true;
+				printf(
+						"WARNING %d: Region %d can only have a \"Flow Field File\" if it is a microscopic region of type \"Normal\". Ignoring.\n",
+						numWarn++, curArrayItem);
+			} else {
+				curSpec->subvol_spec[curArrayItem].flowFieldFile = stringWrite(
+						cJSON_GetObjectItem(curObj, "Flow Field File")->valuestring);
+			}
+		}
+
 		// Override region time step with global one
 		curSpec->subvol_spec[curArrayItem].dt = curSpec->DT_MICRO;
 		//curSpec->subvol_spec[curArrayItem].dt =
@@ -1598,20 +1745,26 @@ void loadConfig(const char * CONFIG_NAME, uint32_t customSEED,
 						cJSON_GetObjectItem(curObj, "Slot Interval")->valuedouble;
 			}
 
-			/*
-			 if(!cJSON_bItemValid(curObj,"Bits Random?", cJSON_True))
-			 { // Actor does not have a valid value for Bits Random?
-			 bWarn = true;
-			 printf("WARNING %d: Actor %d does not have a valid value for \"Bits Random?\". Assigning default value \"true\".\n", numWarn++, curArrayItem);
-			 curSpec->actorSpec[curArrayItem].bRandBits = true;
-			 } else
-			 {
-			 curSpec->actorSpec[curArrayItem].bRandBits =
-			 cJSON_GetObjectItem(curObj, "Bits Random?")->valueint;
-			 }*/
-			curSpec->actorSpec[curArrayItem].bRandBits = true; // NOTE: CURRENTLY MUST BE TRUE
-
-			if (!cJSON_bItemValid(curObj, "Probability of Bit 1", cJSON_Number)
+			curSpec->actorSpec[curArrayItem].bitSequenceFile = NULL;
+			if (cJSON_bItemValid(curObj, "Bit Sequence File", cJSON_String)) {
+				// Bits are read from a file instead of generated randomly
+				curSpec->actorSpec[curArrayItem].bRandBits = false;
+				curSpec->actorSpec[curArrayItem].bitSequenceFile = stringWrite(
+						cJSON_GetObjectItem(curObj, "Bit Sequence File")->valuestring);
+			} else {
+				if (cJSON_GetObjectItem(curObj, "Bit Sequence File") != NULL) {
+					bWarn = true;
+					printf(
+							"WARNING %d: Actor %d has an invalid \"Bit Sequence File\". Using random bits.\n",
+							numWarn++, curArrayItem);
+				}
+				curSpec->actorSpec[curArrayItem].bRandBits = true;
+			}
+
+			if (!curSpec->actorSpec[curArrayItem].bRandBits) {
+				// Probability of bit 1 is not used
+				curSpec->actorSpec[curArrayItem].probOne = 0.5;
+			} else if (!cJSON_bItemValid(curObj, "Probability of Bit 1", cJSON_Number)
 					|| cJSON_GetObjectItem(curObj, "Probability of Bit 1")->valuedouble
 							< 0.
 					|| cJSON_GetObjectItem(curObj, "Probability of Bit 1")->valuedouble
@@ -1827,7 +1980,218 @@ void loadConfig(const char * CONFIG_NAME, uint32_t customSEED,
 					}
 				}
 			}
+
+			// Optional logging of molecules captured by surface reactions
+			curSpec->actorSpec[curArrayItem].bRecordAbsorb = false;
+			if (cJSON_bItemValid(curObj, "Are Absorption Events Recorded?",
+					cJSON_True)) {
+				curSpec->actorSpec[curArrayItem].bRecordAbsorb =
+						cJSON_GetObjectItem(curObj,
+								"Are Absorption Events Recorded?")->valueint;
+			} else if (cJSON_GetObjectItem(curObj,
+					"Are Absorption Events Recorded?") != NULL) {
+				bWarn = true;
+				printf(
+						"WARNING %d: Actor %d does not have a valid \"Are Absorption Events Recorded?\". Assigning default value \"false\".\n",
+						numWarn++, curArrayItem);
+			}
+
+			// Optional quantization of recorded molecule positions
+			curSpec->actorSpec[curArrayItem].posResolution = 0.;
+			if (cJSON_bItemValid(curObj, "Position Resolution", cJSON_Number)
+					&& cJSON_GetObjectItem(curObj, "Position Resolution")->valuedouble
+							>= 0.) {
+				curSpec->actorSpec[curArrayItem].posResolution =
+						cJSON_GetObjectItem(curObj, "Position Resolution")->valuedouble;
+			} else if (cJSON_GetObjectItem(curObj,
+					"Position Resolution") != NULL) {
+				bWarn = true;
+				printf(
+						"WARNING %d: Actor %d does not have a valid \"Position Resolution\". Assigning default value \"0\" (exact positions).\n",
+						numWarn++, curArrayItem);
+			}
+		}
+	}
+
+	// Optional sweep of seeds and parameters in one call of AcCoRD
+	curSpec->VARIANT_LABEL = NULL;
+	curSpec->sweep.outputName = NULL;
+	curSpec->sweep.numSeed = 0;
+	curSpec->sweep.seed = NULL;
+	curSpec->sweep.numVariant = 0;
+	curSpec->sweep.variant = NULL;
+	curSpec->sweep.base.label = NULL;
+	curSpec->sweep.base.DIFF_COEF = NULL;
+	curSpec->sweep.base.rxnRate = NULL;
+	curSpec->sweep.base.modStrength = NULL;
+	curSpec->sweep.base.startTime = NULL;
+	if (cJSON_bItemValid(configJSON, "Sweep", cJSON_Object)) {
+		sweepSpec = cJSON_GetObjectItem(configJSON, "Sweep");
+		if (cJSON_bItemValid(configJSON, "Output Filename", cJSON_String)
+				&& strlen(
+						cJSON_GetObjectItem(configJSON, "Output Filename")->valuestring)
+						> 0)
+			curSpec->sweep.outputName = stringWrite(
+					cJSON_GetObjectItem(configJSON, "Output Filename")->valuestring);
+		else
+			curSpec->sweep.outputName = stringWrite("test");
+
+		if (cJSON_bItemValid(sweepSpec, "Seeds", cJSON_Array)
+				&& cJSON_GetArraySize(cJSON_GetObjectItem(sweepSpec, "Seeds"))
+						> 0) {
+			curObj = cJSON_GetObjectItem(sweepSpec, "Seeds");
+			arrayLen = cJSON_GetArraySize(curObj);
+			curSpec->sweep.seed = malloc(arrayLen * sizeof(uint32_t));
+			if (curSpec->sweep.seed == NULL) {
+				fprintf(stderr,
+						"ERROR: Memory could not be allocated to store the seeds of the sweep\n");
+				exit(EXIT_FAILURE);
+			}
+			for (curArrayItem = 0; curArrayItem < arrayLen; curArrayItem++) {
+				if (!cJSON_bArrayItemValid(curObj, curArrayItem, cJSON_Number)
+						|| cJSON_GetArrayItem(curObj, curArrayItem)->valueint
+								< 0) {
+					bWarn = true;
+					printf(
+							"WARNING %d: \"Seeds\" item %d of \"Sweep\" is not a valid seed. Ignoring it.\n",
+							numWarn++, curArrayItem);
+				} else {
+					curSpec->sweep.seed[curSpec->sweep.numSeed++] =
+							cJSON_GetArrayItem(curObj, curArrayItem)->valueint;
+				}
+			}
+		} else if (cJSON_GetObjectItem(sweepSpec, "Seeds") != NULL) {
+			bWarn = true;
+			printf(
+					"WARNING %d: \"Seeds\" of \"Sweep\" has an invalid value. Only seed \"%u\" will be simulated.\n",
+					numWarn++, curSpec->SEED);
+		}
+
+		if (cJSON_bItemValid(sweepSpec, "Variants", cJSON_Array)
+				&& cJSON_GetArraySize(cJSON_GetObjectItem(sweepSpec, "Variants"))
+						> 0) {
+			curObjInner = cJSON_GetObjectItem(sweepSpec, "Variants");
+			arrayLen = cJSON_GetArraySize(curObjInner);
+			curSpec->sweep.variant = malloc(
+					arrayLen * sizeof(struct sweepVariant));
+			if (curSpec->sweep.variant == NULL) {
+				fprintf(stderr,
+						"ERROR: Memory could not be allocated to store the variants of the sweep\n");
+				exit(EXIT_FAILURE);
+			}
+			curSpec->sweep.numVariant = arrayLen;
+			for (curArrayItem = 0; curArrayItem < arrayLen; curArrayItem++) {
+				curVariant = &curSpec->sweep.variant[curArrayItem];
+				if (!cJSON_bArrayItemValid(curObjInner, curArrayItem,
+						cJSON_Object)) {
+					bWarn = true;
+					printf(
+							"WARNING %d: Variant %d of \"Sweep\" is not an object. It will use the parameters of the configuration.\n",
+							numWarn++, curArrayItem);
+					curObj = NULL;
+				} else
+					curObj = cJSON_GetArrayItem(curObjInner, curArrayItem);
+
+				// Label must be unique because it names the output files
+				curVariant->label = NULL;
+				if (curObj != NULL
+						&& cJSON_bItemValid(curObj, "Label", cJSON_String)
+						&& strlen(cJSON_GetObjectItem(curObj, "Label")->valuestring)
+								> 0) {
+					curVariant->label = stringWrite(
+							cJSON_GetObjectItem(curObj, "Label")->valuestring);
+					for (i = 0; i < curArrayItem; i++) {
+						if (strcmp(curVariant->label,
+								curSpec->sweep.variant[i].label) == 0) {
+							free(curVariant->label);
+							curVariant->label = NULL;
+							break;
+						}
+					}
+				}
+				if (curVariant->label == NULL) {
+					curVariant->label = stringAllocate(15);
+					sprintf(curVariant->label, "V%d", curArrayItem);
+					if (curObj != NULL) {
+						bWarn = true;
+						printf(
+								"WARNING %d: Variant %d of \"Sweep\" does not have a valid and unique \"Label\". Assigning default value \"%s\".\n",
+								numWarn++, curArrayItem, curVariant->label);
+					}
+				}
+
+				curVariant->DIFF_COEF = loadSweepArray(curObj,
+						"Diffusion Coefficients", curSpec->NUM_MOL_TYPES, 0.,
+						curArrayItem, &bWarn, &numWarn);
+				curVariant->rxnRate = loadSweepArray(curObj, "Reaction Rates",
+						curSpec->MAX_RXNS, 0., curArrayItem, &bWarn, &numWarn);
+				curVariant->modStrength = loadSweepArray(curObj,
+						"Modulation Strengths", curSpec->NUM_ACTORS, 0.,
+						curArrayItem, &bWarn, &numWarn);
+				curVariant->startTime = loadSweepArray(curObj,
+						"Actor Start Times", curSpec->NUM_ACTORS, -INFINITY,
+						curArrayItem, &bWarn, &numWarn);
+
+				// Active actors need a positive modulation strength
+				if (curVariant->modStrength != NULL) {
+					for (i = 0; i < curSpec->NUM_ACTORS; i++) {
+						if (curSpec->actorSpec[i].bActive
+								&& curVariant->modStrength[i] <= 0.) {
+							bWarn = true;
+							printf(
+									"WARNING %d: \"Modulation Strengths\" of variant %d of \"Sweep\" has an invalid value for active actor %d. Using the values of the configuration.\n",
+									numWarn++, curArrayItem, i);
+							free(curVariant->modStrength);
+							curVariant->modStrength = NULL;
+							break;
+						}
+					}
+				}
+			}
+
+			// Record values of the configuration so that each variant only
+			// changes what it defines
+			curSpec->sweep.base.DIFF_COEF = malloc(
+					curSpec->NUM_MOL_TYPES * sizeof(double));
+			curSpec->sweep.base.rxnRate = malloc(
+					curSpec->MAX_RXNS * sizeof(double));
+			curSpec->sweep.base.modStrength = malloc(
+					curSpec->NUM_ACTORS * sizeof(double));
+			curSpec->sweep.base.startTime = malloc(
+					curSpec->NUM_ACTORS * sizeof(double));
+			if (curSpec->sweep.base.DIFF_COEF == NULL
+					|| (curSpec->MAX_RXNS > 0
+							&& curSpec->sweep.base.rxnRate == NULL)
+					|| curSpec->sweep.base.modStrength == NULL
+					|| curSpec->sweep.base.startTime == NULL) {
+				fprintf(stderr,
+						"ERROR: Memory could not be allocated to store the parameters of the sweep\n");
+				exit(EXIT_FAILURE);
+			}
+			for (curMolType = 0; curMolType < curSpec->NUM_MOL_TYPES;
+					curMolType++)
+				curSpec->sweep.base.DIFF_COEF[curMolType] =
+						curSpec->DIFF_COEF[curMolType];
+			for (i = 0; i < curSpec->MAX_RXNS; i++)
+				curSpec->sweep.base.rxnRate[i] = curSpec->chem_rxn[i].k;
+			for (i = 0; i < curSpec->NUM_ACTORS; i++) {
+				curSpec->sweep.base.modStrength[i] =
+						curSpec->actorSpec[i].bActive ?
+								curSpec->actorSpec[i].modStrength : 0.;
+				curSpec->sweep.base.startTime[i] =
+						curSpec->actorSpec[i].startTime;
+			}
+		} else if (cJSON_GetObjectItem(sweepSpec, "Variants") != NULL) {
+			bWarn = true;
+			printf(
+					"WARNING %d: \"Variants\" of \"Sweep\" has an invalid value. Only the parameters of the configuration will be simulated.\n",
+					numWarn++);
 		}
+	} else if (cJSON_GetObjectItem(configJSON, "Sweep") != NULL) {
+		bWarn = true;
+		printf(
+				"WARNING %d: \"Sweep\" has an invalid value. Only one simulation will be run.\n",
+				numWarn++);
 	}
 
 	// Cleanup
@@ -1851,11 +2215,36 @@ void loadConfig(const char * CONFIG_NAME, uint32_t customSEED,
 void deleteConfig(struct simSpec3D curSpec) {
 	unsigned short curRegion, curActor;
 	unsigned short curRxn;
+	unsigned int curVariant;
 
 	if (curSpec.DIFF_COEF != NULL)
 		free(curSpec.DIFF_COEF);
 	if (curSpec.OUTPUT_NAME != NULL)
 		free(curSpec.OUTPUT_NAME);
+	if (curSpec.TELEMETRY_NAME != NULL)
+		free(curSpec.TELEMETRY_NAME);
+	if (curSpec.GEOMETRY_CACHE_DIR != NULL)
+		free(curSpec.GEOMETRY_CACHE_DIR);
+
+	if (curSpec.sweep.outputName != NULL) {
+		free(curSpec.sweep.outputName);
+		if (curSpec.sweep.seed != NULL)
+			free(curSpec.sweep.seed);
+		for (curVariant = 0; curVariant < curSpec.sweep.numVariant;
+				curVariant++) {
+			free(curSpec.sweep.variant[curVariant].label);
+			free(curSpec.sweep.variant[curVariant].DIFF_COEF);
+			free(curSpec.sweep.variant[curVariant].rxnRate);
+			free(curSpec.sweep.variant[curVariant].modStrength);
+			free(curSpec.sweep.variant[curVariant].startTime);
+		}
+		if (curSpec.sweep.variant != NULL)
+			free(curSpec.sweep.variant);
+		free(curSpec.sweep.base.DIFF_COEF);
+		free(curSpec.sweep.base.rxnRate);
+		free(curSpec.sweep.base.modStrength);
+		free(curSpec.sweep.base.startTime);
+	}
 
 	if (curSpec.chem_rxn != NULL) {
 		for (curRxn = 0; curRxn < curSpec.MAX_RXNS; curRxn++) {
@@ -1885,6 +2274,8 @@ void deleteConfig(struct simSpec3D curSpec) {
 				free(curSpec.subvol_spec[curRegion].label);
 			if (curSpec.subvol_spec[curRegion].parent != NULL)
 				free(curSpec.subvol_spec[curRegion].parent);
+			if (curSpec.subvol_spec[curRegion].flowFieldFile != NULL)
+				free(curSpec.subvol_spec[curRegion].flowFieldFile);
 		}
 		free(curSpec.subvol_spec);
 	}
@@ -1908,6 +2299,8 @@ void deleteConfig(struct simSpec3D curSpec) {
 			if (curSpec.actorSpec[curActor].bActive) {
 				if (curSpec.actorSpec[curActor].bReleaseMol != NULL)
 					free(curSpec.actorSpec[curActor].bReleaseMol);
+				if (curSpec.actorSpec[curActor].bitSequenceFile != NULL)
+					free(curSpec.actorSpec[curActor].bitSequenceFile);
 			} else {
 				if (curSpec.actorSpec[curActor].bRecordMol != NULL)
 					free(curSpec.actorSpec[curActor].bRecordMol);
@@ -1919,6 +2312,115 @@ void deleteConfig(struct simSpec3D curSpec) {
 	}
 }
 
+// Number of simulations in the sweep of a configuration (1 if no sweep)
+unsigned int numSweepRun(const struct simSpec3D * curSpec) {
+	if (curSpec->sweep.outputName == NULL)
+		return 1;
+	return (curSpec->sweep.numSeed > 0 ? curSpec->sweep.numSeed : 1)
+			* (curSpec->sweep.numVariant > 0 ? curSpec->sweep.numVariant : 1);
+}
+
+// Set the seed, output name, and parameters of one simulation of a sweep
+void applySweepRun(struct simSpec3D * curSpec, const unsigned int curRun) {
+	const struct sweepSpec * sweep = &curSpec->sweep;
+	const struct sweepVariant * curVariant;
+	unsigned int numSeed;
+	unsigned short curMolType, curRxn;
+	short curActor;
+
+	if (sweep->outputName == NULL)
+		return; // There is no sweep
+
+	// Every variant is simulated with every seed
+	numSeed = (sweep->numSeed > 0) ? sweep->numSeed : 1;
+	if (sweep->numSeed > 0)
+		curSpec->SEED = sweep->seed[curRun % numSeed];
+
+	if (sweep->numVariant > 0) {
+		curVariant = &sweep->variant[curRun / numSeed];
+		curSpec->VARIANT_LABEL = curVariant->label;
+		for (curMolType = 0; curMolType < curSpec->NUM_MOL_TYPES; curMolType++)
+			curSpec->DIFF_COEF[curMolType] =
+					(curVariant->DIFF_COEF != NULL) ?
+							curVariant->DIFF_COEF[curMolType] :
+							sweep->base.DIFF_COEF[curMolType];
+		for (curRxn = 0; curRxn < curSpec->MAX_RXNS; curRxn++)
+			curSpec->chem_rxn[curRxn].k =
+					(curVariant->rxnRate != NULL) ?
+							curVariant->rxnRate[curRxn] :
+							sweep->base.rxnRate[curRxn];
+		for (curActor = 0; curActor < curSpec->NUM_ACTORS; curActor++) {
+			if (curSpec->actorSpec[curActor].bActive)
+				curSpec->actorSpec[curActor].modStrength =
+						(curVariant->modStrength != NULL) ?
+								curVariant->modStrength[curActor] :
+								sweep->base.modStrength[curActor];
+			curSpec->actorSpec[curActor].startTime =
+					(curVariant->startTime != NULL) ?
+							curVariant->startTime[curActor] :
+							sweep->base.startTime[curActor];
+		}
+	}
+
+	// Output of each simulation has its own name
+	free(curSpec->OUTPUT_NAME);
+	if (curSpec->VARIANT_LABEL != NULL) {
+		curSpec->OUTPUT_NAME = stringAllocate(
+				strlen(sweep->outputName) + strlen(curSpec->VARIANT_LABEL)
+						+ 16);
+		sprintf(curSpec->OUTPUT_NAME, "%s_%s_SEED%d", sweep->outputName,
+				curSpec->VARIANT_LABEL, curSpec->SEED);
+	} else {
+		curSpec->OUTPUT_NAME = stringAllocate(strlen(sweep->outputName) + 15);
+		sprintf(curSpec->OUTPUT_NAME, "%s_SEED%d", sweep->outputName,
+				curSpec->SEED);
+	}
+}
+
+// Read an array of numbers that a sweep variant uses instead of parameters of
+// the configuration. Returns NULL if the array is not defined or is invalid
+static double * loadSweepArray(cJSON * variantJSON, const char * name,
+		const int length, const double minValue, const int curVariant,
+		bool * bWarn, int * numWarn) {
+	cJSON * curArray;
+	double * values;
+	int curItem;
+
+	if (variantJSON == NULL || cJSON_GetObjectItem(variantJSON, name) == NULL)
+		return NULL; // Variant uses the values of the configuration
+
+	curArray = cJSON_GetObjectItem(variantJSON, name);
+	if (!cJSON_bItemValid(variantJSON, name, cJSON_Array)
+			|| cJSON_GetArraySize(curArray) != length) {
+		*bWarn = true;
+		printf(
+				"WARNING %d: \"%s\" of variant %d of \"Sweep\" is not an array of correct length. Using the values of the configuration.\n",
+				(*numWarn)++, name, curVariant);
+		return NULL;
+	}
+
+	values = malloc(length * sizeof(double));
+	if (length > 0 && values == NULL) {
+		fprintf(stderr,
+				"ERROR: Memory could not be allocated to store the parameters of the sweep\n");
+		exit(EXIT_FAILURE);
+	}
+	for (curItem = 0; curItem < length; curItem++) {
+		if (!cJSON_bArrayItemValid(curArray, curItem, cJSON_Number)
+				|| cJSON_GetArrayItem(curArray, curItem)->valuedouble
+						< minValue) {
+			*bWarn = true;
+			printf(
+					"WARNING %d: \"%s\" item %d of variant %d of \"Sweep\" has an invalid value. Using the values of the configuration.\n",
+					(*numWarn)++, name, curItem, curVariant);
+			free(values);
+			return NULL;
+		}
+		values[curItem] = cJSON_GetArrayItem(curArray, curItem)->valuedouble;
+	}
+	return values;
+}
+
 // Initialize the simulation output file
 void initializeOutput(FILE ** out, FILE ** outSummary, const char * CONFIG_NAME,
 		const struct simSpec3D curSpec) {
@@ -1970,7 +2472,7 @@ void initializeOutput(FILE ** out, FILE ** outSummary, const char * CONFIG_NAME,
 	}
 
 	nameLength = strlen(curSpec.OUTPUT_NAME);
-	outputNameFull = malloc(dirLength + nameLength + 5);
+	outputNameFull = malloc(dirLength + nameLength + 8);
 	outputSummaryNameFull = malloc(dirLength + nameLength + 23);
 	if (outputNameFull == NULL || outputSummaryNameFull == NULL) {
 		fprintf(stderr,
@@ -1989,13 +2491,16 @@ void initializeOutput(FILE ** out, FILE ** outSummary, const char * CONFIG_NAME,
 	strcat(outputNameFull, curSpec.OUTPUT_NAME);
 	strcat(outputSummaryNameFull, outputNameFull);
 	strcat(outputNameFull, ".txt");
+	if (curSpec.OUTPUT_CODEC == OUTPUT_CODEC_DEFLATE)
+		strcat(outputNameFull, ".gz");
 	strcat(outputSummaryNameFull, "_summary.txt");
 
 	printf("Simulation output will be written to \"%s\".\n", outputNameFull);
 	printf("Simulation summary will be written to \"%s\".\n",
 			outputSummaryNameFull);
 
-	if ((*out = fopen(outputNameFull, "w")) == NULL) {
+	if ((*out = fopen(outputNameFull,
+			(curSpec.OUTPUT_CODEC == OUTPUT_CODEC_NONE) ? "w" : "wb")) == NULL) {
 		fprintf(stderr, "ERROR: Cannot create output file \"%s\".\n",
 				outputNameFull);
 		exit(EXIT_FAILURE);
@@ -2009,8 +2514,12 @@ void initializeOutput(FILE ** out, FILE ** outSummary, const char * CONFIG_NAME,
 	root = cJSON_CreateObject();
 	cJSON_AddStringToObject(root, "ConfigFile", CONFIG_NAME);
 	cJSON_AddNumberToObject(root, "SEED", curSpec.SEED);
+	if (curSpec.VARIANT_LABEL != NULL)
+		cJSON_AddStringToObject(root, "Variant", curSpec.VARIANT_LABEL);
 	cJSON_AddNumberToObject(root, "NumRepeat", curSpec.NUM_REPEAT);
 	cJSON_AddStringToObject(root, "StartTime", timeBuffer);
+	cJSON_AddStringToObject(root, "OutputCodec",
+			(curSpec.OUTPUT_CODEC == OUTPUT_CODEC_DEFLATE) ? "Deflate" : "None");
 
 	outText = cJSON_Print(root);
 	fprintf(*outSummary, "%s", outText);
@@ -2043,35 +2552,34 @@ char * stringAllocate(long stringLength) {
 
 // Print simulation output from one realization
 void printOneTextRealization(FILE * out, const struct simSpec3D curSpec,
-		unsigned int curRepeat, ListObs3D observationArray[],
+		const struct realizationOutput * result,
 		short numActorRecord, short * actorRecordID, short NUM_ACTORS_ACTIVE,
 		const struct actorStruct3D actorCommonArray[],
 		const struct actorActiveStruct3D actorActiveArray[],
 		const struct actorPassiveStruct3D actorPassiveArray[],
-		uint32_t maxActiveBits[], uint32_t maxPassiveObs[]) {
+		uint32_t maxActiveBits[], uint32_t maxPassiveObs[],
+		uint32_t maxAbsorbCount[]) {
 	short curActor, curActorPassive, curActorRecord, curActorActive;
 	char * outText;
-	NodeData * curData;
+	uint64_t curBit;
 	NodeObs3D * curObs;
 	unsigned short curMolInd, curMolType;
-	ListMol3D * curMolList;
-	NodeMol3D * curMolNode;
+	const struct molPosBuffer3D * curMolPos;
+	uint64_t curPos, lastPos, curByte;
 	uint32_t curActiveBits, curPassiveObs;
 
-	fprintf(out, "Realization %u:\n", curRepeat);
+	fprintf(out, "Realization %u:\n", result->curRepeat);
 
 	// Record active actor binary data
 	for (curActorActive = 0; curActorActive < NUM_ACTORS_ACTIVE;
 			curActorActive++) {
-		curData = actorActiveArray[curActorActive].binaryData.head;
 		curActor = actorActiveArray[curActorActive].actorID;
-		curActiveBits = 0;
+		curActiveBits = (uint32_t) result->binaryData[curActorActive].numBit;
 		fprintf(out, "\tActiveActor %u:\n\t\t", curActor);
-		while (curData != NULL) {
-			fprintf(out, "%u ", curData->item.bit);
-			curData = curData->next;
-			curActiveBits++;
-		}
+		for (curBit = 0; curBit < curActiveBits; curBit++)
+			fprintf(out, "%u ",
+					(unsigned int) readBits(&result->binaryData[curActorActive],
+							curBit, 1));
 		fprintf(out, "\n");
 
 		if (curActiveBits > maxActiveBits[curActorActive])
@@ -2083,9 +2591,20 @@ void printOneTextRealization(FILE * out, const struct simSpec3D curSpec,
 			curActorRecord++) {
 		// Actor in common actor list is actorRecordID[curActorRecord]
 		curActor = actorRecordID[curActorRecord];
-		curObs = (&observationArray[curActorRecord])->head;
+		curObs = result->observationArray[curActorRecord].head;
 		fprintf(out, "\tPassiveActor %u:\n", curActor);
 
+		curActorPassive = actorCommonArray[curActor].passiveID;
+		if (result->absorbLog[curActorPassive] != NULL) {
+			// Actor logs captured molecules instead of making observations
+			printAbsorptionLog(out, &actorCommonArray[curActor],
+					&actorPassiveArray[curActorPassive],
+					result->absorbLog[curActorPassive],
+					result->molPosBuffer[curActorPassive],
+					&maxAbsorbCount[curActorRecord]);
+			continue;
+		}
+
 		// Preliminary scan to find number of observations and compare
 		// with largest number of observations made thus far in any realization
 		curPassiveObs = 0;
@@ -2097,7 +2616,7 @@ void printOneTextRealization(FILE * out, const struct simSpec3D curSpec,
 			maxPassiveObs[curActorRecord] = curPassiveObs;
 
 		// Record actor observation times (if being recorded)
-		curObs = (&observationArray[curActorRecord])->head;
+		curObs = result->observationArray[curActorRecord].head;
 		if (actorCommonArray[curActor].spec.bRecordTime) {
 			fprintf(out, "\t\tTime:\n\t\t\t");
 			while (curObs != NULL) {
@@ -2108,7 +2627,6 @@ void printOneTextRealization(FILE * out, const struct simSpec3D curSpec,
 		}
 
 		// Record observations associated with each type of molecule being recorded
-		curActorPassive = actorCommonArray[curActor].passiveID;
 		for (curMolInd = 0;
 				curMolInd < actorPassiveArray[curActorPassive].numMolRecordID;
 				curMolInd++) {
@@ -2117,7 +2635,7 @@ void printOneTextRealization(FILE * out, const struct simSpec3D curSpec,
 			fprintf(out, "\t\tMolID %u:\n\t\t\tCount:\n\t\t\t\t", curMolType);
 
 			// Record molecule counts made by observer
-			curObs = (&observationArray[curActorRecord])->head;
+			curObs = result->observationArray[curActorRecord].head;
 			while (curObs != NULL) {
 				fprintf(out, "%" PRIu64 " ", curObs->item.paramUllong[curMolInd]);
 				curObs = curObs->next;
@@ -2126,20 +2644,35 @@ void printOneTextRealization(FILE * out, const struct simSpec3D curSpec,
 
 			// Record molecule coordinates if specified
 			if (actorCommonArray[curActor].spec.bRecordPos[curMolType]) {
-				curObs = (&observationArray[curActorRecord])->head;
+				curObs = result->observationArray[curActorRecord].head;
+				curMolPos = &result->molPosBuffer[curActorPassive][curMolInd];
 				fprintf(out, "\t\t\tPosition:");
 				while (curObs != NULL) {
 					fprintf(out, "\n\t\t\t\t");
 					// Each observation will have the positions of some number of molecules
 					fprintf(out, "(");
-					curMolList = curObs->item.molPos[curMolInd];
-					if (!isListMol3DEmpty(curMolList)) {
-						curMolNode = *curMolList;
-						while (curMolNode != NULL) {
-							fprintf(out, "(%e, %e, %e) ", curMolNode->item.x,
-									curMolNode->item.y, curMolNode->item.z);
-							curMolNode = curMolNode->next;
+					if (actorPassiveArray[curActorPassive].posQuant != NULL) {
+						// Positions are quantized. Print their encoded
+						// differences as integers
+						curByte = curObs->item.molPos[curMolInd].offset;
+						for (curPos = 0;
+								curPos < curObs->item.molPos[curMolInd].count;
+								curPos++) {
+							fprintf(out, "%" PRIu64 " ",
+									readPosCode(curMolPos->code, &curByte));
 						}
+						fprintf(out, ")");
+						curObs = curObs->next;
+						continue;
+					}
+					// Positions are read directly from the actor's buffer
+					lastPos = curObs->item.molPos[curMolInd].offset
+							+ curObs->item.molPos[curMolInd].count;
+					for (curPos = curObs->item.molPos[curMolInd].offset;
+							curPos < lastPos; curPos++) {
+						fprintf(out, "(%e, %e, %e) ", curMolPos->coor[3*curPos],
+								curMolPos->coor[3*curPos + 1],
+								curMolPos->coor[3*curPos + 2]);
 					}
 					fprintf(out, ")");
 					curObs = curObs->next;
@@ -2151,21 +2684,115 @@ void printOneTextRealization(FILE * out, const struct simSpec3D curSpec,
 	fprintf(out, "\n");
 }
 
+// Print the molecules captured inside one passive actor in one realization
+// Each recorded molecule type lists the number of captures, the capture times,
+// and (if specified) the capture positions
+void printAbsorptionLog(FILE * out, const struct actorStruct3D * actorCommon,
+		const struct actorPassiveStruct3D * actorPassive,
+		const struct absorptionLog3D absorbLog[],
+		const struct molPosBuffer3D molPosBuffer[],
+		uint32_t * maxAbsorbCount) {
+	unsigned short curMolInd, curMolType;
+	const struct absorptionLog3D * curLog;
+	const double * curCoor;
+	uint64_t curEvent;
+
+	for (curMolInd = 0; curMolInd < actorPassive->numMolRecordID;
+			curMolInd++) {
+		curMolType = actorPassive->molRecordID[curMolInd];
+		curLog = &absorbLog[curMolInd];
+		fprintf(out, "\t\tMolID %u:\n\t\t\tAbsorption Count:\n\t\t\t\t%" PRIu64 "\n",
+				curMolType, curLog->numEvent);
+		if (curLog->numEvent > *maxAbsorbCount)
+			*maxAbsorbCount = (uint32_t) curLog->numEvent;
+
+		fprintf(out, "\t\t\tAbsorption Time:\n\t\t\t\t");
+		for (curEvent = 0; curEvent < curLog->numEvent; curEvent++)
+			fprintf(out, "%e ", curLog->time[curEvent]);
+		fprintf(out, "\n");
+
+		if (actorCommon->spec.bRecordPos[curMolType]) {
+			curCoor = molPosBuffer[curMolInd].coor;
+			fprintf(out, "\t\t\tPosition:\n\t\t\t\t(");
+			for (curEvent = 0; curEvent < curLog->numEvent; curEvent++) {
+				fprintf(out, "(%e, %e, %e) ", curCoor[3*curEvent],
+						curCoor[3*curEvent + 1], curCoor[3*curEvent + 2]);
+			}
+			fprintf(out, ")\n");
+		}
+	}
+}
+
+// Compress the first chunkLength bytes of chunk and append them to out as one
+// gzip member, which can be decompressed independently of the rest of out
+void writeCompressedChunk(FILE * out, FILE * chunk, long chunkLength) {
+#ifdef ACCORD_USE_ZLIB
+	unsigned char inBuffer[COMPRESS_BUFFER_SIZE];
+	unsigned char outBuffer[COMPRESS_BUFFER_SIZE];
+	z_stream stream;
+	size_t numRead, numWrite;
+	int flush;
+
+	stream.zalloc = Z_NULL;
+	stream.zfree = Z_NULL;
+	stream.opaque = Z_NULL;
+	// Window bits of 15 + 16 write a gzip header and trailer
+	if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+			Z_DEFAULT_STRATEGY) != Z_OK) {
+		fprintf(stderr, "ERROR: Output compression could not be started.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	rewind(chunk);
+	do {
+		numRead = fread(inBuffer, 1,
+				(chunkLength < COMPRESS_BUFFER_SIZE) ?
+						(size_t) chunkLength : COMPRESS_BUFFER_SIZE, chunk);
+		chunkLength -= (long) numRead;
+		flush = (chunkLength <= 0 || numRead == 0) ? Z_FINISH : Z_NO_FLUSH;
+		stream.next_in = inBuffer;
+		stream.avail_in = (uInt) numRead;
+		do {
+			stream.next_out = outBuffer;
+			stream.avail_out = COMPRESS_BUFFER_SIZE;
+			deflate(&stream, flush);
+			numWrite = COMPRESS_BUFFER_SIZE - stream.avail_out;
+			if (fwrite(outBuffer, 1, numWrite, out) != numWrite) {
+				fprintf(stderr, "ERROR: Compressed output could not be written.\n");
+				exit(EXIT_FAILURE);
+			}
+		} while (stream.avail_out == 0);
+	} while (flush != Z_FINISH);
+
+	deflateEnd(&stream);
+#else
+	(void) out; // Unused without zlib
+	(void) chunk;
+	(void) chunkLength;
+	fprintf(stderr, "ERROR: AcCoRD was built without zlib. Output cannot be compressed.\n");
+	exit(EXIT_FAILURE);
+#endif // ACCORD_USE_ZLIB
+}
+
 // Print end of simulation data
 void printTextEnd(FILE * out, short NUM_ACTORS_ACTIVE, short numActorRecord,
 		const struct actorStruct3D actorCommonArray[],
 		const struct actorActiveStruct3D actorActiveArray[],
 		const struct actorPassiveStruct3D actorPassiveArray[],
 		short * actorRecordID, uint32_t maxActiveBits[],
-		uint32_t maxPassiveObs[]) {
+		uint32_t maxPassiveObs[], uint32_t maxAbsorbCount[],
+		unsigned short OUTPUT_CODEC,
+		unsigned int numChunk, const uint64_t chunkOffset[]) {
 	time_t timer;
 	char timeBuffer[26];
 	struct tm* timeInfo;
 	short curActor, curPassive, curActorRecord;
 	cJSON * root;
 	cJSON * curArray, *curItem, *newItem, *newActor, *innerArray;
+	const struct posQuantizer * curQuant;
 	char * outText;
 	unsigned short curMolInd;
+	unsigned int curChunk;
 
 	time(&timer);
 	timeInfo = localtime(&timer);
@@ -2174,6 +2801,15 @@ void printTextEnd(FILE * out, short NUM_ACTORS_ACTIVE, short numActorRecord,
 
 	root = cJSON_CreateObject();
 
+	// Store the position of each realization in a compressed output file
+	if (OUTPUT_CODEC != OUTPUT_CODEC_NONE) {
+		cJSON_AddItemToObject(root, "ChunkOffset", curArray =
+				cJSON_CreateArray());
+		for (curChunk = 0; curChunk < numChunk; curChunk++)
+			cJSON_AddItemToArray(curArray,
+					cJSON_CreateNumber((double) chunkOffset[curChunk]));
+	}
+
 	// Store information about the active actors
 	cJSON_AddNumberToObject(root, "NumberActiveActor", NUM_ACTORS_ACTIVE);
 	cJSON_AddItemToObject(root, "ActiveInfo", curArray = cJSON_CreateArray());
@@ -2198,9 +2834,24 @@ void printTextEnd(FILE * out, short NUM_ACTORS_ACTIVE, short numActorRecord,
 		cJSON_AddNumberToObject(newActor, "ID", curActor);
 		cJSON_AddNumberToObject(newActor, "bRecordTime",
 				actorCommonArray[curActor].spec.bRecordTime);
+		cJSON_AddNumberToObject(newActor, "bRecordAbsorb",
+				actorCommonArray[curActor].spec.bRecordAbsorb);
 		// Record maximum number of observations made by each recorded actor
 		cJSON_AddNumberToObject(newActor, "MaxCountLength",
 				maxPassiveObs[curActorRecord]);
+		// Record maximum number of molecules absorbed by each absorbing actor
+		if (actorCommonArray[curActor].spec.bRecordAbsorb)
+			cJSON_AddNumberToObject(newActor, "MaxAbsorbCount",
+					maxAbsorbCount[curActorRecord]);
+		// Record grid that positions are quantized to (if any)
+		curQuant = actorPassiveArray[curPassive].posQuant;
+		cJSON_AddNumberToObject(newActor, "PositionResolution",
+				(curQuant != NULL) ?
+						actorCommonArray[curActor].spec.posResolution : 0.);
+		if (curQuant != NULL) {
+			cJSON_AddItemToObject(newActor, "PositionOriginCell",
+					cJSON_CreateDoubleArray(curQuant->originCell, 3));
+		}
 		cJSON_AddNumberToObject(newActor, "NumMolTypeObs",
 				actorPassiveArray[curPassive].numMolRecordID);
 		cJSON_AddItemToObject(newActor, "MolObsID", innerArray =
@@ -2225,6 +2876,9 @@ void printTextEnd(FILE * out, short NUM_ACTORS_ACTIVE, short numActorRecord,
 	}
 
 	cJSON_AddStringToObject(root, "EndTime", timeBuffer);
+#ifdef ACCORD_PROFILE
+	addProfileToJSON(root, &accordProfile);
+#endif // ACCORD_PROFILE
 
 	outText = cJSON_Print(root);
 	fprintf(out, "%s", outText);
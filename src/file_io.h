@@ -9,10 +9,19 @@
  *
  * file_io.h - interface with JSON configuration files
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added logging of molecules captured by absorbing and receptor surfaces
+ * - wrote realization output on a separate thread
+ * - added optional deflate compression of the output file
+ * - added publishing of observations to a shared memory ring buffer
+ * - added periodic telemetry records
+ * - added optional cache of subvolume neighbours on disk
+ * - added seed and parameter sweeps that run in one process
+ *
  * Revision v0.5 (2016-04-15)
  * - added ability to define location of actor by a list of regions
  * - modified check on number of subvolumes along each dimension of a rectangular region
@@ -61,6 +70,9 @@
 #ifndef __linux__
 	#include <direct.h> // for _mkdir() [Windows]
 #endif // __linux__
+#ifdef ACCORD_USE_ZLIB
+	#include <zlib.h> // for deflate() [compressed output]
+#endif // ACCORD_USE_ZLIB
 #include "cJSON.h"
 #include "region.h"
 #include "actor.h"
@@ -68,14 +80,59 @@
 #include "micro_molecule.h" // for individual molecule definitions, operations
 #include "actor_data.h" // for active actor binary data
 #include "observations.h" // for observation structure (linked list)
+#include "output_writer.h" // for results of one realization
 #include "global_param.h" // for common global parameters
 
+//
+// Constant definitions
+//
+
+// Size of buffers used to compress output
+#define COMPRESS_BUFFER_SIZE 65536
+
+// Default size of shared memory output (in MiB)
+#define SHM_SIZE_DEFAULT 16
+
+// Default time between telemetry records (in seconds)
+#define TELEMETRY_INTERVAL_DEFAULT 10
+
 //
 // Data type declarations
 //
 
+/* The sweepVariant structure has the parameters that one variant of a sweep
+* changes. An array is NULL if the variant uses the value in the configuration
+*/
+struct sweepVariant {
+	char * label; // Added to the output filename
+	double * DIFF_COEF; // Diffusion coefficient of each molecule type
+	double * rxnRate; // Rate of each chemical reaction
+	double * modStrength; // Modulation strength of each actor
+	double * startTime; // Start time of each actor
+};
+
+/* The sweepSpec structure lists the simulations of a sweep. Every variant is
+* simulated with every seed, and all simulations share the same environment
+*/
+struct sweepSpec {
+	char * outputName; // "Output Filename" without the seed
+	unsigned int numSeed; // Number of seeds (0 if seed is not swept)
+	uint32_t * seed;
+	unsigned int numVariant; // Number of variants (0 if none)
+	struct sweepVariant * variant;
+	struct sweepVariant base; // Values in the configuration (if numVariant > 0)
+};
+
 struct simSpec3D {
 	char * OUTPUT_NAME;
+	unsigned short OUTPUT_CODEC; // Compression of output file
+	bool bShmOutput; // Publish observations to shared memory?
+	uint64_t SHM_SIZE; // Bytes of records in shared memory output
+	char * TELEMETRY_NAME; // File or named pipe for telemetry (NULL if none)
+	double TELEMETRY_INTERVAL; // Wall time between telemetry records (sec)
+	char * GEOMETRY_CACHE_DIR; // Directory of geometry cache (NULL if none)
+	struct sweepSpec sweep; // Simulations run by one call of AcCoRD
+	char * VARIANT_LABEL; // Label of current sweep variant (NULL if none)
 	
 	// Simulation Control
 	unsigned int NUM_REPEAT;
@@ -108,6 +165,13 @@ void loadConfig(const char * CONFIG_NAME,
 
 void deleteConfig(struct simSpec3D curSpec);
 
+// Number of simulations in the sweep of a configuration (1 if no sweep)
+unsigned int numSweepRun(const struct simSpec3D * curSpec);
+
+// Set the seed, output name, and parameters of one simulation of a sweep
+void applySweepRun(struct simSpec3D * curSpec,
+	const unsigned int curRun);
+
 void initializeOutput(FILE ** out,
 	FILE ** outSummary,
 	const char * CONFIG_NAME,
@@ -119,10 +183,11 @@ char * stringWrite(char * src);
 // Allocate memory for a string
 char * stringAllocate(long stringLength);
 
+// Print the results of one realization. Buffers of the actors are read from
+// the realization results and not from the actor structures
 void printOneTextRealization(FILE * out,
 	const struct simSpec3D curSpec,
-	unsigned int curRepeat,
-	ListObs3D observationArray[],
+	const struct realizationOutput * result,
 	short numActorRecord,
 	short * actorRecordID,
 	short NUM_ACTORS_ACTIVE,
@@ -130,7 +195,22 @@ void printOneTextRealization(FILE * out,
 	const struct actorActiveStruct3D actorActiveArray[],
 	const struct actorPassiveStruct3D actorPassiveArray[],	
 	uint32_t maxActiveBits[],
-	uint32_t maxPassiveObs[]);
+	uint32_t maxPassiveObs[],
+	uint32_t maxAbsorbCount[]);
+
+// Print the molecules captured inside one passive actor in one realization
+void printAbsorptionLog(FILE * out,
+	const struct actorStruct3D * actorCommon,
+	const struct actorPassiveStruct3D * actorPassive,
+	const struct absorptionLog3D absorbLog[],
+	const struct molPosBuffer3D molPosBuffer[],
+	uint32_t * maxAbsorbCount);
+
+// Compress the first chunkLength bytes of chunk and append them to out as one
+// gzip member, which can be decompressed independently of the rest of out
+void writeCompressedChunk(FILE * out,
+	FILE * chunk,
+	long chunkLength);
 	
 void printTextEnd(FILE * out,	
 	short NUM_ACTORS_ACTIVE,
@@ -140,6 +220,10 @@ void printTextEnd(FILE * out,
 	const struct actorPassiveStruct3D actorPassiveArray[],
 	short * actorRecordID,
 	uint32_t maxActiveBits[],
-	uint32_t maxPassiveObs[]);
+	uint32_t maxPassiveObs[],
+	uint32_t maxAbsorbCount[],
+	unsigned short OUTPUT_CODEC,
+	unsigned int numChunk,
+	const uint64_t chunkOffset[]);
 
 #endif // FILE_IO_H
\ No newline at end of file
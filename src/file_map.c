@@ -0,0 +1,160 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * file_map.c - read-only access to the entire contents of a binary file,
+ *				which is memory-mapped where possible
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifdef __linux__
+	#define _POSIX_C_SOURCE 200112L // for mmap(), open(), fstat()
+	#include <sys/mman.h> // for mmap(), munmap()
+	#include <sys/stat.h> // for fstat()
+	#include <fcntl.h> // for open()
+	#include <unistd.h> // for close()
+#endif // __linux__
+#include "file_map.h"
+
+//
+// "Private" Declarations
+//
+
+// Read the entire contents of a file into allocated memory
+static void * readFile(const char * fileName,
+	const char * fileDesc,
+	const size_t minSize,
+	size_t * fileSize);
+
+//
+// Definitions
+//
+
+// Get the entire contents of a file for reading. The file is memory-mapped
+// if possible and otherwise read into allocated memory (bMapped says which).
+// A file that cannot be opened or has fewer than minSize bytes is an error
+// that exits with a message naming the file as fileDesc (e.g., "Flow field").
+// If fileDesc is NULL, NULL is returned instead
+void * mapFile(const char * fileName,
+	const char * fileDesc,
+	const size_t minSize,
+	size_t * fileSize,
+	bool * bMapped)
+{
+#ifdef __linux__
+	int fd;
+	struct stat fileStat;
+	void * data;
+
+	fd = open(fileName, O_RDONLY);
+	if(fd < 0)
+	{
+		if(fileDesc == NULL)
+			return NULL;
+		fprintf(stderr, "ERROR: %s file \"%s\" could not be opened.\n",
+			fileDesc, fileName);
+		exit(EXIT_FAILURE);
+	}
+	if(fstat(fd, &fileStat) != 0 || fileStat.st_size < 1
+		|| (size_t) fileStat.st_size < minSize)
+	{
+		close(fd);
+		if(fileDesc == NULL)
+			return NULL;
+		fprintf(stderr, "ERROR: %s file \"%s\" could not be read.\n",
+			fileDesc, fileName);
+		exit(EXIT_FAILURE);
+	}
+	*fileSize = (size_t) fileStat.st_size;
+
+	data = mmap(NULL, *fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // Mapping stays valid
+	if(data != MAP_FAILED)
+	{
+		*bMapped = true;
+		return data;
+	}
+#endif // __linux__
+
+	*bMapped = false;
+	return readFile(fileName, fileDesc, minSize, fileSize);
+}
+
+// Release the contents of a file returned by mapFile
+void unmapFile(void * fileData,
+	const size_t fileSize,
+	const bool bMapped)
+{
+	if(fileData == NULL)
+		return;
+#ifdef __linux__
+	if(bMapped)
+	{
+		munmap(fileData, fileSize);
+		return;
+	}
+#endif // __linux__
+	free(fileData);
+}
+
+// Read the entire contents of a file into allocated memory
+static void * readFile(const char * fileName,
+	const char * fileDesc,
+	const size_t minSize,
+	size_t * fileSize)
+{
+	FILE * file;
+	long fileLength;
+	void * data;
+
+	file = fopen(fileName, "rb");
+	if(file == NULL)
+	{
+		if(fileDesc == NULL)
+			return NULL;
+		fprintf(stderr, "ERROR: %s file \"%s\" could not be opened.\n",
+			fileDesc, fileName);
+		exit(EXIT_FAILURE);
+	}
+	if(fseek(file, 0, SEEK_END) != 0 || (fileLength = ftell(file)) < 1
+		|| (size_t) fileLength < minSize || fseek(file, 0, SEEK_SET) != 0)
+	{
+		fclose(file);
+		if(fileDesc == NULL)
+			return NULL;
+		fprintf(stderr, "ERROR: %s file \"%s\" could not be read.\n",
+			fileDesc, fileName);
+		exit(EXIT_FAILURE);
+	}
+	*fileSize = (size_t) fileLength;
+
+	data = malloc(*fileSize);
+	if(data == NULL)
+	{
+		fclose(file);
+		if(fileDesc == NULL)
+			return NULL;
+		fprintf(stderr, "ERROR: Memory could not be allocated to store file \"%s\".\n",
+			fileName);
+		exit(EXIT_FAILURE);
+	}
+	if(fread(data, 1, *fileSize, file) != *fileSize)
+	{
+		free(data);
+		fclose(file);
+		if(fileDesc == NULL)
+			return NULL;
+		fprintf(stderr, "ERROR: %s file \"%s\" could not be read.\n",
+			fileDesc, fileName);
+		exit(EXIT_FAILURE);
+	}
+	fclose(file);
+	return data;
+}
@@ -0,0 +1,44 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * file_map.h - read-only access to the entire contents of a binary file,
+ *				which is memory-mapped where possible
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifndef FILE_MAP_H
+#define FILE_MAP_H
+
+#include <stdio.h> // for fopen(), fread()
+#include <stdlib.h> // for exit(), malloc, free
+#include <stdbool.h> // for C++ bool naming, requires C99
+
+//
+// Function Declarations
+//
+
+// Get the entire contents of a file for reading. The file is memory-mapped
+// if possible and otherwise read into allocated memory (bMapped says which).
+// A file that cannot be opened or has fewer than minSize bytes is an error
+// that exits with a message naming the file as fileDesc (e.g., "Flow field").
+// If fileDesc is NULL, NULL is returned instead
+void * mapFile(const char * fileName,
+	const char * fileDesc,
+	const size_t minSize,
+	size_t * fileSize,
+	bool * bMapped);
+
+// Release the contents of a file returned by mapFile
+void unmapFile(void * fileData,
+	const size_t fileSize,
+	const bool bMapped);
+
+#endif // FILE_MAP_H
@@ -0,0 +1,142 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * flow_field.c - steady flow velocity fields defined on a regular grid and
+ *				loaded from a binary file
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#include "flow_field.h"
+
+//
+// Definitions
+//
+
+// Load a flow field from a binary file
+void loadFlowField(const char * fileName,
+	struct flowField * field)
+{
+	const char * header;
+	unsigned short d;
+	size_t numValue;
+
+	field->fileData = mapFile(fileName, "Flow field", 1, &field->fileSize,
+		&field->bMapped);
+	header = (const char *) field->fileData;
+
+	if(field->fileSize < FLOW_FIELD_HEADER_SIZE
+		|| memcmp(header, FLOW_FIELD_MAGIC, 8) != 0)
+	{
+		fprintf(stderr, "ERROR: Flow field file \"%s\" does not start with a valid header.\n",
+			fileName);
+		exit(EXIT_FAILURE);
+	}
+
+	memcpy(field->numNode, header + 8, 3*sizeof(uint32_t));
+	memcpy(field->origin, header + 24, 3*sizeof(double));
+	memcpy(field->spacing, header + 48, 3*sizeof(double));
+
+	numValue = 3;
+	for(d = 0; d < 3; d++)
+	{
+		if(field->numNode[d] < 1
+			|| (field->numNode[d] > 1 && !(field->spacing[d] > 0.)))
+		{
+			fprintf(stderr, "ERROR: Flow field file \"%s\" has an invalid grid along dimension %u.\n",
+				fileName, d);
+			exit(EXIT_FAILURE);
+		}
+		field->invSpacing[d] = (field->numNode[d] > 1) ? 1./field->spacing[d] : 0.;
+		numValue *= field->numNode[d];
+	}
+
+	if(field->fileSize < FLOW_FIELD_HEADER_SIZE + numValue*sizeof(float))
+	{
+		fprintf(stderr, "ERROR: Flow field file \"%s\" is too short for a %u x %u x %u grid.\n",
+			fileName, field->numNode[0], field->numNode[1], field->numNode[2]);
+		exit(EXIT_FAILURE);
+	}
+
+	field->velocity = (const float *) (header + FLOW_FIELD_HEADER_SIZE);
+}
+
+// Free memory (or unmap file) associated with a flow field
+void deleteFlowField(struct flowField * field)
+{
+	if(field == NULL || field->fileData == NULL)
+		return;
+
+	unmapFile(field->fileData, field->fileSize, field->bMapped);
+	field->fileData = NULL;
+	field->velocity = NULL;
+}
+
+// Find the flow velocity at a point by trilinear interpolation of the grid.
+// Velocity is zero outside of the grid. A dimension with a single node is
+// treated as having constant velocity along that dimension
+void sampleFlowField(const struct flowField * field,
+	const double point[3],
+	double velocity[3])
+{
+	unsigned short d, corner;
+	uint32_t ind[3];
+	double frac[3];
+	double coor, weight;
+	size_t stride[3];
+	size_t base, offset;
+
+	velocity[0] = 0.;
+	velocity[1] = 0.;
+	velocity[2] = 0.;
+
+	for(d = 0; d < 3; d++)
+	{
+		if(field->numNode[d] < 2)
+		{
+			ind[d] = 0;
+			frac[d] = 0.;
+			continue;
+		}
+		coor = (point[d] - field->origin[d]) * field->invSpacing[d];
+		if(!(coor >= 0. && coor <= field->numNode[d] - 1))
+			return; // Point is outside of grid (or invalid)
+		ind[d] = (uint32_t) coor;
+		if(ind[d] > field->numNode[d] - 2)
+			ind[d] = field->numNode[d] - 2; // Point is on upper edge of grid
+		frac[d] = coor - ind[d];
+	}
+
+	stride[0] = 3;
+	stride[1] = 3 * (size_t) field->numNode[0];
+	stride[2] = stride[1] * field->numNode[1];
+	base = ind[0]*stride[0] + ind[1]*stride[1] + ind[2]*stride[2];
+
+	// Weighted sum of the 8 surrounding nodes
+	for(corner = 0; corner < 8; corner++)
+	{
+		weight = 1.;
+		offset = base;
+		for(d = 0; d < 3; d++)
+		{
+			if(corner & (1 << d))
+			{
+				weight *= frac[d];
+				offset += stride[d];
+			} else
+				weight *= 1. - frac[d];
+		}
+		if(weight == 0.)
+			continue; // Also avoids reading past a single-node dimension
+		velocity[0] += weight * field->velocity[offset];
+		velocity[1] += weight * field->velocity[offset + 1];
+		velocity[2] += weight * field->velocity[offset + 2];
+	}
+}
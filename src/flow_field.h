@@ -0,0 +1,89 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * flow_field.h - steady flow velocity fields defined on a regular grid and
+ *				loaded from a binary file
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <stdio.h> // for fprintf()
+#include <stdlib.h> // for exit(), malloc, free
+#include <stdbool.h> // for C++ bool naming, requires C99
+#include <stdint.h> // for uint32_t
+#include <string.h> // for memcmp()
+#include <math.h> // for floor()
+#include "file_map.h" // for reading flow field files
+
+//
+// Constant definitions
+//
+
+// Flow field file layout (all values in native byte order):
+// char[8]		magic string FLOW_FIELD_MAGIC (no terminating null)
+// uint32_t[3]	number of grid nodes along x, y, and z
+// uint32_t		reserved (write 0)
+// double[3]	coordinates of the first grid node (meters)
+// double[3]	spacing between grid nodes along x, y, and z (meters)
+// float[]		velocity (vx, vy, vz) of each node in meters per second.
+//				Node (i,j,k) starts at float index 3*((k*numY + j)*numX + i),
+//				i.e., x varies fastest
+#define FLOW_FIELD_MAGIC "ACFLOW01"
+#define FLOW_FIELD_HEADER_SIZE 72
+
+//
+// Data Type Declarations
+//
+
+/* The flowField structure describes one velocity field. The velocity values
+* are read directly from the file contents, which are memory-mapped where
+* possible.
+*/
+struct flowField {
+	// Number of grid nodes along each dimension
+	uint32_t numNode[3];
+
+	// Coordinates of the first grid node
+	double origin[3];
+
+	// Distance between neighboring nodes and its reciprocal
+	double spacing[3];
+	double invSpacing[3];
+
+	// Node velocities. Length is 3*numNode[0]*numNode[1]*numNode[2]
+	const float * velocity;
+
+	// File contents and whether they were mapped (rather than copied)
+	void * fileData;
+	size_t fileSize;
+	bool bMapped;
+};
+
+//
+// Function Declarations
+//
+
+// Load a flow field from a binary file
+void loadFlowField(const char * fileName,
+	struct flowField * field);
+
+// Free memory (or unmap file) associated with a flow field
+void deleteFlowField(struct flowField * field);
+
+// Find the flow velocity at a point by trilinear interpolation of the grid.
+// Velocity is zero outside of the grid
+void sampleFlowField(const struct flowField * field,
+	const double point[3],
+	double velocity[3]);
+
+#endif // FLOW_FIELD_H
@@ -0,0 +1,280 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * geometry_cache.c - file with the subvolume neighbours of an environment,
+ *				so that simulations of the same environment (e.g., with
+ *				different seeds) do not have to search for them again
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifdef __linux__
+	#define _POSIX_C_SOURCE 200112L // for getpid()
+	#include <unistd.h> // for getpid()
+#endif // __linux__
+#include <string.h> // for strlen(), memcmp(), memcpy()
+#include <inttypes.h> // for PRIx64
+#include <limits.h> // for USHRT_MAX
+#include "geometry_cache.h"
+
+//
+// "Private" Declarations
+//
+
+// Add bytes to a 64-bit FNV-1a hash
+static uint64_t hashBytes(uint64_t hash,
+	const void * data,
+	const size_t numByte);
+
+// Add a string (or NULL) to a hash
+static uint64_t hashString(uint64_t hash,
+	const char * str);
+
+// Map a cache file into memory. Returns false if the file cannot be read
+static bool mapGeometryCache(struct geometryCache * cache);
+
+// Release the memory of a mapped cache file
+static void unmapGeometryCache(struct geometryCache * cache);
+
+// Check that a mapped cache file belongs to the current environment and set
+// the array pointers
+static bool bGeometryCacheValid(struct geometryCache * cache,
+	const uint32_t numSub);
+
+//
+// Definitions
+//
+
+// Find the key of the environment and read its cache file from directory
+// dirName if the file exists and is valid. The cache is not used if dirName
+// is NULL
+void initializeGeometryCache(struct geometryCache * cache,
+	const char * dirName,
+	const short NUM_REGIONS,
+	const struct spec_region3D subvol_spec[],
+	const double SUBVOL_BASE_SIZE,
+	const uint32_t numSub)
+{
+	short curRegion;
+	size_t nameLength;
+
+	cache->fileName = NULL;
+	cache->key = 0;
+	cache->bLoaded = false;
+	cache->numNeigh = NULL;
+	cache->neighID = NULL;
+	cache->map = NULL;
+	cache->mapSize = 0;
+	cache->bMapped = false;
+
+	if(dirName == NULL)
+		return;
+
+	// Only the parameters that determine the subvolumes and their neighbours
+	// are part of the key. Diffusion coefficients, reactions, and actors are
+	// not
+	cache->key = 14695981039346656037ULL; // FNV offset basis
+	cache->key = hashBytes(cache->key, &NUM_REGIONS, sizeof(NUM_REGIONS));
+	cache->key = hashBytes(cache->key, &SUBVOL_BASE_SIZE, sizeof(SUBVOL_BASE_SIZE));
+	for(curRegion = 0; curRegion < NUM_REGIONS; curRegion++)
+	{
+		cache->key = hashString(cache->key, subvol_spec[curRegion].label);
+		cache->key = hashString(cache->key, subvol_spec[curRegion].parent);
+		cache->key = hashBytes(cache->key, &subvol_spec[curRegion].xAnch, sizeof(double));
+		cache->key = hashBytes(cache->key, &subvol_spec[curRegion].yAnch, sizeof(double));
+		cache->key = hashBytes(cache->key, &subvol_spec[curRegion].zAnch, sizeof(double));
+		cache->key = hashBytes(cache->key, &subvol_spec[curRegion].bMicro, sizeof(bool));
+		cache->key = hashBytes(cache->key, &subvol_spec[curRegion].shape, sizeof(int));
+		cache->key = hashBytes(cache->key, &subvol_spec[curRegion].type, sizeof(int));
+		cache->key = hashBytes(cache->key, &subvol_spec[curRegion].surfaceType, sizeof(int));
+		cache->key = hashBytes(cache->key, &subvol_spec[curRegion].sizeRect, sizeof(unsigned int));
+		cache->key = hashBytes(cache->key, &subvol_spec[curRegion].radius, sizeof(double));
+		cache->key = hashBytes(cache->key, &subvol_spec[curRegion].numX, sizeof(unsigned int));
+		cache->key = hashBytes(cache->key, &subvol_spec[curRegion].numY, sizeof(unsigned int));
+		cache->key = hashBytes(cache->key, &subvol_spec[curRegion].numZ, sizeof(unsigned int));
+	}
+
+	nameLength = strlen(dirName) + 40;
+	cache->fileName = malloc(nameLength);
+	if(cache->fileName == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation for name of geometry cache file.\n");
+		exit(EXIT_FAILURE);
+	}
+	snprintf(cache->fileName, nameLength, "%s/accord_geometry_%016" PRIx64 ".bin",
+		dirName, cache->key);
+
+	if(!mapGeometryCache(cache))
+		return;
+	if(bGeometryCacheValid(cache, numSub))
+	{
+		cache->bLoaded = true;
+		printf("Read subvolume neighbours from geometry cache \"%s\".\n",
+			cache->fileName);
+	} else
+		unmapGeometryCache(cache); // Keep name so that file is replaced
+}
+
+// Write the neighbours of every subvolume to the cache file if they were not
+// read from it
+void saveGeometryCache(struct geometryCache * cache,
+	const uint32_t numSub,
+	const struct subvolume3D subvolArray[])
+{
+	struct geometryCacheHeader header;
+	uint32_t curSub, curNeigh;
+	size_t nameLength;
+	char * tempName;
+	FILE * file;
+	bool bFail = false;
+
+	if(cache->fileName == NULL || cache->bLoaded)
+		return;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, GEOMETRY_CACHE_MAGIC, sizeof(GEOMETRY_CACHE_MAGIC));
+	header.version = GEOMETRY_CACHE_VERSION;
+	header.numSub = numSub;
+	header.key = cache->key;
+	header.numNeighID = 0;
+	for(curSub = 0; curSub < numSub; curSub++)
+		header.numNeighID += subvolArray[curSub].num_neigh;
+
+	// Write to a temporary file that is unique to this process
+	nameLength = strlen(cache->fileName) + 32;
+	tempName = malloc(nameLength);
+	if(tempName == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation for name of geometry cache file.\n");
+		exit(EXIT_FAILURE);
+	}
+#ifdef __linux__
+	snprintf(tempName, nameLength, "%s.%ld.tmp", cache->fileName, (long) getpid());
+#else
+	snprintf(tempName, nameLength, "%s.tmp", cache->fileName);
+#endif // __linux__
+
+	file = fopen(tempName, "wb");
+	if(file == NULL)
+	{
+		fprintf(stderr, "\nWARNING: Could not write geometry cache file \"%s\".\n",
+			tempName);
+		free(tempName);
+		return;
+	}
+	bFail = fwrite(&header, sizeof(header), 1, file) != 1;
+	for(curSub = 0; curSub < numSub && !bFail; curSub++)
+	{
+		curNeigh = subvolArray[curSub].num_neigh;
+		bFail = fwrite(&curNeigh, sizeof(uint32_t), 1, file) != 1;
+	}
+	for(curSub = 0; curSub < numSub && !bFail; curSub++)
+	{
+		if(subvolArray[curSub].num_neigh > 0)
+			bFail = fwrite(subvolArray[curSub].neighID, sizeof(uint32_t),
+				subvolArray[curSub].num_neigh, file) != subvolArray[curSub].num_neigh;
+	}
+	if(fclose(file) != 0)
+		bFail = true;
+
+	if(bFail || rename(tempName, cache->fileName) != 0)
+	{
+		fprintf(stderr, "\nWARNING: Could not write geometry cache file \"%s\".\n",
+			cache->fileName);
+		remove(tempName);
+	}
+	free(tempName);
+}
+
+// Release the cache file
+void deleteGeometryCache(struct geometryCache * cache)
+{
+	unmapGeometryCache(cache);
+	if(cache->fileName != NULL)
+		free(cache->fileName);
+	cache->fileName = NULL;
+}
+
+// Add bytes to a 64-bit FNV-1a hash
+static uint64_t hashBytes(uint64_t hash,
+	const void * data,
+	const size_t numByte)
+{
+	const unsigned char * p_byte = data;
+	size_t curByte;
+
+	for(curByte = 0; curByte < numByte; curByte++)
+	{
+		hash ^= p_byte[curByte];
+		hash *= 1099511628211ULL; // FNV prime
+	}
+	return hash;
+}
+
+// Add a string (or NULL) to a hash
+static uint64_t hashString(uint64_t hash,
+	const char * str)
+{
+	if(str == NULL)
+		return hashBytes(hash, "", 1);
+	return hashBytes(hash, str, strlen(str) + 1); // Include terminator
+}
+
+// Map a cache file into memory. Returns false if the file cannot be read
+static bool mapGeometryCache(struct geometryCache * cache)
+{
+	cache->map = mapFile(cache->fileName, NULL,
+		sizeof(struct geometryCacheHeader), &cache->mapSize, &cache->bMapped);
+	return cache->map != NULL;
+}
+
+// Release the memory of a mapped cache file
+static void unmapGeometryCache(struct geometryCache * cache)
+{
+	unmapFile(cache->map, cache->mapSize, cache->bMapped);
+	cache->map = NULL;
+	cache->mapSize = 0;
+	cache->numNeigh = NULL;
+	cache->neighID = NULL;
+	cache->bLoaded = false;
+}
+
+// Check that a mapped cache file belongs to the current environment and set
+// the array pointers
+static bool bGeometryCacheValid(struct geometryCache * cache,
+	const uint32_t numSub)
+{
+	const struct geometryCacheHeader * header = cache->map;
+	uint64_t numNeighID = 0, curNeighID;
+	uint32_t curSub;
+
+	if(memcmp(header->magic, GEOMETRY_CACHE_MAGIC, sizeof(GEOMETRY_CACHE_MAGIC)) != 0
+		|| header->version != GEOMETRY_CACHE_VERSION
+		|| header->key != cache->key
+		|| header->numSub != numSub
+		|| cache->mapSize != sizeof(struct geometryCacheHeader)
+			+ ((uint64_t) numSub + header->numNeighID)*sizeof(uint32_t))
+		return false;
+
+	cache->numNeigh = (const uint32_t *) (header + 1);
+	cache->neighID = cache->numNeigh + numSub;
+	for(curSub = 0; curSub < numSub; curSub++)
+	{
+		if(cache->numNeigh[curSub] > USHRT_MAX)
+			return false;
+		numNeighID += cache->numNeigh[curSub];
+	}
+	for(curNeighID = 0; curNeighID < header->numNeighID; curNeighID++)
+	{
+		if(cache->neighID[curNeighID] >= numSub)
+			return false;
+	}
+	return numNeighID == header->numNeighID;
+}
@@ -0,0 +1,103 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * geometry_cache.h - file with the subvolume neighbours of an environment,
+ *				so that simulations of the same environment (e.g., with
+ *				different seeds) do not have to search for them again
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifndef GEOMETRY_CACHE_H
+#define GEOMETRY_CACHE_H
+
+#include <stdio.h> // for fprintf()
+#include <stdlib.h> // for exit(), malloc, free
+#include <stdbool.h> // for C++ bool naming, requires C99
+#include <stdint.h> // for uint32_t, uint64_t
+#include "region.h"
+#include "subvolume.h"
+#include "file_map.h" // for reading cache files
+
+/* FORMAT OF GEOMETRY CACHE FILES
+*
+* A cache file is named "accord_geometry_<key>.bin", where <key> is the hash
+* (in hexadecimal) of the region specifications and the subvolume base size.
+* It is written in the byte order of the machine that wrote it and has:
+*	struct geometryCacheHeader
+*	uint32_t numNeigh[numSub]: number of neighbours of each subvolume
+*	uint32_t neighID[numNeighID]: IDs of the neighbours of each subvolume,
+*		in the order of the subvolumes
+*
+* A file whose header does not match the current environment is ignored and
+* replaced. Files are written under a temporary name and then renamed, so
+* simulations that start at the same time never read a partial file.
+*/
+
+//
+// Constant definitions
+//
+
+#define GEOMETRY_CACHE_MAGIC "ACCGEOM"
+#define GEOMETRY_CACHE_VERSION 1
+
+//
+// Data Type Declarations
+//
+
+/* The geometryCacheHeader structure is the start of a cache file.
+*/
+struct geometryCacheHeader {
+	char magic[8]; // GEOMETRY_CACHE_MAGIC
+	uint32_t version; // GEOMETRY_CACHE_VERSION
+	uint32_t numSub; // Number of subvolumes
+	uint64_t key; // Hash of the environment
+	uint64_t numNeighID; // Length of neighID array
+};
+
+/* The geometryCache structure has the subvolume neighbours read from a cache
+* file. The arrays point into the contents of the file, which is
+* memory-mapped where possible.
+*/
+struct geometryCache {
+	char * fileName; // Name of cache file (NULL if cache is not used)
+	uint64_t key; // Hash of the environment
+	bool bLoaded; // Were the neighbours read from the file?
+	const uint32_t * numNeigh; // Number of neighbours of each subvolume
+	const uint32_t * neighID; // IDs of neighbours of all subvolumes
+	void * map; // Contents of file (NULL if not loaded)
+	size_t mapSize; // Size of file in bytes
+	bool bMapped; // Is the file memory-mapped? (else allocated)
+};
+
+//
+// Function Declarations
+//
+
+// Find the key of the environment and read its cache file from directory
+// dirName if the file exists and is valid. The cache is not used if dirName
+// is NULL
+void initializeGeometryCache(struct geometryCache * cache,
+	const char * dirName,
+	const short NUM_REGIONS,
+	const struct spec_region3D subvol_spec[],
+	const double SUBVOL_BASE_SIZE,
+	const uint32_t numSub);
+
+// Write the neighbours of every subvolume to the cache file if they were not
+// read from it
+void saveGeometryCache(struct geometryCache * cache,
+	const uint32_t numSub,
+	const struct subvolume3D subvolArray[]);
+
+// Release the cache file
+void deleteGeometryCache(struct geometryCache * cache);
+
+#endif // GEOMETRY_CACHE_H
@@ -9,10 +9,13 @@
  *
  * global_param.h - global parameters that are independent of a specific
  * 					simulation
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added optional deflate compression of the output file
+ *
  * Revision v0.5 (2016-04-15)
  * - removed use of MAX_MOL_TYPES
  * - removed use of MAX_RXN_PRODUCTS
@@ -116,4 +119,9 @@
 #define LINEAR 0
 #define SINUS 1
 
+// Output file compression codecs
+// NOTE: Changes to list of names must be reflected in file_io.c
+#define OUTPUT_CODEC_NONE 0
+#define OUTPUT_CODEC_DEFLATE 1
+
 #endif // GLOBAL_PARAM_H
@@ -8,10 +8,13 @@
  * For user documentation, read README.txt in the root AcCoRD directory
  *
  * meso.c - heap of all mesoscopic subvolumes in simulation environment
- * Last revised for AcCoRD v0.4.1
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added opt-in profiling of simulation phases
+ *
  * Revision v0.4.1
  * - improved use and format of error messages
  *
@@ -32,6 +35,7 @@
 #include "meso.h"
 #include "subvolume.h"
 #include "region.h"
+#include "profile.h" // for counting heap updates
 
 //
 // "Private" Declarations
@@ -550,6 +554,8 @@ uint32_t heapMesoUpdate(const uint32_t numSub,
 {
 	uint32_t newID, oldID; // Updated current and previous placement in heap
 	
+	PROFILE_COUNT(PROFILE_MESO_HEAP_UPDATE, 1);
+	
 	// See if element needs to move "down" (i.e., lower priority)
 	oldID = heapID;
 	newID = heapMesoCompareDown(numSub, mesoSubArray, heap_subvolID, heapID,
@@ -643,6 +649,8 @@ void heapMesoSwap(struct mesoSubvolume3D mesoSubArray[],
 	
 	uint32_t tempID;
 	
+	PROFILE_COUNT(PROFILE_MESO_HEAP_SWAP, 1);
+	
 	// Update heap IDs associated with the subvolumes whose heap positions are being swapped
 	mesoSubArray[heap_subvolID[index1]].heapID = index2;
 	mesoSubArray[heap_subvolID[index2]].heapID = index1;
@@ -10,10 +10,23 @@
  * micro_molecule.c - 	linked list of individual molecules in same
  * 						microscopic region
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added closed-form reflection of molecules off the faces of box regions without
+ * children
+ * - added advection of microscopic molecules by a region flow field that is read from a
+ * memory-mapped velocity grid
+ * - placed microscopic actor emissions in batches
+ * - recorded observed molecule positions in a coordinate buffer of each passive actor
+ * - added logging of molecules captured by absorbing and receptor surfaces
+ * - added quantized and delta-encoded recording of molecule positions
+ * - added opt-in profiling of simulation phases
+ * - took the nodes of recent molecules from an arena of each list that is cleared every
+ * time step
+ *
  * Revision v0.5 (2016-04-15)
  * - added surface reactions, including membrane transitions
  * - added switch to record all molecules in a region instead of just those
@@ -44,6 +57,7 @@
  */
 
 #include "micro_molecule.h"
+#include "profile.h" // for counting diffusion events
 
 // Local Function Prototypes
 
@@ -65,6 +79,17 @@ static void copyToNode(ItemMol3D item, NodeMol3D * p_node);
 
 static void copyToNodeRecent(ItemMolRecent3D item, NodeMolRecent3D * p_node);
 
+static bool reflectInBoxRegion(double point[3], const struct region * curRegion);
+
+static void logSurfaceCapture(struct captureLog3D * captureLog,
+		const struct region regionArray[], const short curRegion,
+		const unsigned short curRxn, const double point[3],
+		const unsigned short molType);
+
+static uint64_t spreadMortonBits(uint32_t cell);
+
+static int compareMortonCode(const void * a, const void * b);
+
 // Specific Definitions
 
 // Create new molecule at specified coordinates
@@ -80,6 +105,32 @@ bool addMoleculeRecent(ListMolRecent3D * p_list, double x, double y, double z,
 	return addItemRecent(new_molecule, p_list);
 }
 
+// Create many new molecules that share the same partial time step
+// The nodes of all molecules are reserved from the list's arena at once. The
+// list order is the same as if the molecules were added one at a time
+bool addMoleculesRecent(ListMolRecent3D * p_list, double point[][3],
+		const uint32_t numMol, double dt_partial) {
+	uint32_t curMol;
+	NodeMolRecent3D * p_new;
+
+	if (numMol == 0)
+		return true;
+
+	p_new = arenaAlloc(&p_list->arena, numMol * sizeof(NodeMolRecent3D));
+	if (p_new == NULL)
+		return false; // Quit on failure of malloc
+
+	for (curMol = 0; curMol < numMol; curMol++) {
+		p_new[curMol].item.x = point[curMol][0];
+		p_new[curMol].item.y = point[curMol][1];
+		p_new[curMol].item.z = point[curMol][2];
+		p_new[curMol].item.dt_partial = dt_partial;
+		p_new[curMol].next = (curMol > 0) ? &p_new[curMol - 1] : p_list->head;
+	}
+	p_list->head = &p_new[numMol - 1];
+	return true;
+}
+
 // Move one molecule to the specified coordinates
 void moveMolecule(ItemMol3D * molecule, double x, double y, double z) {
 	molecule->x = x;
@@ -104,7 +155,8 @@ void diffuseMolecules(const short NUM_REGIONS,
 		struct mesoSubvolume3D mesoSubArray[], struct subvolume3D subvolArray[],
 		double sigma_diff[NUM_REGIONS][NUM_MOL_TYPES],
 		double delta_flow[NUM_REGIONS],
-		double DIFF_COEF[NUM_REGIONS][NUM_MOL_TYPES]) {
+		double DIFF_COEF[NUM_REGIONS][NUM_MOL_TYPES],
+		struct captureLog3D * captureLog) {
 	NodeMol3D * curNode, *prevNode, *nextNode;
 	NodeMolRecent3D * curNodeR;
 
@@ -117,15 +169,18 @@ void diffuseMolecules(const short NUM_REGIONS,
 
 	bool bReaction;
 	unsigned short curRxn, curProd;
+	bool bFlowField; // Molecules in region move with a flow field
 
 	// Indicate that every microscopic molecule in a "normal" list
 	// needs to be moved.
 	// We do this to avoid moving a molecule more than once if it is moved
 	// to a different region.
 	for (curRegion = 0; curRegion < NUM_REGIONS; curRegion++) {
+		bFlowField = regionArray[curRegion].flowField != NULL
+				&& delta_flow[curRegion] != 0.;
 		for (curType = 0; curType < NUM_MOL_TYPES; curType++) {
 			if (isListMol3DEmpty(&p_list[curRegion][curType])
-					|| sigma_diff[curRegion][curType] == 0.)
+					|| (sigma_diff[curRegion][curType] == 0. && !bFlowField))
 				continue; // No need to validate an empty list of molecules or ones that can't move
 
 			curNode = p_list[curRegion][curType];
@@ -139,9 +194,11 @@ void diffuseMolecules(const short NUM_REGIONS,
 
 	// Diffuse molecule in "regular" molecule lists
 	for (curRegion = 0; curRegion < NUM_REGIONS; curRegion++) {
+		bFlowField = regionArray[curRegion].flowField != NULL
+				&& delta_flow[curRegion] != 0.;
 		for (curType = 0; curType < NUM_MOL_TYPES; curType++) {
 			if (isListMol3DEmpty(&p_list[curRegion][curType])
-					|| sigma_diff[curRegion][curType] == 0.)
+					|| (sigma_diff[curRegion][curType] == 0. && !bFlowField))
 				continue; // No need to validate an empty list of molecules
 
 			curNode = p_list[curRegion][curType];
@@ -161,14 +218,23 @@ void diffuseMolecules(const short NUM_REGIONS,
 					// as diffusion could place the molecule outside of the cylinder
 					// resulting in reversed flow velocity
 					if (regionArray[curRegion].spec.shape == CYLINDER
+							&& regionArray[curRegion].flowField == NULL
 							&& delta_flow[curRegion] != 0.) {
 						processFlow(&curNode->item, regionArray[curRegion],
 								delta_flow[curRegion]);
 					}
 
+					// Flow field moves molecule before it diffuses, so that
+					// the combined move is validated
+					if (bFlowField)
+						advectOneMolecule(&curNode->item,
+								regionArray[curRegion].flowField,
+								delta_flow[curRegion]);
+
 					// Diffuse molecule
-					diffuseOneMolecule(&curNode->item,
-							sigma_diff[curRegion][curType]);
+					if (sigma_diff[curRegion][curType] > 0.)
+						diffuseOneMolecule(&curNode->item,
+								sigma_diff[curRegion][curType]);
 
 					newPoint[0] = curNode->item.x;
 					newPoint[1] = curNode->item.y;
@@ -191,6 +257,8 @@ void diffuseMolecules(const short NUM_REGIONS,
 							if (regionArray[newRegion].spec.bMicro) { // New region is microscopic. Move to appropriate list
 
 								if (bReaction) { // We need to fire the corresponding reaction curRxn
+									logSurfaceCapture(captureLog, regionArray,
+											newRegion, curRxn, newPoint, curType);
 									if (regionArray[newRegion].numRxnProducts[curRxn]
 											> 0) {
 										for (curProd = 0;
@@ -270,13 +338,19 @@ void diffuseMolecules(const short NUM_REGIONS,
 			if (isListMol3DRecentEmpty(&p_listRecent[curRegion][curType]))
 				continue; // No need to validate an empty list of molecules
 
-			curNodeR = p_listRecent[curRegion][curType];
+			curNodeR = p_listRecent[curRegion][curType].head;
 			curMol = 0;
 			while (curNodeR != NULL) {
 				oldPoint[0] = curNodeR->item.x;
 				oldPoint[1] = curNodeR->item.y;
 				oldPoint[2] = curNodeR->item.z;
 
+				// Flow field moves molecule for the rest of the time step
+				if (regionArray[curRegion].flowField != NULL
+						&& delta_flow[curRegion] != 0.)
+					advectOneMoleculeRecent(&curNodeR->item,
+							regionArray[curRegion].flowField);
+
 				// Diffuse molecule
 				diffuseOneMoleculeRecent(&curNodeR->item,
 						DIFF_COEF[curRegion][curType]);
@@ -294,6 +368,8 @@ void diffuseMolecules(const short NUM_REGIONS,
 
 				if (regionArray[newRegion].spec.bMicro) { // Region is microscopic. Move to appropriate list
 					if (bReaction) { // We need to fire the corresponding reaction curRxn
+						logSurfaceCapture(captureLog, regionArray, newRegion,
+								curRxn, newPoint, curType);
 						if (regionArray[newRegion].numRxnProducts[curRxn] > 0) {
 							for (curProd = 0;
 									curProd
@@ -346,14 +422,11 @@ void diffuseMolecules(const short NUM_REGIONS,
 		}
 	}
 
-	// Empty recent lists
+	// Empty recent lists. Lists that reactions have already emptied are
+	// cleared too, so that their memory is re-used
 	for (curRegion = 0; curRegion < NUM_REGIONS; curRegion++) {
 		for (curType = 0; curType < NUM_MOL_TYPES; curType++) {
-			if (isListMol3DRecentEmpty(&p_listRecent[curRegion][curType]))
-				continue; // No need to validate an empty list of molecules
-
-			emptyListMol3DRecent(&p_listRecent[curRegion][curType]);
-			initializeListMolRecent(&p_listRecent[curRegion][curType]);
+			clearListMol3DRecent(&p_listRecent[curRegion][curType]);
 		}
 	}
 }
@@ -409,6 +482,31 @@ void processFlow(ItemMol3D* molecule, const struct region region, double delta)
 	}
 }
 
+// Move one molecule by the flow field velocity at its location multiplied by dt
+void advectOneMolecule(ItemMol3D * molecule, const struct flowField * field,
+		double dt) {
+	double point[3] = { molecule->x, molecule->y, molecule->z };
+	double velocity[3];
+
+	sampleFlowField(field, point, velocity);
+	molecule->x += dt * velocity[0];
+	molecule->y += dt * velocity[1];
+	molecule->z += dt * velocity[2];
+}
+
+// Move one molecule by the flow field velocity at its location multiplied by
+// its partial time step
+void advectOneMoleculeRecent(ItemMolRecent3D * molecule,
+		const struct flowField * field) {
+	double point[3] = { molecule->x, molecule->y, molecule->z };
+	double velocity[3];
+
+	sampleFlowField(field, point, velocity);
+	molecule->x += molecule->dt_partial * velocity[0];
+	molecule->y += molecule->dt_partial * velocity[1];
+	molecule->z += molecule->dt_partial * velocity[2];
+}
+
 // Check first order reactions for all molecules in list
 void rxnFirstOrder(ListMol3D * p_list, const struct region regionArray,
 		unsigned short curMolType, const unsigned short NUM_MOL_TYPES,
@@ -493,7 +591,7 @@ void rxnFirstOrderRecent(const unsigned short NUM_MOL_TYPES,
 		ListMolRecent3D pRecentList[NUM_MOL_TYPES],
 		const struct region regionArray, unsigned short curMolType,
 		bool bCheckCount, uint32_t numMolCheck[NUM_MOL_TYPES]) {
-	NodeMolRecent3D * curNode = pRecentList[curMolType];
+	NodeMolRecent3D * curNode = pRecentList[curMolType].head;
 	NodeMolRecent3D * prevNode = NULL;
 	NodeMolRecent3D * nextNode;
 	double curRand;
@@ -573,7 +671,7 @@ void rxnFirstOrderRecent(const unsigned short NUM_MOL_TYPES,
 						}
 						if (prevNode == NULL && prodID == curMolType) { // We've just added a molecule to the start of the current
 																		// molecule list. Update prevNode
-							prevNode = pRecentList[curMolType];
+							prevNode = pRecentList[curMolType].head;
 						}
 						// Update the number of molecules that need to be checked
 						// in the next round
@@ -596,7 +694,7 @@ void rxnFirstOrderRecent(const unsigned short NUM_MOL_TYPES,
 		if (prevNode == NULL && bRemove) { // prevNode does not change, but we removed first molecule in list.
 										   // nextNode is now the start of the list
 										   // (i.e., we must update pointer to list)
-			pRecentList[curMolType] = nextNode;
+			pRecentList[curMolType].head = nextNode;
 		} else if (!bRemove) {
 			prevNode = curNode;
 		}
@@ -610,7 +708,7 @@ void rxnFirstOrderRecent(const unsigned short NUM_MOL_TYPES,
 
 // Empty recent list and add corresponding molecules to "normal" list
 void transferMolecules(ListMolRecent3D * molListRecent, ListMol3D * molList) {
-	NodeMolRecent3D * p_node = *molListRecent;
+	NodeMolRecent3D * p_node = molListRecent->head;
 
 	// Copy list of molecules to normal list
 	while (p_node != NULL) {
@@ -624,9 +722,8 @@ void transferMolecules(ListMolRecent3D * molListRecent, ListMol3D * molList) {
 		p_node = p_node->next;
 	}
 
-	// Empty the recent list and re-initialize
-	emptyListMol3DRecent(molListRecent);
-	initializeListMolRecent(molListRecent);
+	// Empty the recent list
+	clearListMol3DRecent(molListRecent);
 }
 
 bool validateMolecule(double newPoint[3], double oldPoint[3],
@@ -641,9 +738,13 @@ bool validateMolecule(double newPoint[3], double oldPoint[3],
 
 	short trajRegion = curRegion; // Regions passed through by the molecule's trajectory
 
+	PROFILE_COUNT(PROFILE_MICRO_MOL_STEP, 1);
+
 	if (regionArray[curRegion].numChildren < 1
 			&& bPointInRegionNotChild(curRegion, regionArray, newPoint)) { // This is simplest case. No region boundary interactions
 		return true;
+	} else if (reflectInBoxRegion(newPoint, &regionArray[curRegion])) { // Molecule left a box only through faces that reflect
+		return false;
 	} else { // Molecule may have left region's outer boundary or went through a child region
 
 		// Define trajectory vector
@@ -655,6 +756,51 @@ bool validateMolecule(double newPoint[3], double oldPoint[3],
 	}
 }
 
+// Reflect a point that has left a box region back inside in one pass
+// Each coordinate is folded about the box faces that it crossed, which is
+// equivalent to following every specular reflection of the trajectory.
+// Return false (and leave point unchanged) if any crossed face does not
+// only reflect, since then the trajectory must be followed explicitly
+static bool reflectInBoxRegion(double point[3], const struct region * curRegion) {
+	unsigned short i;
+	double lower, width, offset;
+	double newPoint[3];
+
+	if (curRegion->spec.shape != RECTANGULAR_BOX || curRegion->numChildren > 0)
+		return false;
+
+	for (i = 0; i < 3; i++) {
+		lower = curRegion->boundary[2 * i];
+		width = curRegion->boundary[2 * i + 1] - lower;
+		offset = point[i] - lower;
+		if (offset >= 0. && offset <= width) {
+			newPoint[i] = point[i];
+			continue;
+		}
+		// Make sure that every face crossed only reflects
+		if ((offset < 0. || offset > 2 * width)
+				&& !curRegion->bReflectFace[2 * i])
+			return false;
+		if ((offset > width || offset < -width)
+				&& !curRegion->bReflectFace[2 * i + 1])
+			return false;
+
+		// Fold offset into [0, width]. Period of reflections is 2*width
+		offset = fmod(offset, 2 * width);
+		if (offset < 0.)
+			offset += 2 * width;
+		if (offset > width)
+			offset = 2 * width - offset;
+		newPoint[i] = lower + offset;
+	}
+
+	point[0] = newPoint[0];
+	point[1] = newPoint[1];
+	point[2] = newPoint[2];
+	PROFILE_COUNT(PROFILE_REFLECTION, 1);
+	return true;
+}
+
 // Recursively follow a molecule's path through region boundaries from its diffusion
 // start and end points
 // Return false if molecule path had to be changed
@@ -684,6 +830,9 @@ bool followMolecule(const double startPoint[3], double endPoint[3],
 	bool bReflectInside;
 	short reflectRegion;
 
+	PROFILE_COUNT(PROFILE_FOLLOW_CALL, 1);
+	PROFILE_MAX(PROFILE_FOLLOW_DEPTH, depth);
+
 	// First check all neighbor regions to see which (if any) are intersected first
 	minDist = INFINITY;
 	minNormalDist = INFINITY;
@@ -941,6 +1090,7 @@ bool followMolecule(const double startPoint[3], double endPoint[3],
 		endPoint[2] = nearestIntersectPoint[2];
 		return false;
 	}
+	PROFILE_COUNT(PROFILE_REFLECTION, 1);
 	// Lock point to actual boundary only if actual reflection occurred
 	lockPointToRegion(nearestIntersectPoint, startRegion, startRegion,
 			regionArray, nearestFace);
@@ -973,7 +1123,7 @@ uint64_t countMolecules(ListMol3D * p_list, int obsType, double boundary[]) {
 // Count number of molecules inside observer
 uint64_t countMoleculesRecent(ListMolRecent3D * p_list, int obsType,
 		double boundary[]) {
-	NodeMolRecent3D * p_node = *p_list;
+	NodeMolRecent3D * p_node = p_list->head;
 	uint64_t curCount = 0ULL;
 
 	while (p_node != NULL) {
@@ -985,7 +1135,8 @@ uint64_t countMoleculesRecent(ListMolRecent3D * p_list, int obsType,
 }
 
 // Count molecules within boundary and add
-uint64_t recordMolecules(ListMol3D * p_list, ListMol3D * recordList,
+uint64_t recordMolecules(ListMol3D * p_list,
+		struct molPosBuffer3D * recordBuffer,
 		int obsType, double boundary[], bool bRecordPos, bool bRecordAll) {
 	NodeMol3D * p_node = *p_list;
 	uint64_t curCount = 0ULL;
@@ -994,7 +1145,9 @@ uint64_t recordMolecules(ListMol3D * p_list, ListMol3D * recordList,
 		if (bRecordAll
 				|| isMoleculeObserved(&p_node->item, obsType, boundary)) {
 			curCount++;
-			if (bRecordPos && !addItem(p_node->item, recordList)) {
+			if (bRecordPos
+					&& !addMolPos(recordBuffer, p_node->item.x, p_node->item.y,
+							p_node->item.z)) {
 				fprintf(stderr,
 						"\nERROR: Memory allocation for recording molecule positions.\n");
 				exit(EXIT_FAILURE);
@@ -1006,9 +1159,10 @@ uint64_t recordMolecules(ListMol3D * p_list, ListMol3D * recordList,
 }
 
 // Count molecules within boundary and add
-uint64_t recordMoleculesRecent(ListMolRecent3D * p_list, ListMol3D * recordList,
+uint64_t recordMoleculesRecent(ListMolRecent3D * p_list,
+		struct molPosBuffer3D * recordBuffer,
 		int obsType, double boundary[], bool bRecordPos, bool bRecordAll) {
-	NodeMolRecent3D * p_node = *p_list;
+	NodeMolRecent3D * p_node = p_list->head;
 	uint64_t curCount = 0ULL;
 
 	while (p_node != NULL) {
@@ -1016,7 +1170,7 @@ uint64_t recordMoleculesRecent(ListMolRecent3D * p_list, ListMol3D * recordList,
 				|| isMoleculeObservedRecent(&p_node->item, obsType, boundary)) {
 			curCount++;
 			if (bRecordPos
-					&& !addMolecule(recordList, p_node->item.x, p_node->item.y,
+					&& !addMolPos(recordBuffer, p_node->item.x, p_node->item.y,
 							p_node->item.z)) {
 				fprintf(stderr,
 						"\nERROR: Memory allocation for recording molecule positions.\n");
@@ -1105,7 +1259,8 @@ void initializeListMol(ListMol3D * p_list) {
 
 // Initialize Recent list
 void initializeListMolRecent(ListMolRecent3D * p_list) {
-	*p_list = NULL;
+	p_list->head = NULL;
+	initializeArena(&p_list->arena);
 }
 
 // Is the list empty?
@@ -1117,7 +1272,7 @@ bool isListMol3DEmpty(const ListMol3D * p_list) {
 
 // Is the list empty?
 bool isListMol3DRecentEmpty(const ListMolRecent3D * p_list) {
-	if (*p_list == NULL)
+	if (p_list->head == NULL)
 		return true;
 	return false;
 }
@@ -1137,7 +1292,7 @@ void traverse(const ListMol3D * p_list, void (*p_fun)(ItemMol3D item)) {
 // p_fun must be a void function that takes an item as input
 void traverseRecent(const ListMolRecent3D * p_list,
 		void (*p_fun)(ItemMolRecent3D item)) {
-	NodeMolRecent3D * p_node = *p_list;
+	NodeMolRecent3D * p_node = p_list->head;
 
 	while (p_node != NULL) {
 		(*p_fun)(p_node->item); // Apply function
@@ -1156,14 +1311,238 @@ void emptyListMol(ListMol3D * p_list) {
 	}
 }
 
+// Remove all molecules but keep their memory for re-use
+void clearListMol3DRecent(ListMolRecent3D * p_list) {
+	p_list->head = NULL;
+	clearArena(&p_list->arena);
+}
+
 // De-allocate memory of all nodes in the list
 void emptyListMol3DRecent(ListMolRecent3D * p_list) {
-	NodeMolRecent3D * p_save;
+	deleteArena(&p_list->arena);
+	p_list->head = NULL;
+}
 
-	while (*p_list != NULL) {
-		p_save = (*p_list)->next; // Save address of next node
-		free(*p_list); // Free memory of current node
-		*p_list = p_save; // Advance to next node
+// Position buffer Definitions
+
+// Initialize buffer (memory is allocated when the first position is added)
+void initializeMolPosBuffer(struct molPosBuffer3D * buffer) {
+	buffer->coor = NULL;
+	buffer->numPos = 0ULL;
+	buffer->maxPos = 0ULL;
+	buffer->code = NULL;
+	buffer->numCodeByte = 0ULL;
+	buffer->maxCodeByte = 0ULL;
+}
+
+// Append one molecule position to the end of a buffer
+bool addMolPos(struct molPosBuffer3D * buffer, double x, double y, double z) {
+	double * newCoor;
+
+	if (buffer->numPos < buffer->maxPos) {
+		newCoor = &buffer->coor[3 * buffer->numPos++];
+	} else {
+		newCoor = reserveMolPos(buffer, 1ULL);
+		if (newCoor == NULL)
+			return false;
+	}
+	newCoor[0] = x;
+	newCoor[1] = y;
+	newCoor[2] = z;
+	return true;
+}
+
+// Make room for numPos positions at the end of a buffer and return a pointer
+// to the first of them (or NULL if memory could not be allocated)
+// Capacity is doubled as needed so that appending is amortized constant time
+double * reserveMolPos(struct molPosBuffer3D * buffer, uint64_t numPos) {
+	uint64_t newMax;
+	double * newCoor;
+
+	if (buffer->numPos + numPos > buffer->maxPos) {
+		newMax = (buffer->maxPos > 0ULL) ? 2ULL * buffer->maxPos : 64ULL;
+		while (newMax < buffer->numPos + numPos)
+			newMax *= 2ULL;
+		newCoor = realloc(buffer->coor, 3 * newMax * sizeof(double));
+		if (newCoor == NULL)
+			return NULL; // Existing positions are kept
+		buffer->coor = newCoor;
+		buffer->maxPos = newMax;
+	}
+	newCoor = &buffer->coor[3 * buffer->numPos];
+	buffer->numPos += numPos;
+	return newCoor;
+}
+
+// Remove all positions but keep the allocated memory for re-use
+void clearMolPosBuffer(struct molPosBuffer3D * buffer) {
+	buffer->numPos = 0ULL;
+	buffer->numCodeByte = 0ULL;
+}
+
+// Encode all positions in coor of a buffer, append them to its code, and
+// remove them from coor
+bool encodeMolPos(struct molPosBuffer3D * buffer,
+	struct posQuantizer * quant) {
+	uint64_t curPos, newMax, delta, prevKey;
+	uint64_t * newKey;
+	unsigned char * newCode;
+	uint32_t cell[3];
+	double cellDouble;
+	unsigned short d;
+
+	if (buffer->numPos == 0ULL)
+		return true;
+
+	// Make room for the codes and the largest possible encoded size
+	if (buffer->numPos > quant->maxKey) {
+		newMax = (quant->maxKey > 0ULL) ? 2ULL * quant->maxKey : 64ULL;
+		while (newMax < buffer->numPos)
+			newMax *= 2ULL;
+		newKey = realloc(quant->key, newMax * sizeof(uint64_t));
+		if (newKey == NULL)
+			return false;
+		quant->key = newKey;
+		quant->maxKey = newMax;
+	}
+	if (buffer->numCodeByte + MAX_POS_CODE_BYTES * buffer->numPos
+			> buffer->maxCodeByte) {
+		newMax = (buffer->maxCodeByte > 0ULL) ? 2ULL * buffer->maxCodeByte : 512ULL;
+		while (newMax < buffer->numCodeByte + MAX_POS_CODE_BYTES * buffer->numPos)
+			newMax *= 2ULL;
+		newCode = realloc(buffer->code, newMax);
+		if (newCode == NULL)
+			return false;
+		buffer->code = newCode;
+		buffer->maxCodeByte = newMax;
+	}
+
+	// Quantize each position and find the Morton code of its cell
+	for (curPos = 0ULL; curPos < buffer->numPos; curPos++) {
+		for (d = 0; d < 3; d++) {
+			cellDouble = floor((buffer->coor[3 * curPos + d] - quant->origin[d])
+					* quant->invResolution);
+			if (cellDouble < 0.)
+				cell[d] = 0;
+			else if (cellDouble >= quant->numCell[d])
+				cell[d] = quant->numCell[d] - 1;
+			else
+				cell[d] = (uint32_t) cellDouble;
+		}
+		quant->key[curPos] = spreadMortonBits(cell[0])
+				| (spreadMortonBits(cell[1]) << 1)
+				| (spreadMortonBits(cell[2]) << 2);
+	}
+	qsort(quant->key, buffer->numPos, sizeof(uint64_t), compareMortonCode);
+
+	// Write differences between consecutive codes
+	prevKey = 0ULL;
+	for (curPos = 0ULL; curPos < buffer->numPos; curPos++) {
+		delta = quant->key[curPos] - prevKey;
+		prevKey = quant->key[curPos];
+		while (delta >= 0x80ULL) {
+			buffer->code[buffer->numCodeByte++] =
+					(unsigned char) ((delta & 0x7FULL) | 0x80ULL);
+			delta >>= 7;
+		}
+		buffer->code[buffer->numCodeByte++] = (unsigned char) delta;
+	}
+
+	buffer->numPos = 0ULL;
+	return true;
+}
+
+// Read one encoded value starting at code[*curByte] and advance *curByte
+uint64_t readPosCode(const unsigned char code[], uint64_t * curByte) {
+	uint64_t value = 0ULL;
+	unsigned short shift = 0;
+
+	while (code[*curByte] & 0x80U) {
+		value |= ((uint64_t) (code[(*curByte)++] & 0x7FU)) << shift;
+		shift += 7;
+	}
+	value |= ((uint64_t) code[(*curByte)++]) << shift;
+	return value;
+}
+
+// Free memory of buffer
+void deleteMolPosBuffer(struct molPosBuffer3D * buffer) {
+	free(buffer->coor);
+	free(buffer->code);
+	initializeMolPosBuffer(buffer);
+}
+
+// Capture log Definitions
+
+// Allocate a capture log with no regions logged
+void initializeCaptureLog(const short NUM_REGIONS,
+		struct captureLog3D * captureLog) {
+	short curRegion;
+
+	captureLog->bRegionLogged = malloc(NUM_REGIONS * sizeof(bool));
+	if (captureLog->bRegionLogged == NULL) {
+		fprintf(stderr,
+				"ERROR: Memory allocation for logging surface reactions.\n");
+		exit(EXIT_FAILURE);
+	}
+	for (curRegion = 0; curRegion < NUM_REGIONS; curRegion++)
+		captureLog->bRegionLogged[curRegion] = false;
+	captureLog->capture = NULL;
+	captureLog->numCapture = 0;
+	captureLog->maxCapture = 0;
+}
+
+// Add a molecule captured by a surface reaction to a capture log
+bool addSurfaceCapture(struct captureLog3D * captureLog,
+		const double point[3], const short region,
+		const unsigned short molType) {
+	struct surfaceCapture3D * newCapture;
+	uint32_t newMax;
+
+	if (captureLog->numCapture == captureLog->maxCapture) {
+		newMax = (captureLog->maxCapture > 0) ? 2 * captureLog->maxCapture : 64;
+		newCapture = realloc(captureLog->capture,
+				newMax * sizeof(struct surfaceCapture3D));
+		if (newCapture == NULL)
+			return false;
+		captureLog->capture = newCapture;
+		captureLog->maxCapture = newMax;
+	}
+	newCapture = &captureLog->capture[captureLog->numCapture++];
+	newCapture->x = point[0];
+	newCapture->y = point[1];
+	newCapture->z = point[2];
+	newCapture->region = region;
+	newCapture->molType = molType;
+	return true;
+}
+
+// Free memory of capture log
+void deleteCaptureLog(struct captureLog3D * captureLog) {
+	free(captureLog->bRegionLogged);
+	free(captureLog->capture);
+	captureLog->bRegionLogged = NULL;
+	captureLog->capture = NULL;
+	captureLog->numCapture = 0;
+	captureLog->maxCapture = 0;
+}
+
+// Add molecule to capture log if it reacted with a logged surface region
+// by an absorbing or receptor reaction
+static void logSurfaceCapture(struct captureLog3D * captureLog,
+		const struct region regionArray[], const short curRegion,
+		const unsigned short curRxn, const double point[3],
+		const unsigned short molType) {
+	if (captureLog == NULL || !captureLog->bRegionLogged[curRegion])
+		return;
+
+	if ((regionArray[curRegion].rxnSurfType[curRxn] == RXN_ABSORBING
+			|| regionArray[curRegion].rxnSurfType[curRxn] == RXN_RECEPTOR)
+			&& !addSurfaceCapture(captureLog, point, curRegion, molType)) {
+		fprintf(stderr,
+				"ERROR: Memory allocation to log molecule of type %u captured by region %u.\n",
+				molType, curRegion);
+		exit(EXIT_FAILURE);
 	}
 }
 
@@ -1185,13 +1564,13 @@ bool addItem(ItemMol3D item, ListMol3D * p_list) {
 bool addItemRecent(ItemMolRecent3D item, ListMolRecent3D * p_list) {
 	NodeMolRecent3D * p_new;
 
-	p_new = malloc(sizeof(NodeMolRecent3D));
+	p_new = arenaAlloc(&p_list->arena, sizeof(NodeMolRecent3D));
 	if (p_new == NULL)
 		return false; // Quit on failure of malloc
 
 	copyToNodeRecent(item, p_new);
-	p_new->next = *p_list;
-	*p_list = p_new; // Point start of list to new node
+	p_new->next = p_list->head;
+	p_list->head = p_new; // Point start of list to new node
 	return true;
 }
 
@@ -1208,14 +1587,12 @@ void removeItem(NodeMol3D * prevNode, NodeMol3D * curNode) {
 }
 
 // Remove node from list. In order to do this efficiently, need to pass Nodes
-// and not the start of the list.
+// and not the start of the list. The memory of the node is released when the
+// list is cleared
 void removeItemRecent(NodeMolRecent3D * prevNode, NodeMolRecent3D * curNode) {
-	if (curNode != NULL) {
-		if (prevNode != NULL) {
-			// Update pointer of previous node to point to following node
-			prevNode->next = curNode->next;
-		}
-		free(curNode); // Free memory of node
+	if (curNode != NULL && prevNode != NULL) {
+		// Update pointer of previous node to point to following node
+		prevNode->next = curNode->next;
 	}
 }
 
@@ -1228,3 +1605,23 @@ static void copyToNode(ItemMol3D item, NodeMol3D * p_node) {
 static void copyToNodeRecent(ItemMolRecent3D item, NodeMolRecent3D * p_node) {
 	p_node->item = item; // Structure copy
 }
+
+// Insert two zero bits between each of the lowest 21 bits of a grid cell index
+static uint64_t spreadMortonBits(uint32_t cell) {
+	uint64_t x = cell & 0x1fffffULL;
+
+	x = (x | (x << 32)) & 0x1f00000000ffffULL;
+	x = (x | (x << 16)) & 0x1f0000ff0000ffULL;
+	x = (x | (x << 8)) & 0x100f00f00f00f00fULL;
+	x = (x | (x << 4)) & 0x10c30c30c30c30c3ULL;
+	x = (x | (x << 2)) & 0x1249249249249249ULL;
+	return x;
+}
+
+// Comparison function for sorting Morton codes with qsort
+static int compareMortonCode(const void * a, const void * b) {
+	uint64_t keyA = *(const uint64_t *) a;
+	uint64_t keyB = *(const uint64_t *) b;
+
+	return (keyA > keyB) - (keyA < keyB);
+}
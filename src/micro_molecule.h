@@ -10,10 +10,20 @@
  * micro_molecule.h - 	linked list of individual molecules in same
  * 						microscopic region
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added advection of microscopic molecules by a region flow field that is read from a
+ * memory-mapped velocity grid
+ * - placed microscopic actor emissions in batches
+ * - recorded observed molecule positions in a coordinate buffer of each passive actor
+ * - added logging of molecules captured by absorbing and receptor surfaces
+ * - added quantized and delta-encoded recording of molecule positions
+ * - took the nodes of recent molecules from an arena of each list that is cleared every
+ * time step
+ *
  * Revision v0.5 (2016-04-15)
  * - added surface reactions, including membrane transitions
  * - added switch to record all molecules in a region instead of just those
@@ -55,6 +65,15 @@
 #include "meso.h"
 #include "subvolume.h"
 #include "global_param.h" // for common global parameters
+#include "flow_field.h" // for sampling flow velocity fields
+#include "arena.h" // for memory of recent molecules
+
+// Maximum number of grid cells along each dimension when quantizing
+// positions (the Morton code of a cell must fit in 63 bits)
+#define MAX_POS_CELL 2097152U
+
+// Maximum number of bytes needed to encode one quantized position
+#define MAX_POS_CODE_BYTES 10ULL
 
 // micro_molecule specific declarations
 
@@ -85,7 +104,66 @@ typedef struct nodeRecent3D{
 } NodeMolRecent3D;
 
 typedef NodeMol3D * ListMol3D;
-typedef NodeMolRecent3D * ListMolRecent3D;
+
+// Recent molecules only exist until the end of the current time step, so
+// their nodes are taken from an arena that is cleared with the list
+typedef struct list_MolRecent3D{
+	NodeMolRecent3D * head; // Pointer to first molecule
+	struct memArena arena; // Memory of nodes
+} ListMolRecent3D;
+
+/* The molPosBuffer3D structure is a growable array of molecule coordinates.
+* A passive actor appends the positions that it observes to its own buffer,
+* and each observation refers to a range of the buffer.
+* If the actor quantizes positions, then coor only holds the positions of the
+* observation being made, which are then encoded and moved to code
+*/
+struct molPosBuffer3D {
+	double * coor; // {mol1X, mol1Y, mol1Z, mol2X, mol2Y, mol2Z, ...}
+	uint64_t numPos; // Number of positions stored
+	uint64_t maxPos; // Number of positions that fit in allocated memory
+	unsigned char * code; // Encoded positions (see posQuantizer)
+	uint64_t numCodeByte; // Number of bytes of encoded positions
+	uint64_t maxCodeByte; // Number of bytes that fit in allocated memory
+};
+
+/* The posQuantizer structure defines the grid onto which a passive actor
+* quantizes the positions that it records. Each position is replaced by the
+* Morton (Z-order) code of its grid cell. The codes of one observation are
+* sorted and each is stored as its difference from the previous code (the
+* first is stored as is), written as an unsigned integer with 7 bits per byte
+* and the high bit of each byte set if more bytes follow
+*/
+struct posQuantizer {
+	double origin[3]; // Lower corner of the grid
+	double originCell[3]; // Lower corner of the grid in units of grid cells
+	double invResolution; // Reciprocal of width of a grid cell
+	uint32_t numCell[3]; // Number of grid cells along each dimension
+	uint64_t * key; // Temporary space for sorting the codes of an observation
+	uint64_t maxKey; // Number of codes that fit in key
+};
+
+/* The surfaceCapture3D structure describes one molecule that was captured by
+* an absorbing or receptor surface reaction while diffusing
+*/
+struct surfaceCapture3D {
+	double x, y, z; // Where the molecule reacted with the surface
+	short region; // Surface region where the reaction occurred
+	unsigned short molType; // Type of molecule captured
+};
+
+/* The captureLog3D structure collects the molecules captured in one
+* microscopic time step by the surface regions that are being logged
+*/
+struct captureLog3D {
+	// Are captures in each region logged? Length is NUM_REGIONS
+	bool * bRegionLogged;
+	
+	// Captures in the current time step. Length is maxCapture
+	struct surfaceCapture3D * capture;
+	uint32_t numCapture;
+	uint32_t maxCapture;
+};
 
 // micro_molecule specific Prototypes
 
@@ -93,6 +171,11 @@ bool addMolecule(ListMol3D * p_list, double x, double y, double z);
 
 bool addMoleculeRecent(ListMolRecent3D * p_list, double x, double y, double z, double dt_partial);
 
+// Create many new molecules that share the same partial time step. Memory for
+// all of their nodes is reserved at once
+bool addMoleculesRecent(ListMolRecent3D * p_list, double point[][3],
+		const uint32_t numMol, double dt_partial);
+
 void moveMolecule(ItemMol3D * molecule, double x, double y, double z);
 
 void moveMoleculeRecent(ItemMolRecent3D * molecule, double x, double y, double z);
@@ -106,7 +189,8 @@ void diffuseMolecules(const short NUM_REGIONS,
 	struct subvolume3D subvolArray[],
 	double sigma_diff[NUM_REGIONS][NUM_MOL_TYPES],
 	double sigma_flow[NUM_REGIONS],
-	double DIFF_COEF[NUM_REGIONS][NUM_MOL_TYPES]);
+	double DIFF_COEF[NUM_REGIONS][NUM_MOL_TYPES],
+	struct captureLog3D * captureLog);
 
 void diffuseOneMolecule(ItemMol3D * molecule, double sigma);
 
@@ -114,6 +198,15 @@ void diffuseOneMoleculeRecent(ItemMolRecent3D * molecule, double DIFF_COEF);
 
 void processFlow(ItemMol3D* molecule, const struct region curRegion, double delta);
 
+// Move one molecule by the flow field velocity at its location multiplied by dt
+void advectOneMolecule(ItemMol3D * molecule, const struct flowField * field,
+		double dt);
+
+// Move one molecule by the flow field velocity at its location multiplied by
+// its partial time step
+void advectOneMoleculeRecent(ItemMolRecent3D * molecule,
+		const struct flowField * field);
+
 void rxnFirstOrder(ListMol3D * p_list,
 	const struct region regionArray,
 	unsigned short curMolType,
@@ -165,14 +258,14 @@ uint64_t countMoleculesRecent(ListMolRecent3D * p_list,
 	double boundary[]);
 
 uint64_t recordMolecules(ListMol3D * p_list,
-	ListMol3D * recordList,
+	struct molPosBuffer3D * recordBuffer,
 	int obsType,
 	double boundary[],
 	bool bRecordPos,
 	bool bRecordAll);
 
 uint64_t recordMoleculesRecent(ListMolRecent3D * p_list,
-	ListMol3D * recordList,
+	struct molPosBuffer3D * recordBuffer,
 	int obsType,
 	double boundary[],
 	bool bRecordPos,
@@ -198,7 +291,49 @@ bool isListMol3DRecentEmpty(const ListMolRecent3D * p_list);
 
 void emptyListMol(ListMol3D * p_list);
 
+// Remove all molecules but keep their memory for re-use
+void clearListMol3DRecent(ListMolRecent3D * p_list);
+
 void emptyListMol3DRecent(ListMolRecent3D * p_list);
 
+// Position buffer Prototypes
+
+void initializeMolPosBuffer(struct molPosBuffer3D * buffer);
+
+// Append one molecule position to the end of a buffer
+bool addMolPos(struct molPosBuffer3D * buffer, double x, double y, double z);
+
+// Make room for numPos positions at the end of a buffer and return a pointer
+// to the first of them (or NULL if memory could not be allocated)
+double * reserveMolPos(struct molPosBuffer3D * buffer, uint64_t numPos);
+
+// Remove all positions but keep the allocated memory for re-use
+void clearMolPosBuffer(struct molPosBuffer3D * buffer);
+
+// Encode all positions in coor of a buffer, append them to its code, and
+// remove them from coor
+bool encodeMolPos(struct molPosBuffer3D * buffer,
+	struct posQuantizer * quant);
+
+// Read one encoded value starting at code[*curByte] and advance *curByte
+uint64_t readPosCode(const unsigned char code[],
+	uint64_t * curByte);
+
+void deleteMolPosBuffer(struct molPosBuffer3D * buffer);
+
+// Capture log Prototypes
+
+// Allocate a capture log with no regions logged
+void initializeCaptureLog(const short NUM_REGIONS,
+	struct captureLog3D * captureLog);
+
+// Add a molecule captured by a surface reaction to a capture log
+bool addSurfaceCapture(struct captureLog3D * captureLog,
+	const double point[3],
+	const short region,
+	const unsigned short molType);
+
+void deleteCaptureLog(struct captureLog3D * captureLog);
+
 
 #endif // MICRO_MOLECULE_H
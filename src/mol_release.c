@@ -7,13 +7,16 @@
  * For license details, read LICENSE.txt in the root AcCoRD directory
  * For user documentation, read README.txt in the root AcCoRD directory
  *
- * mol_release.c - 	linked list of "current" molecule releases associated
+ * mol_release.c - 	heap of "current" molecule releases associated
  * 					with an active actor
  *
- * Last revised for AcCoRD v0.3.1
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - kept active actor releases in an array-backed min-heap
+ *
  * Revision v0.3.1
  * - header added
  *
@@ -26,11 +29,13 @@
 
 static bool addItem(ItemRelease item, ListRelease * list);
 
-static void removeItem(NodeRelease * prevNode, NodeRelease * curNode);
+static void removeItem(ListRelease * list, const unsigned int itemInd);
+
+static bool bItemBefore(const ItemRelease * item1, const ItemRelease * item2);
 
-static void traverse(const ListRelease * list, void (* p_fun)(ItemRelease item));
+static void siftUp(ListRelease * list, unsigned int itemInd);
 
-static void copyToNode(ItemRelease item, NodeRelease * p_node);
+static void siftDown(ListRelease * list, unsigned int itemInd);
 
 // Specific Definitions
 
@@ -42,33 +47,26 @@ bool addRelease(ListRelease * list,
 	double endTime,
 	double frequency)
 {	
-	ItemRelease newRelease = {strength, molType, startTime, endTime, frequency};
+	ItemRelease newRelease = {strength, molType, startTime, endTime, frequency,
+		list->numAdded++};
 	return addItem(newRelease, list);
 }
 
 void deleteRelease(ListRelease * list,
 	const unsigned int releaseInd)
 {
-	NodeRelease * curRelease = *list;
-	NodeRelease * prevRelease = NULL;
-	NodeRelease * nextRelease;
-	unsigned int curReleaseInd;
-	
-	// Traverse release list to the current release
-	for(curReleaseInd = 0;
-		curReleaseInd < releaseInd;
-		curReleaseInd++)
-	{
-		prevRelease = curRelease;
-		curRelease = curRelease->next;
-	}
-	nextRelease = curRelease->next;
-	
-	removeItem(prevRelease, curRelease);
-	if(prevRelease == NULL)
-	{ // We removed the first release. nextRelease is now the start of the list
-		* list = nextRelease;
-	}
+	removeItem(list, releaseInd);
+}
+
+// Restore heap order after nextTime of a release was changed
+void updateRelease(ListRelease * list,
+	const unsigned int releaseInd)
+{
+	if(releaseInd > 0
+		&& bItemBefore(&list->item[releaseInd], &list->item[(releaseInd-1)/2]))
+		siftUp(list, releaseInd);
+	else
+		siftDown(list, releaseInd);
 }
 
 // General Definitions
@@ -76,74 +74,109 @@ void deleteRelease(ListRelease * list,
 // Initialize list
 void initializeListRelease(ListRelease * list)
 {
-	* list = NULL;
+	list->item = NULL;
+	list->numItem = 0;
+	list->maxItem = 0;
+	list->numAdded = 0;
 }
 
 // Is the list empty?
 bool isListReleaseEmpty(const ListRelease * list)
 {
-	if(list == NULL) return true;
+	if(list->numItem == 0) return true;
 	return false;
 }
 
-// Create new node to hold item and add it to the start of the list
+// Add item to the end of the array and move it up to its place in the heap.
+// Array size is doubled if it is full
 bool addItem(ItemRelease item, ListRelease * list)
 {
-	NodeRelease * p_new;
+	ItemRelease * p_new;
+	unsigned int newMax;
 	
-	p_new = malloc(sizeof(NodeRelease));
-	if (p_new == NULL)
-		return false;	// Quit on failure of malloc
-		
-	copyToNode(item, p_new);
-	p_new->next = * list;
-	* list = p_new; // Point start of list to new node
+	if(list->numItem == list->maxItem)
+	{
+		newMax = (list->maxItem > 0) ? 2*list->maxItem : 4;
+		p_new = realloc(list->item, newMax*sizeof(ItemRelease));
+		if (p_new == NULL)
+			return false;	// Quit on failure of realloc
+		list->item = p_new;
+		list->maxItem = newMax;
+	}
+	
+	list->item[list->numItem] = item; // Structure copy
+	siftUp(list, list->numItem++);
 	return true;
 }
 
-// Remove node from list. In order to do this efficiently, need to pass Nodes
-// and not the start of the list.
-void removeItem(NodeRelease * prevNode, NodeRelease * curNode)
+// Remove item from heap by replacing it with the last item in the array
+void removeItem(ListRelease * list, const unsigned int itemInd)
 {
-	if (curNode != NULL)
+	if (itemInd < list->numItem)
 	{
-		if (prevNode != NULL)
+		list->numItem--;
+		if (itemInd < list->numItem)
 		{
-			// Update pointer of previous node to point to following node
-			prevNode->next = curNode->next;		
+			list->item[itemInd] = list->item[list->numItem];
+			updateRelease(list, itemInd);
 		}
-		free(curNode); // Free memory of node
 	}
 }
 
-// Visit each node and execute the function pointed to by p_fun
-// p_fun must be a void function that takes an item as input
-void traverse(const ListRelease * list, void (* p_fun)(ItemRelease item))
+// Does item1 belong above item2 in the heap?
+static bool bItemBefore(const ItemRelease * item1, const ItemRelease * item2)
+{
+	if(item1->nextTime != item2->nextTime)
+		return item1->nextTime < item2->nextTime;
+	return item1->addOrder > item2->addOrder;
+}
+
+// Move item towards the root until its parent comes before it
+static void siftUp(ListRelease * list, unsigned int itemInd)
 {
-	NodeRelease * p_node = *list;
+	ItemRelease item = list->item[itemInd];
+	unsigned int parentInd;
 	
-	while(p_node != NULL)
+	while(itemInd > 0)
 	{
-		(*p_fun)(p_node->item); // Apply function
-		p_node = p_node->next;  // Advance to next item
+		parentInd = (itemInd-1)/2;
+		if(!bItemBefore(&item, &list->item[parentInd]))
+			break;
+		list->item[itemInd] = list->item[parentInd];
+		itemInd = parentInd;
 	}
+	list->item[itemInd] = item;
 }
 
-// De-allocate memory of all nodes in the list
-void emptyListRelease(ListRelease * list)
+// Move item away from the root until it comes before both of its children
+static void siftDown(ListRelease * list, unsigned int itemInd)
 {
-	NodeRelease * p_save;
+	ItemRelease item = list->item[itemInd];
+	unsigned int childInd;
 	
-	while(*list != NULL)
+	while((childInd = 2*itemInd + 1) < list->numItem)
 	{
-		p_save = (*list)->next;	// Save address of next node
-		free(*list);				// Free memory of current node
-		*list = p_save;			// Advance to next node
+		if(childInd + 1 < list->numItem
+			&& bItemBefore(&list->item[childInd + 1], &list->item[childInd]))
+			childInd++;
+		if(!bItemBefore(&list->item[childInd], &item))
+			break;
+		list->item[itemInd] = list->item[childInd];
+		itemInd = childInd;
 	}
+	list->item[itemInd] = item;
 }
 
-// Copy an item to a node
-static void copyToNode(ItemRelease item, NodeRelease * p_node)
+// Remove all releases but keep the array for re-use
+void clearListRelease(ListRelease * list)
+{
+	list->numItem = 0;
+	list->numAdded = 0;
+}
+
+// De-allocate memory of the array
+void emptyListRelease(ListRelease * list)
 {
-	p_node->item = item; // Structure copy
+	free(list->item);
+	initializeListRelease(list);
 }
@@ -7,13 +7,16 @@
  * For license details, read LICENSE.txt in the root AcCoRD directory
  * For user documentation, read README.txt in the root AcCoRD directory
  *
- * mol_release.h - 	linked list of "current" molecule releases associated
+ * mol_release.h - 	heap of "current" molecule releases associated
  * 					with an active actor
  *
- * Last revised for AcCoRD v0.3.1
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - kept active actor releases in an array-backed min-heap
+ *
  * Revision v0.3.1
  * - header added
  *
@@ -36,18 +39,24 @@ struct singleRelease {
 	double nextTime; // Global next time for a molecule release corresponding to this emission
 	double endTime; // Global end time associated with this emission
 	double frequency; // Release frequency (if modulation has an associated frequency)
+	unsigned long addOrder; // Order in which release was added to the list
 };
 
-// General (linked list) type declarations
+// General (heap) type declarations
 
 typedef struct singleRelease ItemRelease;
 
-typedef struct node_Release{
-	ItemRelease item;
-	struct node_Release * next;
-} NodeRelease;
-
-typedef NodeRelease * ListRelease;
+/* The current releases of an active actor are kept in a binary min-heap
+* ordered by nextTime, so the next emission is always item[0]. The items are
+* stored in one array that grows as needed and is kept between realizations.
+* Ties in nextTime go to the most recently added release.
+*/
+typedef struct {
+	ItemRelease * item; // Heap-ordered array of releases
+	unsigned int numItem; // Number of current releases
+	unsigned int maxItem; // Number of releases that fit in the array
+	unsigned long numAdded; // Number of releases added since list was cleared
+} ListRelease;
 
 // observations specific Prototypes
 
@@ -61,12 +70,19 @@ bool addRelease(ListRelease * list,
 void deleteRelease(ListRelease * list,
 	const unsigned int releaseInd);
 
+// Restore heap order after nextTime of a release was changed
+void updateRelease(ListRelease * list,
+	const unsigned int releaseInd);
+
 // General Prototypes
 
 void initializeListRelease(ListRelease * list);
 
 bool isListReleaseEmpty(const ListRelease * list);
 
+// Remove all releases but keep the array for re-use
+void clearListRelease(ListRelease * list);
+
 void emptyListRelease(ListRelease * list);
 
 
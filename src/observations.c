@@ -9,10 +9,15 @@
  *
  * observations.c - 	linked list of observations made by a passive actor
  *
- * Last revised for AcCoRD v0.4.1
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - recorded observed molecule positions in a coordinate buffer of each passive actor
+ * - added quantized and delta-encoded recording of molecule positions
+ * - allocated observations from an arena of each list that is reset every realization
+ *
  * Revision v0.4.1
  * - improved use and format of error messages
  *
@@ -42,29 +47,21 @@ bool addObservation(ListObs3D * list,
 	const unsigned short numUllong,
 	double * paramDouble,
 	uint64_t * paramUllong,
-	ListMol3D molPos [])
+	struct molPosBuffer3D molPos [],
+	struct posQuantizer * posQuant)
 {
-	NodeMol3D * molPosList;
 	unsigned short curMolInd;
 	
-	// Allocate memory
+	// Allocate memory from the list's arena
 	unsigned short curData;
-	double * paramDoubleNew = malloc(numDouble * sizeof(double));
+	double * paramDoubleNew = arenaAlloc(&list->arena, numDouble * sizeof(double));
 	uint64_t * paramUllongNew =
-		malloc(numUllong * sizeof(uint64_t));
-	ListMol3D ** molPosListNew = malloc(list->numMolTypeObs * sizeof(ListMol3D *));
-	if(paramDoubleNew == NULL || paramDoubleNew == NULL || molPosListNew == NULL)
+		arenaAlloc(&list->arena, numUllong * sizeof(uint64_t));
+	struct obsPosRange * molPosNew =
+		arenaAlloc(&list->arena, list->numMolTypeObs * sizeof(struct obsPosRange));
+	if(paramDoubleNew == NULL || paramUllongNew == NULL || molPosNew == NULL)
 		return false;
 	
-	for(curMolInd = 0; curMolInd < list->numMolTypeObs; curMolInd++)
-	{
-		molPosListNew[curMolInd] = malloc(sizeof(ListMol3D));
-		if(molPosListNew[curMolInd] == NULL)
-			return false;
-		initializeListMol(molPosListNew[curMolInd]);
-	}
-	
-	
 	// Copy array data
 	for(curData = 0; curData < numDouble; curData++)
 	{
@@ -75,30 +72,28 @@ bool addObservation(ListObs3D * list,
 		paramUllongNew[curData] = paramUllong[curData];
 	}
 	
-	// Copy molecule coordinate lists
+	// Find range of molecule coordinates added since the previous observation
 	for(curMolInd = 0; curMolInd < list->numMolTypeObs; curMolInd++)
 	{
-		molPosList = molPos[curMolInd];
-		if(!isListMol3DEmpty(&molPos[curMolInd]))
-		{
-			while(molPosList != NULL)
-			{
-				if(!addMolecule(molPosListNew[curMolInd],
-					molPosList->item.x, molPosList->item.y, molPosList->item.z))
-				{
-					// Creation of molecule failed
-					fprintf(stderr, "ERROR: Memory allocation to record molecule positions.\n");
-					exit(EXIT_FAILURE);
-				}
-				molPosList = molPosList->next;
-			}
-		} else
+		if(posQuant != NULL)
 		{
-			*(molPosListNew[curMolInd]) = NULL;
+			// Buffer only has the new positions. Encode them
+			molPosNew[curMolInd].offset = molPos[curMolInd].numCodeByte;
+			molPosNew[curMolInd].count = molPos[curMolInd].numPos;
+			if(!encodeMolPos(&molPos[curMolInd], posQuant))
+				return false;
+			continue;
 		}
+		if(list->tail == NULL)
+			molPosNew[curMolInd].offset = 0;
+		else
+			molPosNew[curMolInd].offset = list->tail->item.molPos[curMolInd].offset
+				+ list->tail->item.molPos[curMolInd].count;
+		molPosNew[curMolInd].count =
+			molPos[curMolInd].numPos - molPosNew[curMolInd].offset;
 	}
 	
-	ItemObs3D newObs3D = {numDouble,numUllong,paramDoubleNew,paramUllongNew,molPosListNew};
+	ItemObs3D newObs3D = {numDouble,numUllong,paramDoubleNew,paramUllongNew,molPosNew};
 	return addItem(newObs3D, list);
 }
 
@@ -111,6 +106,7 @@ void initializeListObs(ListObs3D * list,
 	list->numMolTypeObs = numMolTypeObs;
 	list->head = NULL;
 	list->tail = NULL;
+	initializeArena(&list->arena);
 }
 
 // Is the list empty?
@@ -125,9 +121,9 @@ bool addItem(ItemObs3D item, ListObs3D * list)
 {
 	NodeObs3D * p_new;
 	
-	p_new = malloc(sizeof(NodeObs3D));
+	p_new = arenaAlloc(&list->arena, sizeof(NodeObs3D));
 	if (p_new == NULL)
-		return false;	// Quit on failure of malloc
+		return false;	// Quit on failure of allocation
 		
 	copyToNode(item, p_new);
 	p_new->next = NULL;
@@ -145,8 +141,7 @@ bool addItem(ItemObs3D item, ListObs3D * list)
 
 // Remove node from list. In order to do this efficiently, need to pass Nodes
 // and not the start of the list.
-// TODO: Update this function for current list type (it does not currently have the
-// correct free calls but the function is not called so it is not a problem)
+// Memory of the node stays in the list's arena until the list is cleared
 void removeItem(NodeObs3D * prevNode, NodeObs3D * curNode)
 {
 	if (curNode != NULL)
@@ -156,7 +151,6 @@ void removeItem(NodeObs3D * prevNode, NodeObs3D * curNode)
 			// Update pointer of previous node to point to following node
 			prevNode->next = curNode->next;		
 		}
-		free(curNode); // Free memory of node
 	}
 }
 
@@ -173,28 +167,19 @@ void traverse(const ListObs3D * list, void (* p_fun)(ItemObs3D item))
 	}
 }
 
+// Remove all observations but keep their memory for re-use
+void clearListObs(ListObs3D * list)
+{
+	list->head = NULL;
+	list->tail = NULL;
+	clearArena(&list->arena);
+}
+
 // De-allocate memory of all nodes in the list
 void emptyListObs(ListObs3D * list)
 {
-	NodeObs3D * p_save;
-	NodeObs3D * p_cur;
-	unsigned short curMolInd;
-	
-	while(list->head != NULL)
-	{
-		p_save = list->head->next;	// Save address of next node
-		free(list->head->item.paramDouble);
-		free(list->head->item.paramUllong);
-		for(curMolInd = 0; curMolInd < list->numMolTypeObs; curMolInd++)
-		{
-			if(!isListMol3DEmpty(list->head->item.molPos[curMolInd]))
-				emptyListMol(list->head->item.molPos[curMolInd]);
-			free(list->head->item.molPos[curMolInd]);
-		}
-		free(list->head->item.molPos);
-		free(list->head);				// Free memory of current node
-		list->head = p_save;			// Advance to next node
-	}
+	deleteArena(&list->arena);
+	initializeListObs(list, list->numMolTypeObs);
 }
 
 // Copy an item to a node
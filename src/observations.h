@@ -9,10 +9,15 @@
  *
  * observations.h - 	linked list of observations made by a passive actor
  *
- * Last revised for AcCoRD v0.4.1
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - recorded observed molecule positions in a coordinate buffer of each passive actor
+ * - added quantized and delta-encoded recording of molecule positions
+ * - allocated observations from an arena of each list that is reset every realization
+ *
  * Revision v0.4.1
  * - improved use and format of error messages
  *
@@ -27,19 +32,27 @@
 #include <stdio.h> // to create and edit files
 #include <stdlib.h> // for exit(), malloc, free, NULL
 #include <stdbool.h> // for C++ bool naming, requires C99
-#include "micro_molecule.h" // for list of molecule positions
+#include "micro_molecule.h" // for buffers of molecule positions
+#include "arena.h" // for memory of observations
 
 // observations specific declarations
 
+// Range of positions in a molecule position buffer
+struct obsPosRange {
+	uint64_t offset; // Index of first position (or first byte if encoded)
+	uint64_t count; // Number of positions
+};
+
 // paramUllong = {numMol1 ... numMolN}
-// paramDouble = {recordTime, mol1Pos1X, mol1Pos1Y, mol1Pos1Z,
-// 		mol1Pos2X, mol1Pos2Y, mol1Pos2Z, ... molNPosMX, molNPosMY, molNPosMZ}
+// paramDouble = {recordTime}
+// molPos = {range of mol1 positions, ... range of molN positions}, where the
+// 		positions of each molecule type are stored in the actor's position buffer
 struct observation_list3D {
 	unsigned short numDouble; // number of double parameters
 	unsigned short numUllong; // number of uint64_t parameters
 	double * paramDouble; // array of double parameters
 	uint64_t * paramUllong; // array of uint64_t parameters
-	ListMol3D ** molPos; // Linked list of molecule coordinates
+	struct obsPosRange * molPos; // Range of molecule coordinates in buffers
 };
 
 // General (linked list) type declarations
@@ -55,16 +68,23 @@ typedef struct list_Obs3D{
 	unsigned short numMolTypeObs; // Number of types of molecules being observed
 	NodeObs3D * head; // Pointer to first observation
 	NodeObs3D * tail; // Pointer to most recent observation
+	struct memArena arena; // Memory of nodes and their parameters
 } ListObs3D;
 
 // observations specific Prototypes
 
+// Create new observation. The positions added to each buffer since the
+// previous observation in the list belong to the new observation, so the
+// buffers must be cleared whenever the list is emptied.
+// If posQuant is not NULL, then the new positions are encoded and the
+// observation's range refers to bytes of the buffer's code
 bool addObservation(ListObs3D * list,
 	const unsigned short numDouble,
 	const unsigned short numUllong,
 	double paramDouble[],
 	uint64_t paramUllong[],
-	ListMol3D molPos[]);
+	struct molPosBuffer3D molPos[],
+	struct posQuantizer * posQuant);
 
 // General Prototypes
 
@@ -73,6 +93,9 @@ void initializeListObs(ListObs3D * list,
 
 bool isListEmptyObs(const ListObs3D * list);
 
+// Remove all observations but keep their memory for re-use
+void clearListObs(ListObs3D * list);
+
 void emptyListObs(ListObs3D * list);
 
 
@@ -0,0 +1,443 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * output_writer.c - hand off the results of completed realizations to a
+ *				writer thread so that output is written while the next
+ *				realization is simulated
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifdef __linux__
+	#define _POSIX_C_SOURCE 200112L // for pthreads
+#endif // __linux__
+#include "output_writer.h"
+#include "file_io.h" // for printOneTextRealization()
+#include "profile.h" // for timing of output
+
+//
+// "Private" Declarations
+//
+
+// Allocate empty buffers for one slot of the queue
+static void initializeRealizationOutput(struct realizationOutput * result,
+	const short numActorRecord,
+	const short * actorRecordID,
+	const short NUM_ACTORS_ACTIVE,
+	const short NUM_ACTORS_PASSIVE,
+	const struct actorStruct3D actorCommonArray[],
+	const struct actorPassiveStruct3D actorPassiveArray[]);
+
+// Write the realization in the next slot of the queue and empty its buffers
+static void writeRealizationOutput(struct outputWriter * writer,
+	struct realizationOutput * result);
+
+// Free memory of one slot of the queue
+static void deleteRealizationOutput(struct realizationOutput * result,
+	const short numActorRecord,
+	const short NUM_ACTORS_ACTIVE,
+	const short NUM_ACTORS_PASSIVE,
+	const struct actorPassiveStruct3D actorPassiveArray[]);
+
+#ifdef __linux__
+// Writer thread. Writes queued realizations until the simulation is finished
+static void * runOutputWriter(void * arg);
+#endif // __linux__
+
+//
+// Definitions
+//
+
+// Allocate the queue and start the writer thread
+void startOutputWriter(struct outputWriter * writer,
+	FILE * out,
+	const struct simSpec3D * spec,
+	const short numActorRecord,
+	short * actorRecordID,
+	const short NUM_ACTORS_ACTIVE,
+	const short NUM_ACTORS_PASSIVE,
+	const struct actorStruct3D actorCommonArray[],
+	const struct actorActiveStruct3D actorActiveArray[],
+	const struct actorPassiveStruct3D actorPassiveArray[],
+	uint32_t maxActiveBits[],
+	uint32_t maxPassiveObs[],
+	uint32_t maxAbsorbCount[])
+{
+	unsigned short curSlot;
+
+	writer->out = out;
+	writer->spec = spec;
+	writer->numActorRecord = numActorRecord;
+	writer->actorRecordID = actorRecordID;
+	writer->NUM_ACTORS_ACTIVE = NUM_ACTORS_ACTIVE;
+	writer->NUM_ACTORS_PASSIVE = NUM_ACTORS_PASSIVE;
+	writer->actorCommonArray = actorCommonArray;
+	writer->actorActiveArray = actorActiveArray;
+	writer->actorPassiveArray = actorPassiveArray;
+	writer->maxActiveBits = maxActiveBits;
+	writer->maxPassiveObs = maxPassiveObs;
+	writer->maxAbsorbCount = maxAbsorbCount;
+	writer->nextWrite = 0;
+	writer->numQueued = 0;
+	writer->bFinished = false;
+	writer->numOutputBytes = 0;
+	writer->chunk = NULL;
+	writer->chunkOffset = NULL;
+
+	if(spec->OUTPUT_CODEC != OUTPUT_CODEC_NONE)
+	{
+		writer->chunk = tmpfile();
+		writer->chunkOffset = malloc(spec->NUM_REPEAT*sizeof(uint64_t));
+		if(writer->chunk == NULL
+			|| (writer->chunkOffset == NULL && spec->NUM_REPEAT > 0))
+		{
+			fprintf(stderr, "ERROR: Temporary storage for compressing output could not be created.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	writer->shm.header = NULL;
+	writer->shm.name = NULL;
+	if(spec->bShmOutput)
+	{
+		openShmOutput(&writer->shm, spec->OUTPUT_NAME, spec->SEED,
+			spec->NUM_REPEAT, numActorRecord, spec->SHM_SIZE);
+	}
+
+	for(curSlot = 0; curSlot < OUTPUT_QUEUE_LENGTH; curSlot++)
+	{
+		initializeRealizationOutput(&writer->slot[curSlot], numActorRecord,
+			actorRecordID, NUM_ACTORS_ACTIVE, NUM_ACTORS_PASSIVE,
+			actorCommonArray, actorPassiveArray);
+	}
+
+#ifdef __linux__
+	if(pthread_mutex_init(&writer->lock, NULL) != 0
+		|| pthread_cond_init(&writer->cond, NULL) != 0
+		|| pthread_create(&writer->thread, NULL, runOutputWriter, writer) != 0)
+	{
+		fprintf(stderr, "ERROR: Output writer thread could not be started.\n");
+		exit(EXIT_FAILURE);
+	}
+#endif // __linux__
+}
+
+// Hand off the results of a completed realization to be written. The actors
+// and observation lists receive empty buffers in exchange. Waits if the
+// queue is full
+void submitRealization(struct outputWriter * writer,
+	const unsigned int curRepeat,
+	ListObs3D observationArray[],
+	struct actorActiveStruct3D actorActiveArray[],
+	struct actorPassiveStruct3D actorPassiveArray[])
+{
+	struct realizationOutput * result;
+	short curActor;
+	ListObs3D tempObs;
+	struct bitStream tempData;
+	struct molPosBuffer3D * tempPos;
+	struct absorptionLog3D * tempLog;
+
+	// The slot after the queued slots is not used by the writer thread
+#ifdef __linux__
+	pthread_mutex_lock(&writer->lock);
+	while(writer->numQueued == OUTPUT_QUEUE_LENGTH)
+		pthread_cond_wait(&writer->cond, &writer->lock);
+	result = &writer->slot[(writer->nextWrite + writer->numQueued)
+		% OUTPUT_QUEUE_LENGTH];
+	pthread_mutex_unlock(&writer->lock);
+#else
+	result = &writer->slot[0];
+#endif // __linux__
+	result->curRepeat = curRepeat;
+	for(curActor = 0; curActor < writer->numActorRecord; curActor++)
+	{
+		tempObs = result->observationArray[curActor];
+		result->observationArray[curActor] = observationArray[curActor];
+		observationArray[curActor] = tempObs;
+	}
+	for(curActor = 0; curActor < writer->NUM_ACTORS_ACTIVE; curActor++)
+	{
+		tempData = result->binaryData[curActor];
+		result->binaryData[curActor] = actorActiveArray[curActor].binaryData;
+		actorActiveArray[curActor].binaryData = tempData;
+	}
+	for(curActor = 0; curActor < writer->NUM_ACTORS_PASSIVE; curActor++)
+	{
+		tempPos = result->molPosBuffer[curActor];
+		result->molPosBuffer[curActor] = actorPassiveArray[curActor].molPosBuffer;
+		actorPassiveArray[curActor].molPosBuffer = tempPos;
+
+		tempLog = result->absorbLog[curActor];
+		result->absorbLog[curActor] = actorPassiveArray[curActor].absorbLog;
+		actorPassiveArray[curActor].absorbLog = tempLog;
+	}
+
+#ifdef __linux__
+	pthread_mutex_lock(&writer->lock);
+	writer->numQueued++;
+	pthread_cond_signal(&writer->cond);
+	pthread_mutex_unlock(&writer->lock);
+#else
+	// No writer thread. Write immediately
+	writeRealizationOutput(writer, result);
+	writer->numOutputBytes = (uint64_t) ftell(writer->out);
+#endif // __linux__
+}
+
+// Find the number of bytes in the output file after the most recent
+// realization was written
+uint64_t getOutputBytes(struct outputWriter * writer)
+{
+	uint64_t numOutputBytes;
+
+#ifdef __linux__
+	pthread_mutex_lock(&writer->lock);
+	numOutputBytes = writer->numOutputBytes;
+	pthread_mutex_unlock(&writer->lock);
+#else
+	numOutputBytes = writer->numOutputBytes;
+#endif // __linux__
+	return numOutputBytes;
+}
+
+// Wait for all submitted realizations to be written, then stop the writer
+// thread and mark the shared memory output (if any) as finished
+void finishOutputWriter(struct outputWriter * writer)
+{
+#ifdef __linux__
+	pthread_mutex_lock(&writer->lock);
+	writer->bFinished = true;
+	pthread_cond_signal(&writer->cond);
+	pthread_mutex_unlock(&writer->lock);
+	if(pthread_join(writer->thread, NULL) != 0)
+	{
+		fprintf(stderr, "ERROR: Output writer thread could not be stopped.\n");
+		exit(EXIT_FAILURE);
+	}
+#else
+	writer->bFinished = true;
+#endif // __linux__
+	closeShmOutput(&writer->shm);
+}
+
+// Free the queue and the realization positions of a finished writer
+void deleteOutputWriter(struct outputWriter * writer)
+{
+	unsigned short curSlot;
+
+#ifdef __linux__
+	pthread_cond_destroy(&writer->cond);
+	pthread_mutex_destroy(&writer->lock);
+#endif // __linux__
+	if(writer->chunk != NULL)
+		fclose(writer->chunk);
+	if(writer->chunkOffset != NULL)
+		free(writer->chunkOffset);
+
+	for(curSlot = 0; curSlot < OUTPUT_QUEUE_LENGTH; curSlot++)
+	{
+		deleteRealizationOutput(&writer->slot[curSlot], writer->numActorRecord,
+			writer->NUM_ACTORS_ACTIVE, writer->NUM_ACTORS_PASSIVE,
+			writer->actorPassiveArray);
+	}
+}
+
+#ifdef __linux__
+// Writer thread. Writes queued realizations until the simulation is finished
+static void * runOutputWriter(void * arg)
+{
+	struct outputWriter * writer = arg;
+	struct realizationOutput * result;
+
+	while(true)
+	{
+		pthread_mutex_lock(&writer->lock);
+		while(writer->numQueued == 0 && !writer->bFinished)
+			pthread_cond_wait(&writer->cond, &writer->lock);
+		if(writer->numQueued == 0)
+		{ // Simulation is finished and every realization has been written
+			pthread_mutex_unlock(&writer->lock);
+			break;
+		}
+		result = &writer->slot[writer->nextWrite];
+		pthread_mutex_unlock(&writer->lock);
+
+		writeRealizationOutput(writer, result);
+
+		pthread_mutex_lock(&writer->lock);
+		writer->numOutputBytes = (uint64_t) ftell(writer->out);
+		writer->nextWrite = (writer->nextWrite + 1) % OUTPUT_QUEUE_LENGTH;
+		writer->numQueued--;
+		pthread_cond_signal(&writer->cond);
+		pthread_mutex_unlock(&writer->lock);
+	}
+	return NULL;
+}
+#endif // __linux__
+
+// Write the realization in the next slot of the queue and empty its buffers
+static void writeRealizationOutput(struct outputWriter * writer,
+	struct realizationOutput * result)
+{
+	short curActor, curPassive;
+	unsigned short curMolInd;
+	long chunkLength;
+
+	PROFILE_START(PROFILE_OUTPUT);
+	if(writer->chunk == NULL)
+	{
+		printOneTextRealization(writer->out, *writer->spec, result,
+			writer->numActorRecord, writer->actorRecordID, writer->NUM_ACTORS_ACTIVE,
+			writer->actorCommonArray, writer->actorActiveArray,
+			writer->actorPassiveArray, writer->maxActiveBits, writer->maxPassiveObs,
+			writer->maxAbsorbCount);
+	} else
+	{ // Write realization as text to temporary file, then compress it to output
+		rewind(writer->chunk);
+		printOneTextRealization(writer->chunk, *writer->spec, result,
+			writer->numActorRecord, writer->actorRecordID, writer->NUM_ACTORS_ACTIVE,
+			writer->actorCommonArray, writer->actorActiveArray,
+			writer->actorPassiveArray, writer->maxActiveBits, writer->maxPassiveObs,
+			writer->maxAbsorbCount);
+		chunkLength = ftell(writer->chunk);
+		writer->chunkOffset[result->curRepeat] = (uint64_t) ftell(writer->out);
+		writeCompressedChunk(writer->out, writer->chunk, chunkLength);
+	}
+	publishRealization(&writer->shm, result, writer->numActorRecord,
+		writer->actorRecordID, writer->actorCommonArray,
+		writer->actorPassiveArray);
+	PROFILE_STOP(PROFILE_OUTPUT);
+
+	// Empty buffers so that they can be given back to the actors
+	for(curActor = 0; curActor < writer->numActorRecord; curActor++)
+		clearListObs(&result->observationArray[curActor]);
+	for(curActor = 0; curActor < writer->NUM_ACTORS_ACTIVE; curActor++)
+		clearBitStream(&result->binaryData[curActor]);
+	for(curPassive = 0; curPassive < writer->NUM_ACTORS_PASSIVE; curPassive++)
+	{
+		for(curMolInd = 0;
+			curMolInd < writer->actorPassiveArray[curPassive].numMolRecordID;
+			curMolInd++)
+		{
+			if(result->molPosBuffer[curPassive] != NULL)
+				clearMolPosBuffer(&result->molPosBuffer[curPassive][curMolInd]);
+			if(result->absorbLog[curPassive] != NULL)
+				result->absorbLog[curPassive][curMolInd].numEvent = 0;
+		}
+	}
+}
+
+// Allocate empty buffers for one slot of the queue
+static void initializeRealizationOutput(struct realizationOutput * result,
+	const short numActorRecord,
+	const short * actorRecordID,
+	const short NUM_ACTORS_ACTIVE,
+	const short NUM_ACTORS_PASSIVE,
+	const struct actorStruct3D actorCommonArray[],
+	const struct actorPassiveStruct3D actorPassiveArray[])
+{
+	short curActor, curPassive;
+	unsigned short curMolInd, numMolRecordID;
+
+	result->curRepeat = 0;
+	result->observationArray = malloc(numActorRecord*sizeof(ListObs3D));
+	result->binaryData = malloc(NUM_ACTORS_ACTIVE*sizeof(struct bitStream));
+	result->molPosBuffer = malloc(NUM_ACTORS_PASSIVE*sizeof(struct molPosBuffer3D *));
+	result->absorbLog = malloc(NUM_ACTORS_PASSIVE*sizeof(struct absorptionLog3D *));
+	if((result->observationArray == NULL && numActorRecord > 0)
+		|| (result->binaryData == NULL && NUM_ACTORS_ACTIVE > 0)
+		|| ((result->molPosBuffer == NULL || result->absorbLog == NULL)
+		&& NUM_ACTORS_PASSIVE > 0))
+	{
+		fprintf(stderr, "ERROR: Memory allocation for output writer queue.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	for(curActor = 0; curActor < numActorRecord; curActor++)
+	{
+		initializeListObs(&result->observationArray[curActor],
+			actorPassiveArray[actorCommonArray[actorRecordID[curActor]].passiveID].numMolRecordID);
+	}
+	for(curActor = 0; curActor < NUM_ACTORS_ACTIVE; curActor++)
+		initializeBitStream(&result->binaryData[curActor]);
+	for(curPassive = 0; curPassive < NUM_ACTORS_PASSIVE; curPassive++)
+	{
+		// Match the buffers that the actor has
+		numMolRecordID = actorPassiveArray[curPassive].numMolRecordID;
+		result->molPosBuffer[curPassive] = NULL;
+		result->absorbLog[curPassive] = NULL;
+		if(actorPassiveArray[curPassive].molPosBuffer != NULL)
+		{
+			result->molPosBuffer[curPassive] =
+				malloc(numMolRecordID*sizeof(struct molPosBuffer3D));
+			if(result->molPosBuffer[curPassive] == NULL && numMolRecordID > 0)
+			{
+				fprintf(stderr, "ERROR: Memory allocation for output writer queue.\n");
+				exit(EXIT_FAILURE);
+			}
+			for(curMolInd = 0; curMolInd < numMolRecordID; curMolInd++)
+				initializeMolPosBuffer(&result->molPosBuffer[curPassive][curMolInd]);
+		}
+		if(actorPassiveArray[curPassive].absorbLog != NULL)
+		{
+			result->absorbLog[curPassive] =
+				malloc(numMolRecordID*sizeof(struct absorptionLog3D));
+			if(result->absorbLog[curPassive] == NULL && numMolRecordID > 0)
+			{
+				fprintf(stderr, "ERROR: Memory allocation for output writer queue.\n");
+				exit(EXIT_FAILURE);
+			}
+			for(curMolInd = 0; curMolInd < numMolRecordID; curMolInd++)
+			{
+				result->absorbLog[curPassive][curMolInd].time = NULL;
+				result->absorbLog[curPassive][curMolInd].numEvent = 0;
+				result->absorbLog[curPassive][curMolInd].maxEvent = 0;
+			}
+		}
+	}
+}
+
+// Free memory of one slot of the queue
+static void deleteRealizationOutput(struct realizationOutput * result,
+	const short numActorRecord,
+	const short NUM_ACTORS_ACTIVE,
+	const short NUM_ACTORS_PASSIVE,
+	const struct actorPassiveStruct3D actorPassiveArray[])
+{
+	short curActor, curPassive;
+	unsigned short curMolInd;
+
+	for(curActor = 0; curActor < numActorRecord; curActor++)
+		emptyListObs(&result->observationArray[curActor]);
+	for(curActor = 0; curActor < NUM_ACTORS_ACTIVE; curActor++)
+		deleteBitStream(&result->binaryData[curActor]);
+	for(curPassive = 0; curPassive < NUM_ACTORS_PASSIVE; curPassive++)
+	{
+		for(curMolInd = 0;
+			curMolInd < actorPassiveArray[curPassive].numMolRecordID;
+			curMolInd++)
+		{
+			if(result->molPosBuffer[curPassive] != NULL)
+				deleteMolPosBuffer(&result->molPosBuffer[curPassive][curMolInd]);
+			if(result->absorbLog[curPassive] != NULL
+				&& result->absorbLog[curPassive][curMolInd].time != NULL)
+				free(result->absorbLog[curPassive][curMolInd].time);
+		}
+		if(result->molPosBuffer[curPassive] != NULL)
+			free(result->molPosBuffer[curPassive]);
+		if(result->absorbLog[curPassive] != NULL)
+			free(result->absorbLog[curPassive]);
+	}
+	free(result->observationArray);
+	free(result->binaryData);
+	free(result->molPosBuffer);
+	free(result->absorbLog);
+}
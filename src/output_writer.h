@@ -0,0 +1,154 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * output_writer.h - hand off the results of completed realizations to a
+ *				writer thread so that output is written while the next
+ *				realization is simulated
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <stdio.h> // for FILE
+#include <stdlib.h> // for exit(), malloc, free
+#include <stdbool.h> // for C++ bool naming, requires C99
+#include <stdint.h> // for uint32_t
+#ifdef __linux__
+	#include <pthread.h> // for writer thread
+#endif // __linux__
+#include "actor.h"
+#include "actor_data.h" // for active actor binary data
+#include "observations.h" // for observation structure (linked list)
+#include "micro_molecule.h" // for buffers of molecule positions
+#include "shm_output.h" // for publishing observations to shared memory
+
+//
+// Constant definitions
+//
+
+// Maximum number of completed realizations waiting to be written (including
+// the one being written). The simulation waits when all are in use
+#define OUTPUT_QUEUE_LENGTH 2
+
+//
+// Data Type Declarations
+//
+
+/* The realizationOutput structure holds the results of one realization.
+* The buffers are swapped with those of the actors, so handing off a
+* realization does not copy its data and the memory is reused.
+*/
+struct realizationOutput {
+	// Index of realization
+	unsigned int curRepeat;
+
+	// Observations of each recorded passive actor. Length is numActorRecord
+	ListObs3D * observationArray;
+
+	// Bits of each active actor. Length is NUM_ACTORS_ACTIVE
+	struct bitStream * binaryData;
+
+	// Molecule position buffers of each passive actor.
+	// Length is NUM_ACTORS_PASSIVE (each is NULL or has length numMolRecordID)
+	struct molPosBuffer3D ** molPosBuffer;
+
+	// Absorption logs of each passive actor.
+	// Length is NUM_ACTORS_PASSIVE (each is NULL or has length numMolRecordID)
+	struct absorptionLog3D ** absorbLog;
+};
+
+/* The outputWriter structure is a bounded queue of completed realizations
+* and the thread that writes them to the output file in order.
+*/
+struct outputWriter {
+	// Output file and the parameters needed to print a realization
+	FILE * out;
+	const struct simSpec3D * spec;
+	short numActorRecord;
+	short * actorRecordID;
+	short NUM_ACTORS_ACTIVE;
+	short NUM_ACTORS_PASSIVE;
+	const struct actorStruct3D * actorCommonArray;
+	const struct actorActiveStruct3D * actorActiveArray;
+	const struct actorPassiveStruct3D * actorPassiveArray;
+	uint32_t * maxActiveBits;
+	uint32_t * maxPassiveObs;
+	uint32_t * maxAbsorbCount;
+
+	// Ring of realization results. Slots from nextWrite to
+	// nextWrite + numQueued - 1 are waiting or being written
+	struct realizationOutput slot[OUTPUT_QUEUE_LENGTH];
+	unsigned short nextWrite;
+	unsigned short numQueued;
+
+	// Has the simulation finished submitting realizations?
+	bool bFinished;
+
+	// Bytes in output file after the most recent realization was written
+	uint64_t numOutputBytes;
+
+	// If the output is compressed, temporary file that holds one realization
+	// before it is compressed (NULL otherwise), and the position in the
+	// output file where each realization starts
+	FILE * chunk;
+	uint64_t * chunkOffset;
+
+	// Shared memory that observations are also published to (if specified)
+	struct shmOutput shm;
+
+#ifdef __linux__
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+#endif // __linux__
+};
+
+//
+// Function Declarations
+//
+
+// Allocate the queue and start the writer thread
+void startOutputWriter(struct outputWriter * writer,
+	FILE * out,
+	const struct simSpec3D * spec,
+	const short numActorRecord,
+	short * actorRecordID,
+	const short NUM_ACTORS_ACTIVE,
+	const short NUM_ACTORS_PASSIVE,
+	const struct actorStruct3D actorCommonArray[],
+	const struct actorActiveStruct3D actorActiveArray[],
+	const struct actorPassiveStruct3D actorPassiveArray[],
+	uint32_t maxActiveBits[],
+	uint32_t maxPassiveObs[],
+	uint32_t maxAbsorbCount[]);
+
+// Hand off the results of a completed realization to be written. The actors
+// and observation lists receive empty buffers in exchange. Waits if the
+// queue is full
+void submitRealization(struct outputWriter * writer,
+	const unsigned int curRepeat,
+	ListObs3D observationArray[],
+	struct actorActiveStruct3D actorActiveArray[],
+	struct actorPassiveStruct3D actorPassiveArray[]);
+
+// Find the number of bytes in the output file after the most recent
+// realization was written
+uint64_t getOutputBytes(struct outputWriter * writer);
+
+// Wait for all submitted realizations to be written, then stop the writer
+// thread and mark the shared memory output (if any) as finished
+void finishOutputWriter(struct outputWriter * writer);
+
+// Free the queue and the realization positions of a finished writer
+void deleteOutputWriter(struct outputWriter * writer);
+
+#endif // OUTPUT_WRITER_H
@@ -0,0 +1,74 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * profile.c - optional measurement of the wall time of each simulation
+ *				phase and of counts of events in the hot paths
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifdef __linux__
+	#define _POSIX_C_SOURCE 199309L // for clock_gettime()
+#endif // __linux__
+#include <time.h> // for clock_gettime(), clock()
+#include "profile.h"
+
+#ifdef ACCORD_PROFILE
+struct profileData accordProfile;
+#endif // ACCORD_PROFILE
+
+// Names of phases and counters in summary file
+static const char * PROFILE_PHASE_NAME[NUM_PROFILE_PHASE] = {
+	"Reset", "ZerothRxn", "FirstRxn", "Flow", "Diffusion", "MesoBoundary",
+	"MesoDiffusion", "MesoChemRxn", "NewRelease", "Emission", "Observation",
+	"Output", "OutputWait"};
+static const char * PROFILE_COUNTER_NAME[NUM_PROFILE_COUNTER] = {
+	"ZerothRxnEvent", "MicroMolStep", "MesoToMicro", "FollowCall",
+	"FollowMaxDepth", "Reflection", "PlacementPoint", "PlacementRetry",
+	"MesoHeapUpdate", "MesoHeapSwap", "TimerHeapUpdate", "TimerHeapShift"};
+
+// Current wall time in seconds (from an arbitrary start)
+double profileNow(void)
+{
+#ifdef __linux__
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) now.tv_sec + 1e-9 * now.tv_nsec;
+#else
+	return (double) clock() / CLOCKS_PER_SEC;
+#endif // __linux__
+}
+
+// Add the measurements to a JSON object as "Profile"
+void addProfileToJSON(cJSON * root,
+	const struct profileData * profile)
+{
+	cJSON * profileObj, * phaseObj, * curPhase, * counterObj;
+	unsigned short i;
+
+	cJSON_AddItemToObject(root, "Profile", profileObj = cJSON_CreateObject());
+	cJSON_AddItemToObject(profileObj, "Phase", phaseObj = cJSON_CreateObject());
+	for(i = 0; i < NUM_PROFILE_PHASE; i++)
+	{
+		cJSON_AddItemToObject(phaseObj, PROFILE_PHASE_NAME[i],
+			curPhase = cJSON_CreateObject());
+		cJSON_AddNumberToObject(curPhase, "Time", profile->phaseTime[i]);
+		cJSON_AddNumberToObject(curPhase, "Count",
+			(double) profile->phaseCount[i]);
+	}
+	cJSON_AddItemToObject(profileObj, "Counter",
+		counterObj = cJSON_CreateObject());
+	for(i = 0; i < NUM_PROFILE_COUNTER; i++)
+	{
+		cJSON_AddNumberToObject(counterObj, PROFILE_COUNTER_NAME[i],
+			(double) profile->counter[i]);
+	}
+}
@@ -0,0 +1,116 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * profile.h - optional measurement of the wall time of each simulation
+ *				phase and of counts of events in the hot paths. Only
+ *				enabled if AcCoRD is built with -DACCORD_PROFILE. Otherwise,
+ *				the PROFILE_ macros do nothing
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h> // for uint64_t
+#include <string.h> // for memset()
+#include "cJSON.h" // for adding results to summary file
+
+//
+// Constant definitions
+//
+
+// Simulation phases that are timed
+// NOTE: Changes to list must be reflected in profile.c
+#define PROFILE_RESET 0 // Reset of state at start of each realization
+#define PROFILE_ZEROTH_RXN 1 // Microscopic zeroth order reactions
+#define PROFILE_FIRST_RXN 2 // Microscopic first order reactions
+#define PROFILE_FLOW 3 // Update of microscopic flow displacements
+#define PROFILE_DIFFUSION 4 // diffuseMolecules()
+#define PROFILE_MESO_BOUNDARY 5 // updateMesoSubBoundary()
+#define PROFILE_MESO_DIFFUSION 6 // Mesoscopic diffusion events
+#define PROFILE_MESO_CHEM_RXN 7 // Mesoscopic chemical reaction events
+#define PROFILE_NEW_RELEASE 8 // Start of new releases by active actors
+#define PROFILE_EMISSION 9 // Emissions of molecules by active actors
+#define PROFILE_OBSERVATION 10 // Observations by batches of passive actors
+#define PROFILE_OUTPUT 11 // Writing of realizations (by output writer)
+#define PROFILE_OUTPUT_WAIT 12 // Hand off of realizations to output writer
+#define NUM_PROFILE_PHASE 13
+
+// Event counters
+// NOTE: Changes to list must be reflected in profile.c
+#define PROFILE_ZEROTH_RXN_EVENT 0 // Zeroth order reactions fired
+#define PROFILE_MICRO_MOL_STEP 1 // Microscopic molecules diffused
+#define PROFILE_MESO_TO_MICRO 2 // Molecules moved from meso to micro regime
+#define PROFILE_FOLLOW_CALL 3 // Calls to followMolecule()
+#define PROFILE_FOLLOW_DEPTH 4 // Largest recursion depth of followMolecule()
+#define PROFILE_REFLECTION 5 // Reflections off of region boundaries
+#define PROFILE_PLACEMENT_POINT 6 // Random points placed in regions
+#define PROFILE_PLACEMENT_RETRY 7 // Rejected candidate points
+#define PROFILE_MESO_HEAP_UPDATE 8 // Updates of mesoscopic heap
+#define PROFILE_MESO_HEAP_SWAP 9 // Swaps in mesoscopic heap
+#define PROFILE_TIMER_HEAP_UPDATE 10 // Updates of timer heap
+#define PROFILE_TIMER_HEAP_SHIFT 11 // Levels moved in timer heap
+#define NUM_PROFILE_COUNTER 12
+
+//
+// Data Type Declarations
+//
+
+/* The profileData structure accumulates the measurements of a simulation.
+* The output writer thread only changes the PROFILE_OUTPUT phase.
+*/
+struct profileData {
+	double phaseTime[NUM_PROFILE_PHASE]; // Total time in each phase (seconds)
+	uint64_t phaseCount[NUM_PROFILE_PHASE]; // Number of times in each phase
+	double phaseStart[NUM_PROFILE_PHASE]; // Start of current time in phase
+	uint64_t counter[NUM_PROFILE_COUNTER];
+};
+
+#ifdef ACCORD_PROFILE
+extern struct profileData accordProfile;
+
+	#define PROFILE_CLEAR() \
+		memset(&accordProfile, 0, sizeof(accordProfile))
+	#define PROFILE_START(PHASE) \
+		(accordProfile.phaseStart[PHASE] = profileNow())
+	#define PROFILE_STOP(PHASE) \
+		do { \
+			accordProfile.phaseTime[PHASE] += \
+				profileNow() - accordProfile.phaseStart[PHASE]; \
+			accordProfile.phaseCount[PHASE]++; \
+		} while(0)
+	#define PROFILE_COUNT(COUNTER, NUM) \
+		(accordProfile.counter[COUNTER] += (NUM))
+	#define PROFILE_MAX(COUNTER, VALUE) \
+		do { \
+			if((VALUE) > accordProfile.counter[COUNTER]) \
+				accordProfile.counter[COUNTER] = (VALUE); \
+		} while(0)
+#else
+	#define PROFILE_CLEAR()
+	#define PROFILE_START(PHASE)
+	#define PROFILE_STOP(PHASE)
+	#define PROFILE_COUNT(COUNTER, NUM)
+	#define PROFILE_MAX(COUNTER, VALUE)
+#endif // ACCORD_PROFILE
+
+//
+// Function Declarations
+//
+
+// Current wall time in seconds (from an arbitrary start)
+double profileNow(void);
+
+// Add the measurements to a JSON object as "Profile"
+void addProfileToJSON(cJSON * root,
+	const struct profileData * profile);
+
+#endif // PROFILE_H
@@ -62,6 +62,10 @@ static char Rcs_Id[] ATTRIBUTE((used)) =
  *
  * $Log: randistrs.c,v $
  *
+ * Revision AcCoRD 2026-10-16. Added rds_binomial to generate a binomial RV
+ * by inversion for small means and by transformed rejection (Hormann's BTRD)
+ * otherwise.
+ *
  * Revision AcCoRD 0.4 2016-02-11 Adam Noel. Including this code with AcCoRD.
  * Minor changes made to speed up generation of normal RVs and a function
  * added (rds_poisson) to generate a Poisson RV from an exponential RV. Code
@@ -672,6 +676,130 @@ long long rds_poisson(
 		return poissonVal;
 	}
 
+// AcCoRD - Stirling series correction log(k!) - log of Stirling's
+// approximation of k!, as used by rds_binomial
+static double binomialStirlingCorrection(
+	double k)
+	{
+		return lgamma(k + 1.) - (k + 0.5)*log(k + 1.) + (k + 1.)
+			- 0.9189385332046728; // log(sqrt(2*pi))
+	}
+
+// AcCoRD - Binomial distribution. Number of successes in numTrial independent
+// trials that each succeed with probability prob. Uses inversion if the mean
+// is small and the transformed rejection method with decomposition (BTRD) of
+// W. Hormann, "The generation of binomial random variates," J. Statist.
+// Comput. Simul., 1993, otherwise. Both methods are exact.
+uint64_t rds_binomial(
+	mt_state* state,
+	uint64_t numTrial,
+	double prob)
+	{
+		double n, p, q, r, nr, npq, sq, b, a, c, alpha, vr, urvr;
+		double u, v, us, f, km, rho, t, h, nm, nk, i;
+		double m, k;
+		uint64_t numSuccess;
+		
+		if(numTrial == 0 || prob <= 0.)
+			return 0;
+		if(prob >= 1.)
+			return numTrial;
+		if(prob > 0.5) // Use symmetry so that p <= 0.5
+			return numTrial - rds_binomial(state, numTrial, 1. - prob);
+		
+		n = (double) numTrial;
+		p = prob;
+		q = 1. - p;
+		r = p/q;
+		
+		if(n*p < 10.)
+		{ // Inversion by sequential search from 0
+			f = pow(q, n);
+			u = mts_drand(state);
+			numSuccess = 0;
+			while(u > f && numSuccess < numTrial)
+			{
+				u -= f;
+				numSuccess++;
+				f *= ((n + 1.)*r/numSuccess - r);
+			}
+			return numSuccess;
+		}
+		
+		// BTRD setup
+		m = floor((n + 1.)*p);
+		nr = (n + 1.)*r;
+		npq = n*p*q;
+		sq = sqrt(npq);
+		b = 1.15 + 2.53*sq;
+		a = -0.0873 + 0.0248*b + 0.01*p;
+		c = n*p + 0.5;
+		alpha = (2.83 + 5.1/b)*sq;
+		vr = 0.92 - 4.2/b;
+		urvr = 0.86*vr;
+		
+		while(1)
+		{
+			v = mts_drand(state);
+			if(v <= urvr)
+			{ // Immediate acceptance in the center of the distribution
+				u = v/vr - 0.43;
+				return (uint64_t) floor((2.*a/(0.5 - fabs(u)) + b)*u + c);
+			}
+			if(v >= vr)
+			{
+				u = mts_drand(state) - 0.5;
+			} else
+			{
+				u = v/vr - 0.93;
+				u = ((u > 0.) ? 0.5 : -0.5) - u;
+				v = mts_drand(state)*vr;
+			}
+			
+			us = 0.5 - fabs(u);
+			k = floor((2.*a/us + b)*u + c);
+			if(k < 0. || k > n)
+				continue;
+			v = v*alpha/(a/(us*us) + b);
+			km = fabs(k - m);
+			
+			if(km <= 15.)
+			{ // Evaluate f(k)/f(m) recursively
+				f = 1.;
+				if(m < k)
+				{
+					for(i = m + 1.; i <= k; i++)
+						f *= (nr/i - r);
+				} else if(m > k)
+				{
+					for(i = k + 1.; i <= m; i++)
+						v *= (nr/i - r);
+				}
+				if(v <= f)
+					return (uint64_t) k;
+				continue;
+			}
+			
+			// Squeeze using upper and lower bounds on log(f(k))
+			v = log(v);
+			rho = (km/npq)*(((km/3. + 0.625)*km + 1./6.)/npq + 0.5);
+			t = -km*km/(2.*npq);
+			if(v < t - rho)
+				return (uint64_t) k;
+			if(v > t + rho)
+				continue;
+			
+			// Final acceptance test
+			nm = n - m + 1.;
+			h = (m + 0.5)*log((m + 1.)/(r*nm))
+				+ binomialStirlingCorrection(m) + binomialStirlingCorrection(n - m);
+			nk = n - k + 1.;
+			if(v <= h + (n + 1.)*log(nm/nk) + (k + 0.5)*log(nk*r/(k + 1.))
+				- binomialStirlingCorrection(k) - binomialStirlingCorrection(n - k))
+				return (uint64_t) k;
+		}
+	}
+
 /*
  * Generate a uniform integer distribution on the half-open interval
  * [lower, upper).  See comments on rds_iuniform.
@@ -1118,4 +1246,12 @@ long long rd_poisson(
 	double mean)
 	{
 		return rds_poisson(&mt_default_state, mean);
+	}
+
+// AcCoRD - Binomial distribution
+uint64_t rd_binomial(
+	uint64_t numTrial,
+	double prob)
+	{
+		return rds_binomial(&mt_default_state, numTrial, prob);
 	}
\ No newline at end of file
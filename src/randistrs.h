@@ -274,6 +274,9 @@ extern double		rds_continuous_empirical(mt_state* state,
 extern long long rds_poisson(mt_state* state,
 					double mean);
 					// ADAM - Poisson distribution
+extern uint64_t rds_binomial(mt_state* state,
+					uint64_t numTrial, double prob);
+					// AcCoRD - Binomial distribution
 
 /*
  * Functions that use the default state of the PRNG.
@@ -327,6 +330,8 @@ extern double		rd_continuous_empirical(rd_empirical_control* control);
 
 extern long long rd_poisson(double mean);
 					// ADAM - Poisson distribution
+extern uint64_t rd_binomial(uint64_t numTrial, double prob);
+					// AcCoRD - Binomial distribution
 
 #ifdef __cplusplus
     }
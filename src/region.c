@@ -10,10 +10,25 @@
  * region.c - 	operations for (microscopic or mesoscopic) regions in
  * 				simulation environment
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added voxel map of region membership so that most points are classified without
+ * testing every region
+ * - added closed-form reflection of molecules off the faces of box regions without
+ * children
+ * - bound a shape-specific point containment function to each region
+ * - added advection of microscopic molecules by a region flow field that is read from a
+ * memory-mapped velocity grid
+ * - added placement samplers so that molecules are placed directly instead of by
+ * rejection
+ * - placed microscopic actor emissions in batches
+ * - batched passive actor observations that occur at the same time
+ * - added opt-in profiling of simulation phases
+ * - added reset of the parameters that can change between the simulations of a sweep
+ *
  * Revision v0.5 (2016-04-15)
  * - re-structured region array initialization to nest more code in functions
  * - added more checks on region parameters (including label uniqueness) to verify placement
@@ -53,11 +68,23 @@
 #include "region.h" // for "Public" declarations
 #include "chem_rxn.h" // For deleting chemical reaction region members
 #include "subvolume.h"
+#include "flow_field.h" // For region flow fields
+#include "mtwist.h" // For random placement of points
+#include "profile.h" // For counting placement attempts
 
 //
 // "Private" Declarations
 //
 
+// Build alias table to choose the sub-boxes of a placement sampler
+static void buildPlacementAliasTable(struct placementSampler * sampler);
+
+// Test a batch of points for being in a region but not in its children
+static void filterPointsInRegionNotChild(const short curRegion,
+		const struct region regionArray[], const uint32_t firstPoint,
+		const uint32_t numPoint, double point[][3], bool bTest[],
+		bool bValid[]);
+
 //
 // Definitions
 //
@@ -194,7 +221,30 @@ void initializeRegionArray(struct region regionArray[],
 			break;
 		}
 
+		regionArray[i].bPointInShape = findPointInBoundaryFunc(
+				regionArray[i].spec.shape, regionArray[i].boundary);
+		if (regionArray[i].bPointInShape == NULL) {
+			fprintf(stderr,
+					"ERROR: Region %u (Label: \"%s\") has a shape that cannot contain points.\n",
+					i, subvol_spec[i].label);
+			bFail = true;
+		}
 		regionArray[i].numChildren = 0;
+		regionArray[i].voxelMap = NULL;
+
+		// Load flow field
+		regionArray[i].flowField = NULL;
+		if (subvol_spec[i].flowFieldFile != NULL && subvol_spec[i].bMicro) {
+			regionArray[i].flowField = malloc(sizeof(struct flowField));
+			if (regionArray[i].flowField == NULL) {
+				fprintf(stderr,
+						"ERROR: Memory allocation for region %u (label: \"%s\") flow field.\n",
+						i, subvol_spec[i].label);
+				exit(EXIT_FAILURE);
+			}
+			loadFlowField(subvol_spec[i].flowFieldFile,
+					regionArray[i].flowField);
+		}
 		regionArray[i].subResolution = SUBVOL_BASE_SIZE * SUB_ADJ_RESOLUTION;
 
 		// Calculate diffusion rates within region
@@ -225,6 +275,9 @@ void initializeRegionArray(struct region regionArray[],
 	// Includes some (but not exhaustive) checks on spec.type
 	findRegionTouch(NUM_REGIONS, subvol_spec, regionArray, SUBVOL_BASE_SIZE);
 
+	// Determine which region faces can only reflect molecules
+	findRegionReflectFaces(NUM_REGIONS, regionArray);
+
 	// Confirm validity of all regions now that neighbors have been identified
 	validateRegions(NUM_REGIONS, regionArray, &bFail);
 
@@ -238,6 +291,41 @@ void initializeRegionArray(struct region regionArray[],
 	// Define chemical reaction network
 	initializeRegionChemRxn(NUM_REGIONS, regionArray, NUM_MOL_TYPES, MAX_RXNS,
 			chem_rxn, DIFF_COEF);
+
+	// Classify the environment into voxels to accelerate point classification
+	initializeRegionVoxelMap(NUM_REGIONS, regionArray);
+
+	// Prepare samplers to place new molecules
+	for (i = 0; i < NUM_REGIONS; i++)
+		initializePlacementSampler(&regionArray[i].placement, i, regionArray,
+				regionArray[i].spec.shape, regionArray[i].boundary,
+				regionArray[i].effectiveDim != regionArray[i].dimension);
+}
+
+// Recalculate the region members that depend on the diffusion coefficients
+// and the chemical reaction rates (e.g., for the next simulation of a sweep)
+void resetRegionRates(struct region regionArray[], const short NUM_REGIONS,
+		const unsigned short NUM_MOL_TYPES,
+		double DIFF_COEF[NUM_REGIONS][NUM_MOL_TYPES],
+		const unsigned short MAX_RXNS, const struct chem_rxn_struct * chem_rxn) {
+	short i;
+	unsigned short curMolType;
+	double h_i;
+
+	// Calculate diffusion rates within mesoscopic regions
+	for (i = 0; i < NUM_REGIONS; i++) {
+		if (regionArray[i].spec.bMicro)
+			continue;
+		h_i = regionArray[i].actualSubSize;
+		for (curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
+			regionArray[i].diffRate[curMolType] = DIFF_COEF[i][curMolType]
+					/ h_i / h_i;
+	}
+
+	// Define chemical reaction network again with the new rates
+	deleteRegionChemRxn(NUM_REGIONS, NUM_MOL_TYPES, regionArray);
+	initializeRegionChemRxn(NUM_REGIONS, regionArray, NUM_MOL_TYPES, MAX_RXNS,
+			chem_rxn, DIFF_COEF);
 }
 
 // Initialize region knowledge of the subvolumes that are adjacent to it
@@ -486,6 +574,12 @@ void delete_boundary_region_(const short NUM_REGIONS,
 
 	deleteRegionChemRxn(NUM_REGIONS, NUM_MOL_TYPES, regionArray);
 
+	if (regionArray[0].voxelMap != NULL) {
+		if (regionArray[0].voxelMap->owner != NULL)
+			free(regionArray[0].voxelMap->owner);
+		free(regionArray[0].voxelMap);
+	}
+
 	for (i = 0; i < NUM_REGIONS; i++) {
 		if (regionArray[i].numChildren > 0) {
 			if (regionArray[i].childrenID != NULL)
@@ -497,6 +591,13 @@ void delete_boundary_region_(const short NUM_REGIONS,
 		if (regionArray[i].regionNeighDir != NULL)
 			free(regionArray[i].regionNeighDir);
 
+		if (regionArray[i].flowField != NULL) {
+			deleteFlowField(regionArray[i].flowField);
+			free(regionArray[i].flowField);
+		}
+
+		deletePlacementSampler(&regionArray[i].placement);
+
 		if (regionArray[i].spec.bMicro) {
 			if (regionArray[i].regionNeighID != NULL)
 				free(regionArray[i].regionNeighID);
@@ -1174,13 +1275,20 @@ bool bLineHitRegion(const double p1[3], const double L[3], const double length,
 bool bPointInRegionNotChild(const short curRegion,
 		const struct region regionArray[], const double point[3]) {
 	short curChild;
+	short owner;
+
+	if (regionArray[curRegion].numChildren > 0) { // Try the voxel map before testing every child
+		owner = findVoxelOwner(regionArray[curRegion].voxelMap, point);
+		if (owner != VOXEL_MIXED)
+			return owner == curRegion;
+	}
 
-	if (bPointInBoundary(point, regionArray[curRegion].spec.shape,
+	if (regionArray[curRegion].bPointInShape(point,
 			regionArray[curRegion].boundary)) { // Point is within the region's outer boundary
 		for (curChild = 0; curChild < regionArray[curRegion].numChildren;
 				curChild++) {
-			if (bPointInBoundary(point,
-					regionArray[regionArray[curRegion].childrenID[curChild]].spec.shape,
+			if (regionArray[regionArray[curRegion].childrenID[curChild]].bPointInShape(
+					point,
 					regionArray[regionArray[curRegion].childrenID[curChild]].boundary))
 				return false;
 		}
@@ -1196,8 +1304,25 @@ bool bPointInRegionOrChild(const short curRegion,
 		const struct region regionArray[], const double point[3],
 		short * actualRegion, bool bSurfaceOnly) {
 	short curChild;
+	short owner;
+
+	if (!bSurfaceOnly && regionArray[curRegion].numChildren > 0) {
+		// The voxel owner is the region the recursion below would find, so
+		// we only need to check whether it is nested in curRegion
+		owner = findVoxelOwner(regionArray[curRegion].voxelMap, point);
+		if (owner != VOXEL_MIXED) {
+			for (curChild = owner; curChild != SHRT_MAX;
+					curChild = regionArray[curChild].parentID) {
+				if (curChild == curRegion) {
+					*actualRegion = owner;
+					return true;
+				}
+			}
+			return false;
+		}
+	}
 
-	if (bPointInBoundary(point, regionArray[curRegion].spec.shape,
+	if (regionArray[curRegion].bPointInShape(point,
 			regionArray[curRegion].boundary)) { // Point is within the region's outer boundary
 		for (curChild = 0; curChild < regionArray[curRegion].numChildren;
 				curChild++) {
@@ -1389,17 +1514,8 @@ void lockPointToRegion(double point[3], const short startRegion,
 // Generate a random cartesian point in the specified region
 void generatePointInRegion(const short curRegion,
 		const struct region regionArray[], double point[3]) {
-	bool bNeedPoint = true;
-
-	while (bNeedPoint) {
-		uniformPointVolume(point, regionArray[curRegion].spec.shape,
-				regionArray[curRegion].boundary,
-				regionArray[curRegion].dimension
-						== regionArray[curRegion].effectiveDim,
-				regionArray[curRegion].plane);
-		if (bPointInRegionNotChild(curRegion, regionArray, point))
-			bNeedPoint = false;
-	}
+	generatePlacementPoint(&regionArray[curRegion].placement, curRegion,
+			regionArray, point);
 }
 
 // Which region contains given point, excluding children?
@@ -1407,6 +1523,10 @@ short findRegionNotChild(const short NUM_REGIONS,
 		const struct region regionArray[], double point[3]) {
 	short curRegion;
 
+	curRegion = findVoxelOwner(regionArray[0].voxelMap, point);
+	if (curRegion != VOXEL_MIXED)
+		return curRegion;
+
 	for (curRegion = 0; curRegion < NUM_REGIONS; curRegion++) {
 		if (bPointInRegionNotChild(curRegion, regionArray, point))
 			return curRegion;
@@ -1416,6 +1536,563 @@ short findRegionNotChild(const short NUM_REGIONS,
 	return SHRT_MAX;
 }
 
+// Build the voxel map of region membership that accelerates point classification
+// The map covers the bounding box of all regions. A voxel is assigned an owner
+// only if no region boundary passes through it, so lookups give the same answer
+// as testing the regions directly
+void initializeRegionVoxelMap(const short NUM_REGIONS,
+		struct region regionArray[]) {
+	struct voxelMap * map;
+	short i, curRegion, curChild, owner;
+	unsigned short d;
+	uint32_t v[3], curVoxel, numVoxelTotal;
+	double envBound[6], regionBound[6], voxelBound[6];
+	double maxWidth, pad;
+	double voxelWidth[3], margin[3];
+	int relation[NUM_REGIONS];
+	bool bOwner;
+
+	map = malloc(sizeof(struct voxelMap));
+	if (map == NULL) {
+		fprintf(stderr,
+				"ERROR: Memory allocation for the region voxel map.\n");
+		exit(EXIT_FAILURE);
+	}
+	map->bValid = false;
+	map->owner = NULL;
+	for (i = 0; i < NUM_REGIONS; i++)
+		regionArray[i].voxelMap = map;
+
+	if (NUM_REGIONS < 2)
+		return; // A single region is already cheap to test directly
+
+	// Find bounding box of the entire environment
+	findBoundaryBoundingBox(regionArray[0].spec.shape, regionArray[0].boundary,
+			envBound);
+	for (i = 1; i < NUM_REGIONS; i++) {
+		findBoundaryBoundingBox(regionArray[i].spec.shape,
+				regionArray[i].boundary, regionBound);
+		for (d = 0; d < 3; d++) {
+			if (regionBound[2 * d] < envBound[2 * d])
+				envBound[2 * d] = regionBound[2 * d];
+			if (regionBound[2 * d + 1] > envBound[2 * d + 1])
+				envBound[2 * d + 1] = regionBound[2 * d + 1];
+		}
+	}
+	maxWidth = 0.;
+	for (d = 0; d < 3; d++) {
+		if (envBound[2 * d + 1] - envBound[2 * d] > maxWidth)
+			maxWidth = envBound[2 * d + 1] - envBound[2 * d];
+	}
+	if (maxWidth <= 0.)
+		return;
+
+	// Pad the environment so that points on its outer boundary are inside the
+	// map and flat environments still have non-zero voxel width
+	pad = 1e-6 * maxWidth;
+	numVoxelTotal = 1;
+	for (d = 0; d < 3; d++) {
+		envBound[2 * d] -= pad;
+		envBound[2 * d + 1] += pad;
+		map->numVoxel[d] = (uint32_t) ceil(
+				VOXEL_MAX_PER_DIM * (envBound[2 * d + 1] - envBound[2 * d])
+						/ maxWidth);
+		if (map->numVoxel[d] < 1)
+			map->numVoxel[d] = 1;
+		else if (map->numVoxel[d] > VOXEL_MAX_PER_DIM)
+			map->numVoxel[d] = VOXEL_MAX_PER_DIM;
+		voxelWidth[d] = (envBound[2 * d + 1] - envBound[2 * d])
+				/ map->numVoxel[d];
+		margin[d] = 1e-6 * voxelWidth[d];
+		map->origin[d] = envBound[2 * d];
+		map->invWidth[d] = 1. / voxelWidth[d];
+		numVoxelTotal *= map->numVoxel[d];
+	}
+
+	map->owner = malloc(numVoxelTotal * sizeof(short));
+	if (map->owner == NULL) {
+		fprintf(stderr,
+				"ERROR: Memory allocation for the region voxel map.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// Classify each voxel. Voxels are slightly enlarged so that rounding in
+	// findVoxelOwner cannot place a point in a voxel that does not contain it
+	curVoxel = 0;
+	for (v[0] = 0; v[0] < map->numVoxel[0]; v[0]++) {
+		for (v[1] = 0; v[1] < map->numVoxel[1]; v[1]++) {
+			for (v[2] = 0; v[2] < map->numVoxel[2]; v[2]++) {
+				for (d = 0; d < 3; d++) {
+					voxelBound[2 * d] = map->origin[d] + v[d] * voxelWidth[d]
+							- margin[d];
+					voxelBound[2 * d + 1] = map->origin[d]
+							+ (v[d] + 1) * voxelWidth[d] + margin[d];
+				}
+
+				owner = SHRT_MAX;
+				for (curRegion = 0; curRegion < NUM_REGIONS; curRegion++) {
+					relation[curRegion] = boxBoundaryRelation(voxelBound,
+							regionArray[curRegion].spec.shape,
+							regionArray[curRegion].boundary);
+					if (relation[curRegion] == BOX_PARTIAL) {
+						owner = VOXEL_MIXED;
+						break;
+					}
+				}
+
+				// Voxel is owned by a region that contains it and whose
+				// children do not
+				for (curRegion = 0;
+						owner != VOXEL_MIXED && curRegion < NUM_REGIONS;
+						curRegion++) {
+					if (relation[curRegion] != BOX_INSIDE)
+						continue;
+					bOwner = true;
+					for (curChild = 0;
+							curChild < regionArray[curRegion].numChildren;
+							curChild++) {
+						if (relation[regionArray[curRegion].childrenID[curChild]]
+								== BOX_INSIDE)
+							bOwner = false;
+					}
+					if (bOwner) {
+						if (owner == SHRT_MAX)
+							owner = curRegion;
+						else
+							owner = VOXEL_MIXED; // Failsafe for overlapping regions
+					}
+				}
+				map->owner[curVoxel++] = owner;
+			}
+		}
+	}
+
+	map->bValid = true;
+}
+
+// Which region owns the voxel that contains given point?
+// Returns SHRT_MAX if the point is in no region, or VOXEL_MIXED if the point
+// must be classified directly
+short findVoxelOwner(const struct voxelMap * map, const double point[3]) {
+	unsigned short d;
+	uint32_t v[3];
+	double coor;
+
+	if (map == NULL || !map->bValid)
+		return VOXEL_MIXED;
+
+	for (d = 0; d < 3; d++) {
+		coor = (point[d] - map->origin[d]) * map->invWidth[d];
+		if (!(coor >= 0. && coor < map->numVoxel[d]))
+			return SHRT_MAX; // Point is outside of every region
+		v[d] = (uint32_t) coor;
+	}
+
+	return map->owner[(v[0] * map->numVoxel[1] + v[1]) * map->numVoxel[2]
+			+ v[2]];
+}
+
+// Find the bounding box of a boundary
+void findBoundaryBoundingBox(const int shape, const double boundary[],
+		double bound[6]) {
+	unsigned short d;
+	unsigned short along;
+
+	switch (shape) {
+	case SPHERE:
+		for (d = 0; d < 3; d++) {
+			bound[2 * d] = boundary[d] - boundary[3];
+			bound[2 * d + 1] = boundary[d] + boundary[3];
+		}
+		break;
+	case CYLINDER:
+		if (boundary[4] == PLANE_XY)
+			along = 2;
+		else if (boundary[4] == PLANE_XZ)
+			along = 1;
+		else
+			along = 0;
+		for (d = 0; d < 3; d++) {
+			if (d == along) {
+				bound[2 * d] = boundary[d];
+				bound[2 * d + 1] = boundary[d] + boundary[5];
+			} else {
+				bound[2 * d] = boundary[d] - boundary[3];
+				bound[2 * d + 1] = boundary[d] + boundary[3];
+			}
+		}
+		break;
+	default:
+		for (d = 0; d < 6; d++)
+			bound[d] = boundary[d];
+	}
+}
+
+// Build sampler for placing points in the part of a boundary that is in a
+// region but not in its children. Points are placed on the surface of the
+// boundary if bSurface is true
+// The grid is only needed if the region has children, since points in a
+// region without children are generated directly in the boundary
+void initializePlacementSampler(struct placementSampler * sampler,
+		const short curRegion, const struct region regionArray[],
+		const int shape, const double boundary[], const bool bSurface) {
+	unsigned short d;
+	short curChild, childID;
+	uint32_t c[3], numCell[3], numCellTotal, runStart;
+	double bound[6], cellBound[6], cellWidth[3];
+	double maxWidth;
+	int relation;
+	bool bValid, bExact, bRun;
+
+	sampler->shape = shape;
+	for (d = 0; d < 6; d++)
+		sampler->boundary[d] = boundary[d];
+	sampler->bSurface = bSurface;
+	sampler->plane = regionArray[curRegion].plane;
+	sampler->numBox = 0;
+	sampler->subBound = NULL;
+	sampler->bExact = NULL;
+	sampler->aliasProb = NULL;
+	sampler->aliasID = NULL;
+
+	if (!regionArray[curRegion].spec.bMicro
+			|| regionArray[curRegion].numChildren < 1 || sampler->bSurface
+			|| regionArray[curRegion].effectiveDim != DIM_3D
+			|| (shape != RECTANGULAR_BOX && shape != SPHERE
+					&& shape != CYLINDER))
+		return;
+
+	findBoundaryBoundingBox(shape, boundary, bound);
+	maxWidth = 0.;
+	for (d = 0; d < 3; d++) {
+		if (bound[2 * d + 1] - bound[2 * d] > maxWidth)
+			maxWidth = bound[2 * d + 1] - bound[2 * d];
+	}
+	if (maxWidth <= 0.)
+		return;
+
+	numCellTotal = 1;
+	for (d = 0; d < 3; d++) {
+		numCell[d] = (uint32_t) ceil(
+				PLACEMENT_MAX_PER_DIM * (bound[2 * d + 1] - bound[2 * d])
+						/ maxWidth);
+		if (numCell[d] < 1)
+			numCell[d] = 1;
+		else if (numCell[d] > PLACEMENT_MAX_PER_DIM)
+			numCell[d] = PLACEMENT_MAX_PER_DIM;
+		cellWidth[d] = (bound[2 * d + 1] - bound[2 * d]) / numCell[d];
+		numCellTotal *= numCell[d];
+	}
+
+	// There cannot be more sub-boxes than cells
+	sampler->subBound = malloc(numCellTotal * sizeof(double[6]));
+	sampler->bExact = malloc(numCellTotal * sizeof(bool));
+	if (sampler->subBound == NULL || sampler->bExact == NULL) {
+		fprintf(stderr,
+				"ERROR: Memory allocation for placement sampler in region %u (label: \"%s\").\n",
+				curRegion, regionArray[curRegion].spec.label);
+		exit(EXIT_FAILURE);
+	}
+
+	// Classify cells. Cells along x that are fully valid are merged into one
+	// sub-box; every other cell that could contain a valid point is its own
+	// sub-box
+	for (c[2] = 0; c[2] < numCell[2]; c[2]++) {
+		for (c[1] = 0; c[1] < numCell[1]; c[1]++) {
+			bRun = false;
+			runStart = 0;
+			for (c[0] = 0; c[0] <= numCell[0]; c[0]++) {
+				bValid = false;
+				bExact = false;
+				if (c[0] < numCell[0]) {
+					for (d = 0; d < 3; d++) {
+						cellBound[2 * d] = bound[2 * d] + c[d] * cellWidth[d];
+						cellBound[2 * d + 1] = (c[d] + 1 == numCell[d]) ?
+								bound[2 * d + 1] :
+								bound[2 * d] + (c[d] + 1) * cellWidth[d];
+					}
+
+					relation = boxBoundaryRelation(cellBound, shape, boundary);
+					if (relation != BOX_OUTSIDE) {
+						bValid = true;
+						bExact = relation == BOX_INSIDE;
+						relation = boxBoundaryRelation(cellBound,
+								regionArray[curRegion].spec.shape,
+								regionArray[curRegion].boundary);
+						if (relation == BOX_OUTSIDE)
+							bValid = false;
+						else if (relation == BOX_PARTIAL)
+							bExact = false;
+					}
+					for (curChild = 0;
+							bValid
+									&& curChild
+											< regionArray[curRegion].numChildren;
+							curChild++) {
+						childID = regionArray[curRegion].childrenID[curChild];
+						relation = boxBoundaryRelation(cellBound,
+								regionArray[childID].spec.shape,
+								regionArray[childID].boundary);
+						if (relation == BOX_INSIDE)
+							bValid = false;
+						else if (relation == BOX_PARTIAL)
+							bExact = false;
+					}
+				}
+
+				if (bRun && !bExact) { // Close run of exact cells
+					sampler->subBound[sampler->numBox][0] = bound[0]
+							+ runStart * cellWidth[0];
+					sampler->subBound[sampler->numBox][1] = cellBound[0];
+					if (c[0] == numCell[0])
+						sampler->subBound[sampler->numBox][1] = bound[1];
+					for (d = 2; d < 6; d++)
+						sampler->subBound[sampler->numBox][d] = cellBound[d];
+					sampler->bExact[sampler->numBox++] = true;
+					bRun = false;
+				}
+				if (bExact && !bRun) { // Start a new run
+					bRun = true;
+					runStart = c[0];
+				} else if (bValid && !bExact) {
+					for (d = 0; d < 6; d++)
+						sampler->subBound[sampler->numBox][d] = cellBound[d];
+					sampler->bExact[sampler->numBox++] = false;
+				}
+			}
+		}
+	}
+
+	if (sampler->numBox == 0) {
+		deletePlacementSampler(sampler);
+		return;
+	}
+
+	buildPlacementAliasTable(sampler);
+}
+
+// Generate a random point with a placement sampler
+void generatePlacementPoint(const struct placementSampler * sampler,
+		const short curRegion, const struct region regionArray[],
+		double point[3]) {
+	generatePlacementPoints(sampler, curRegion, regionArray, 1,
+			(double (*)[3]) point);
+}
+
+// Generate a batch of up to PLACEMENT_BATCH_SIZE random points with a
+// placement sampler
+// Candidates for all missing points are generated first and then tested
+// together, one boundary at a time. Valid points are kept at the front of the
+// array and the rest are generated again
+void generatePlacementPoints(const struct placementSampler * sampler,
+		const short curRegion, const struct region regionArray[],
+		const uint32_t numPoint, double point[][3]) {
+	double uniRV;
+	uint32_t curBox, curPoint;
+	uint32_t numValid = 0;
+	bool bTest[PLACEMENT_BATCH_SIZE];
+	bool bValid[PLACEMENT_BATCH_SIZE];
+	PointInBoundaryFunc bPointInSampler = NULL;
+
+	if (numPoint > PLACEMENT_BATCH_SIZE) {
+		fprintf(stderr,
+				"ERROR: Cannot generate %u points in one batch. The maximum is %u.\n",
+				numPoint, PLACEMENT_BATCH_SIZE);
+		exit(EXIT_FAILURE);
+	}
+
+	if (sampler->numBox > 0)
+		bPointInSampler = findPointInBoundaryFunc(sampler->shape,
+				sampler->boundary);
+
+	PROFILE_COUNT(PROFILE_PLACEMENT_POINT, numPoint);
+	while (numValid < numPoint) {
+		// Generate candidates
+		for (curPoint = numValid; curPoint < numPoint; curPoint++) {
+			if (sampler->numBox == 0) {
+				uniformPointVolume(point[curPoint], sampler->shape,
+						sampler->boundary, sampler->bSurface, sampler->plane);
+				bTest[curPoint] = true;
+				continue;
+			}
+
+			uniRV = mt_drand() * sampler->numBox;
+			curBox = (uint32_t) uniRV;
+			if (curBox >= sampler->numBox)
+				curBox = sampler->numBox - 1;
+			if (uniRV - curBox >= sampler->aliasProb[curBox])
+				curBox = sampler->aliasID[curBox];
+
+			uniformPointVolume(point[curPoint], RECTANGULAR_BOX,
+					sampler->subBound[curBox], false, 0);
+			bTest[curPoint] = !sampler->bExact[curBox];
+		}
+
+		// Test candidates that are not in a fully valid sub-box
+		for (curPoint = numValid; curPoint < numPoint; curPoint++)
+			bValid[curPoint] = true;
+		if (sampler->numBox > 0) { // Sub-boxes can extend past the boundary
+			for (curPoint = numValid; curPoint < numPoint; curPoint++) {
+				if (bTest[curPoint]
+						&& !((bPointInSampler != NULL) ?
+								bPointInSampler(point[curPoint],
+										sampler->boundary) :
+								bPointInBoundary(point[curPoint],
+										sampler->shape, sampler->boundary))) {
+					bTest[curPoint] = false;
+					bValid[curPoint] = false;
+				}
+			}
+		}
+		filterPointsInRegionNotChild(curRegion, regionArray, numValid,
+				numPoint, point, bTest, bValid);
+
+		// Move valid candidates to the front
+		for (curPoint = numValid; curPoint < numPoint; curPoint++) {
+			if (!bValid[curPoint])
+				continue;
+			if (curPoint != numValid) {
+				point[numValid][0] = point[curPoint][0];
+				point[numValid][1] = point[curPoint][1];
+				point[numValid][2] = point[curPoint][2];
+			}
+			numValid++;
+		}
+		PROFILE_COUNT(PROFILE_PLACEMENT_RETRY, numPoint - numValid);
+	}
+}
+
+// Free memory allocated to a placement sampler
+void deletePlacementSampler(struct placementSampler * sampler) {
+	if (sampler->subBound != NULL)
+		free(sampler->subBound);
+	if (sampler->bExact != NULL)
+		free(sampler->bExact);
+	if (sampler->aliasProb != NULL)
+		free(sampler->aliasProb);
+	if (sampler->aliasID != NULL)
+		free(sampler->aliasID);
+	sampler->subBound = NULL;
+	sampler->bExact = NULL;
+	sampler->aliasProb = NULL;
+	sampler->aliasID = NULL;
+	sampler->numBox = 0;
+}
+
+// Test a batch of points for being in a region but not in its children
+// Only the points from firstPoint to numPoint-1 with bTest true are tested.
+// bValid becomes false for the tested points that are not in the region. The
+// voxel map decides most points, and then each shape is tested over the whole
+// batch before the next, so each containment kernel runs in one tight loop.
+// The result is the same as calling bPointInRegionNotChild for each point
+static void filterPointsInRegionNotChild(const short curRegion,
+		const struct region regionArray[], const uint32_t firstPoint,
+		const uint32_t numPoint, double point[][3], bool bTest[],
+		bool bValid[]) {
+	uint32_t curPoint;
+	short curChild, childID;
+	short owner;
+	PointInBoundaryFunc bPointInShape;
+
+	if (regionArray[curRegion].numChildren > 0) {
+		for (curPoint = firstPoint; curPoint < numPoint; curPoint++) {
+			if (!bTest[curPoint])
+				continue;
+			owner = findVoxelOwner(regionArray[curRegion].voxelMap,
+					point[curPoint]);
+			if (owner != VOXEL_MIXED) {
+				bValid[curPoint] = owner == curRegion;
+				bTest[curPoint] = false;
+			}
+		}
+	}
+
+	// Point must be within the region's outer boundary
+	bPointInShape = regionArray[curRegion].bPointInShape;
+	for (curPoint = firstPoint; curPoint < numPoint; curPoint++) {
+		if (bTest[curPoint]
+				&& !bPointInShape(point[curPoint],
+						regionArray[curRegion].boundary)) {
+			bValid[curPoint] = false;
+			bTest[curPoint] = false;
+		}
+	}
+
+	// Point must not be within any child
+	for (curChild = 0; curChild < regionArray[curRegion].numChildren;
+			curChild++) {
+		childID = regionArray[curRegion].childrenID[curChild];
+		bPointInShape = regionArray[childID].bPointInShape;
+		for (curPoint = firstPoint; curPoint < numPoint; curPoint++) {
+			if (bTest[curPoint]
+					&& bPointInShape(point[curPoint],
+							regionArray[childID].boundary)) {
+				bValid[curPoint] = false;
+				bTest[curPoint] = false;
+			}
+		}
+	}
+}
+
+// Build alias table to choose the sub-boxes of a placement sampler
+// Sub-boxes are weighted by their volume (Vose's method)
+static void buildPlacementAliasTable(struct placementSampler * sampler) {
+	uint32_t i, numSmall, numLarge, curSmall, curLarge;
+	uint32_t * small, *large;
+	double totalVolume = 0.;
+
+	sampler->aliasProb = malloc(sampler->numBox * sizeof(double));
+	sampler->aliasID = malloc(sampler->numBox * sizeof(uint32_t));
+	small = malloc(sampler->numBox * sizeof(uint32_t));
+	large = malloc(sampler->numBox * sizeof(uint32_t));
+	if (sampler->aliasProb == NULL || sampler->aliasID == NULL || small == NULL
+			|| large == NULL) {
+		fprintf(stderr,
+				"ERROR: Memory allocation for placement sampler alias table.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// Scale volumes so that their mean is 1
+	for (i = 0; i < sampler->numBox; i++) {
+		sampler->aliasProb[i] = (sampler->subBound[i][1]
+				- sampler->subBound[i][0])
+				* (sampler->subBound[i][3] - sampler->subBound[i][2])
+				* (sampler->subBound[i][5] - sampler->subBound[i][4]);
+		totalVolume += sampler->aliasProb[i];
+	}
+	numSmall = 0;
+	numLarge = 0;
+	for (i = 0; i < sampler->numBox; i++) {
+		sampler->aliasProb[i] *= sampler->numBox / totalVolume;
+		sampler->aliasID[i] = i;
+		if (sampler->aliasProb[i] < 1.)
+			small[numSmall++] = i;
+		else
+			large[numLarge++] = i;
+	}
+
+	// Fill each small entry with the remainder of a large one
+	while (numSmall > 0 && numLarge > 0) {
+		curSmall = small[--numSmall];
+		curLarge = large[numLarge - 1];
+		sampler->aliasID[curSmall] = curLarge;
+		sampler->aliasProb[curLarge] -= 1. - sampler->aliasProb[curSmall];
+		if (sampler->aliasProb[curLarge] < 1.) {
+			numLarge--;
+			small[numSmall++] = curLarge;
+		}
+	}
+
+	// Remaining entries are only off from 1 by rounding error
+	while (numLarge > 0)
+		sampler->aliasProb[large[--numLarge]] = 1.;
+	while (numSmall > 0)
+		sampler->aliasProb[small[--numSmall]] = 1.;
+
+	free(small);
+	free(large);
+}
+
 // Does a subvolume face a region? If yes, then along which faces?
 // Assert that current subvolume is along its own region boundary, and that
 // neighbor region is microscopic
@@ -1898,6 +2575,39 @@ void findNumRegionSubvolumes(const short NUM_REGIONS,
 	}
 }
 
+// Determine which outer faces of each region only reflect molecules
+// A molecule leaving a box through such a face can be reflected in closed form
+// without searching for the neighbor regions that it might have entered
+void findRegionReflectFaces(const short NUM_REGIONS,
+		struct region regionArray[]) {
+	short i, j;
+	unsigned short curFace;
+	bool bReflect;
+
+	for (i = 0; i < NUM_REGIONS; i++) {
+		bReflect = regionArray[i].spec.shape == RECTANGULAR_BOX
+				&& regionArray[i].spec.type == REGION_NORMAL
+				&& regionArray[i].spec.bMicro
+				&& regionArray[i].numChildren == 0;
+		for (curFace = 0; curFace < 6; curFace++)
+			regionArray[i].bReflectFace[curFace] = bReflect;
+		if (!bReflect)
+			continue;
+
+		for (j = 0; j < NUM_REGIONS; j++) {
+			if (!regionArray[i].isRegionNeigh[j])
+				continue;
+			if (regionArray[i].regionNeighDir[j] < 6) {
+				regionArray[i].bReflectFace[regionArray[i].regionNeighDir[j]] =
+						false;
+			} else { // Parent or child region can be entered through any face
+				for (curFace = 0; curFace < 6; curFace++)
+					regionArray[i].bReflectFace[curFace] = false;
+			}
+		}
+	}
+}
+
 // Allocate memory for each region's neighbors
 void allocateRegionNeighbors(const short NUM_REGIONS,
 		struct region regionArray[]) {
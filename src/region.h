@@ -10,10 +10,25 @@
  * region.h - 	operations for (microscopic or mesoscopic) regions in
  * 				simulation environment
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added voxel map of region membership so that most points are classified without
+ * testing every region
+ * - added closed-form reflection of molecules off the faces of box regions without
+ * children
+ * - bound a shape-specific point containment function to each region
+ * - added advection of microscopic molecules by a region flow field that is read from a
+ * memory-mapped velocity grid
+ * - added placement samplers so that molecules are placed directly instead of by
+ * rejection
+ * - placed microscopic actor emissions in batches
+ * - batched passive actor observations that occur at the same time
+ * - added surface reaction type of each chemical reaction to region structure
+ * - added reset of the parameters that can change between the simulations of a sweep
+ *
  * Revision v0.5 (2016-04-15)
  * - re-structured region array initialization to nest more code in functions
  * - added more checks on region parameters (including label uniqueness) to verify placement
@@ -50,6 +65,22 @@
 #include "base.h" // For region adjacency
 #include "global_param.h" // For region adjacency
 
+/*
+* Constant definitions
+*/
+
+// Maximum number of voxels along any one dimension of the region voxel map
+#define VOXEL_MAX_PER_DIM 32
+
+// Voxel map entry for a voxel that is cut by at least one region boundary
+#define VOXEL_MIXED -1
+
+// Maximum number of cells along any one dimension of a placement sampler
+#define PLACEMENT_MAX_PER_DIM 16
+
+// Maximum number of points that a placement sampler generates in one batch
+#define PLACEMENT_BATCH_SIZE 256
+
 /*
 * Data Type Declarations
 */
@@ -58,6 +89,7 @@ struct subvolume3D; // Forward declaration (declared in subvolume.h)
 					// includes region.h), but means we can only refer to subvolume3D
 					// as a pointer in this file
 struct chem_rxn_struct; // (declared in chem_rxn.h)
+struct flowField; // (declared in flow_field.h)
 
 /* The spec_region3D structure includes the parameters for a region that are
 * defined by the user input configuration
@@ -141,12 +173,67 @@ struct spec_region3D { // Used to define a region of subvolumes
 	// the amplitude of the flow function can be specified here
 	double flowFunctionAmplitude;
 
+	// Name of binary file with a velocity field to use instead of the flow
+	// parameters above. NULL if the region has no flow field
+	char * flowFieldFile;
+
 	// FUTURE MEMBERS (POTENTIAL)
 	// Indicator for presence of system boundary
 	// Details of region-specific reactions
 	// Exclusion zones to more easily surround smaller regions
 };
 
+/* The voxelMap structure partitions the bounding box of the entire environment
+* into a uniform grid of voxels. Each voxel records the one region that contains
+* every point in the voxel (excluding that region's children), SHRT_MAX if no
+* region overlaps the voxel, or VOXEL_MIXED if the voxel is cut by a region
+* boundary and a point in it must be classified by testing the regions directly.
+* One map is built for the environment and shared by all regions.
+*/
+struct voxelMap {
+	// Was the map built? If false then all point classification is direct
+	bool bValid;
+	
+	// Lower corner of the map and reciprocal of the voxel width along each dimension
+	double origin[3];
+	double invWidth[3];
+	
+	// Number of voxels along each dimension
+	uint32_t numVoxel[3];
+	
+	// Owner of each voxel. Index is (i*numVoxel[1] + j)*numVoxel[2] + k
+	short * owner;
+};
+
+/* The placementSampler structure generates uniformly-distributed points in the
+* part of a boundary that is inside one region but not inside the region's
+* children. The bounding box of the boundary is split into a grid of cells.
+* Cells that are outside of the region or inside a child are dropped, and runs
+* of cells that are fully valid are merged into sub-boxes. A sub-box is chosen
+* with an alias table weighted by volume, so a point only needs to be tested if
+* its sub-box is cut by a boundary. If numBox is 0, then points are generated
+* in the boundary and tested until one is valid.
+*/
+struct placementSampler {
+	// Boundary (of a region or an actor-region intersection) to place points in
+	int shape;
+	double boundary[6];
+	bool bSurface;
+	short plane;
+	
+	// Number of sub-boxes. 0 if grid is not used
+	uint32_t numBox;
+	
+	// Boundary of each sub-box and whether its points need no testing
+	double (* subBound)[6];
+	bool * bExact;
+	
+	// Alias table. Sub-box i is chosen with probability aliasProb[i] if i is
+	// drawn, and sub-box aliasID[i] is chosen otherwise
+	double * aliasProb;
+	uint32_t * aliasID;
+};
+
 /* The region structure contains all parameters specific to a single
 * region, including the user-defined parameters defined in spec_region3D. The
 * structure members that describe the region's location relative to other regions
@@ -212,11 +299,30 @@ struct region { // Region boundary parameters
 	// Coordinates of "Outer" Region boundary
 	double boundary[6];
 	
+	// Shape-specific test of whether a point is inside the outer boundary
+	PointInBoundaryFunc bPointInShape;
+	
+	// Flow velocity field loaded from spec.flowFieldFile
+	// NULL if region has no flow field
+	struct flowField * flowField;
+	
+	// Voxel map of region membership for the entire environment
+	// The same map is pointed to by every region
+	struct voxelMap * voxelMap;
+	
+	// Sampler for placing new molecules in the region (by zeroth order reactions)
+	struct placementSampler placement;
+	
 	// Is there at least one boundary region along each outer boundary face?
 	// TODO: Following Members may only be needed for boundary reactions
 	bool boundaryRegion[6];
 	bool boundaryRegionMicro[6]; // Are outer boundary regions microscopic?
 	
+	// Can a molecule that leaves the region through each outer face simply be
+	// reflected back in? Only true for faces of a microscopic box with no
+	// children when no neighbor region can be entered through the face
+	bool bReflectFace[6];
+	
 	// Is each other region a neighbor of this region? The element in this array
 	// for the same region is assigned false
 	// Length is simulation-defined NUM_REGIONS
@@ -365,6 +471,11 @@ struct region { // Region boundary parameters
 	// Size is numChemRxn
 	double * rxnRate;
 	
+	// Surface reaction type of each chemical reaction (values defined in
+	// global_param.h). Needed to identify reactions that capture molecules
+	// Size is numChemRxn
+	short * rxnSurfType;
+	
 	// Indices of reactions that are 0th order.
 	// Size is numChemRxn; elements numZerothRxn and greater are undefined
 	unsigned short * zerothRxn;
@@ -429,6 +540,15 @@ void initializeRegionArray(struct region regionArray[],
 	const unsigned short MAX_RXNS,
 	const struct chem_rxn_struct * chem_rxn);
 
+// Recalculate the region members that depend on the diffusion coefficients
+// and the chemical reaction rates (e.g., for the next simulation of a sweep)
+void resetRegionRates(struct region regionArray[],
+	const short NUM_REGIONS,
+	const unsigned short NUM_MOL_TYPES,
+	double DIFF_COEF[NUM_REGIONS][NUM_MOL_TYPES],
+	const unsigned short MAX_RXNS,
+	const struct chem_rxn_struct * chem_rxn);
+
 // Initialize region knowledge of the subvolumes that are adjacent to it
 void initializeRegionSubNeighbor(struct region regionArray[],
 	const struct spec_region3D subvol_spec[],
@@ -546,11 +666,52 @@ void generatePointInRegion(const short curRegion,
 	const struct region regionArray[],
 	double point[3]);
 
+// Build sampler for placing points in the part of a boundary that is in a
+// region but not in its children. Points are placed on the surface of the
+// boundary if bSurface is true
+void initializePlacementSampler(struct placementSampler * sampler,
+	const short curRegion,
+	const struct region regionArray[],
+	const int shape,
+	const double boundary[],
+	const bool bSurface);
+
+// Generate a random point with a placement sampler
+void generatePlacementPoint(const struct placementSampler * sampler,
+	const short curRegion,
+	const struct region regionArray[],
+	double point[3]);
+
+// Generate a batch of up to PLACEMENT_BATCH_SIZE random points with a
+// placement sampler
+void generatePlacementPoints(const struct placementSampler * sampler,
+	const short curRegion,
+	const struct region regionArray[],
+	const uint32_t numPoint,
+	double point[][3]);
+
+// Free memory allocated to a placement sampler
+void deletePlacementSampler(struct placementSampler * sampler);
+
+// Find the bounding box of a boundary
+void findBoundaryBoundingBox(const int shape,
+	const double boundary[],
+	double bound[6]);
+
 // Which region contains given point, excluding children?
 short findRegionNotChild(const short NUM_REGIONS,
 	const struct region regionArray[],
 	double point[3]);
 
+// Build the voxel map of region membership that accelerates point classification
+void initializeRegionVoxelMap(const short NUM_REGIONS,
+	struct region regionArray[]);
+
+// Which region owns the voxel that contains given point?
+// Returns VOXEL_MIXED if the point must be classified directly
+short findVoxelOwner(const struct voxelMap * map,
+	const double point[3]);
+
 // Does a subvolume face a region? If yes, then along which faces?
 // Assert that current subvolume is mesoscopic, along its own region boundary, and that
 // neighbor region is microscopic
@@ -571,6 +732,10 @@ void initializeRegionNesting(const short NUM_REGIONS,
 void findNumRegionSubvolumes(const short NUM_REGIONS,
 	struct region regionArray[]);
 
+// Determine which outer faces of each region only reflect molecules
+void findRegionReflectFaces(const short NUM_REGIONS,
+	struct region regionArray[]);
+
 // Allocate memory for each region's neighbors
 void allocateRegionNeighbors(const short NUM_REGIONS,
 	struct region regionArray[]);
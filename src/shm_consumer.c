@@ -0,0 +1,319 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * shm_consumer.c - reference reader of the shared memory output of a
+ *				running simulation. Reads the observations of each
+ *				realization in place and prints summary statistics of the
+ *				molecule counts when the simulation finishes. See
+ *				shm_output.h for the layout of the shared memory
+ *
+ *				Usage: accord_shm_consumer.out NAME [--keep]
+ *				where NAME is the output filename with the "_SEED#" suffix
+ *				(e.g., "accord_sample_SEED1"). The shared memory is removed
+ *				after reading unless --keep is given
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#define _POSIX_C_SOURCE 200112L // for shm_open(), nanosleep()
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h> // for PRIu64
+#include <string.h>
+#include <math.h> // for sqrt()
+#include <time.h> // for nanosleep()
+#include <sys/mman.h> // for shm_open(), mmap()
+#include <sys/stat.h> // for fstat()
+#include <fcntl.h> // for O_RDONLY
+#include <unistd.h> // for close()
+#include "shm_output.h"
+
+//
+// Constant definitions
+//
+
+// Maximum number of (actor, molecule type) pairs that statistics are kept for
+#define MAX_COUNT_STAT 256
+
+// Time to wait between checks for new records (in nanoseconds)
+#define POLL_INTERVAL 1000000L
+
+// Number of checks for the shared memory before giving up
+#define MAX_OPEN_ATTEMPT 10000
+
+//
+// Data Type Declarations
+//
+
+/* The countStat structure has the running statistics of the counts of one
+* molecule type observed by one actor.
+*/
+struct countStat {
+	uint32_t actorID;
+	uint32_t molID;
+	uint64_t numObs; // Number of observations
+	double sum; // Sum of counts
+	double sumSq; // Sum of squared counts
+	uint64_t max; // Largest count
+};
+
+//
+// "Private" Declarations
+//
+
+// Read one record. Statistics are added to the pending copy so that they can
+// be discarded if the record is overwritten while being read. Returns false if
+// the record is malformed
+static bool readRecord(const unsigned char * record,
+	const uint64_t length,
+	struct countStat stat[],
+	unsigned int * numStat);
+
+// Find (or add) the statistics of an actor and molecule type
+static struct countStat * findCountStat(struct countStat stat[],
+	unsigned int * numStat,
+	const uint32_t actorID,
+	const uint32_t molID);
+
+// Wait for POLL_INTERVAL
+static void waitForRecord(void);
+
+//
+// Definitions
+//
+
+int main(int argc, char *argv[])
+{
+	char * name;
+	int fd = -1;
+	unsigned int attempt, curStat;
+	struct stat segmentStat;
+	const struct shmOutputHeader * header;
+	const unsigned char * ring;
+	uint64_t tail, head, reserve, pos, length, capacity;
+	uint64_t numRecord = 0, numLost = 0;
+	struct countStat stat[MAX_COUNT_STAT], pendingStat[MAX_COUNT_STAT];
+	unsigned int numStat = 0, numPendingStat;
+	bool bKeep = false, bValid;
+	double mean;
+
+	if(argc < 2)
+	{
+		fprintf(stderr, "Usage: %s NAME [--keep]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	if(argc > 2 && strcmp(argv[2], "--keep") == 0)
+		bKeep = true;
+
+	name = malloc(strlen(argv[1]) + 2);
+	if(name == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation for shared memory name.\n");
+		return EXIT_FAILURE;
+	}
+	sprintf(name, "/%s", argv[1]);
+
+	// Wait for the simulation to create the shared memory
+	for(attempt = 0; attempt < MAX_OPEN_ATTEMPT; attempt++)
+	{
+		fd = shm_open(name, O_RDONLY, 0);
+		if(fd >= 0 && fstat(fd, &segmentStat) == 0
+			&& (size_t) segmentStat.st_size >= sizeof(struct shmOutputHeader))
+			break;
+		if(fd >= 0)
+			close(fd);
+		fd = -1;
+		waitForRecord();
+	}
+	if(fd < 0)
+	{
+		fprintf(stderr, "ERROR: Shared memory \"%s\" was not found.\n", name);
+		return EXIT_FAILURE;
+	}
+	header = mmap(NULL, (size_t) segmentStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(header == MAP_FAILED)
+	{
+		fprintf(stderr, "ERROR: Shared memory \"%s\" could not be mapped.\n", name);
+		return EXIT_FAILURE;
+	}
+	while(memcmp(header->magic, SHM_OUTPUT_MAGIC, 8) != 0)
+		waitForRecord();
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	capacity = header->capacity;
+	ring = (const unsigned char *) header + header->headerSize;
+	printf("Reading \"%s\": seed %" PRIu64 ", %u realization(s), %u recorded actor(s), %" PRIu64 " byte ring\n",
+		name, header->seed, header->numRepeat, header->numActorRecord, capacity);
+
+	// Read records as they are published
+	tail = 0;
+	while(true)
+	{
+		head = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+		if(tail == head)
+		{
+			if(__atomic_load_n(&header->bFinished, __ATOMIC_ACQUIRE)
+				&& tail == __atomic_load_n(&header->head, __ATOMIC_ACQUIRE))
+				break;
+			waitForRecord();
+			continue;
+		}
+		if(__atomic_load_n(&header->reserve, __ATOMIC_RELAXED) - tail > capacity)
+		{ // Records were overwritten before they were read
+			numLost++;
+			tail = __atomic_load_n(&header->lastRecord, __ATOMIC_RELAXED);
+			continue;
+		}
+
+		// Read the record in place
+		pos = tail % capacity;
+		memcpy(&length, ring + pos, sizeof(uint64_t));
+		if(length == 0)
+		{ // Rest of ring is unused
+			tail += capacity - pos;
+			continue;
+		}
+		memcpy(pendingStat, stat, numStat*sizeof(struct countStat));
+		numPendingStat = numStat;
+		bValid = length <= capacity - pos
+			&& readRecord(ring + pos, length, pendingStat, &numPendingStat);
+
+		// Check that the record was not overwritten while it was read
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		reserve = __atomic_load_n(&header->reserve, __ATOMIC_RELAXED);
+		if(reserve - tail > capacity)
+		{
+			numLost++;
+			tail = __atomic_load_n(&header->lastRecord, __ATOMIC_RELAXED);
+			continue;
+		}
+		if(!bValid)
+		{
+			fprintf(stderr, "ERROR: Record at byte %" PRIu64 " is malformed.\n", tail);
+			return EXIT_FAILURE;
+		}
+		memcpy(stat, pendingStat, numPendingStat*sizeof(struct countStat));
+		numStat = numPendingStat;
+		numRecord++;
+		tail += length;
+	}
+
+	printf("Read %" PRIu64 " realization(s). %" PRIu64 " gap(s) where realizations were overwritten before being read.\n",
+		numRecord, numLost);
+	printf("Actor\tMolID\tNumObs\tMean\tStdDev\tMax\n");
+	for(curStat = 0; curStat < numStat; curStat++)
+	{
+		mean = (stat[curStat].numObs > 0) ?
+			stat[curStat].sum / stat[curStat].numObs : 0.;
+		printf("%u\t%u\t%" PRIu64 "\t%.4f\t%.4f\t%" PRIu64 "\n",
+			stat[curStat].actorID, stat[curStat].molID, stat[curStat].numObs,
+			mean, (stat[curStat].numObs > 0) ?
+			sqrt(fabs(stat[curStat].sumSq / stat[curStat].numObs - mean*mean)) : 0.,
+			stat[curStat].max);
+	}
+
+	munmap((void *) header, (size_t) segmentStat.st_size);
+	if(!bKeep)
+		shm_unlink(name);
+	free(name);
+	return EXIT_SUCCESS;
+}
+
+// Read one record. Statistics are added to the pending copy so that they can
+// be discarded if the record is overwritten while being read. Returns false if
+// the record is malformed
+static bool readRecord(const unsigned char * record,
+	const uint64_t length,
+	struct countStat stat[],
+	unsigned int * numStat)
+{
+	uint64_t pos = sizeof(uint64_t) + sizeof(uint32_t);
+	uint32_t numActor, curActor, actorID, numMolType, numObs, bTime;
+	uint32_t curMolInd, curObs, molID;
+	uint64_t count;
+	struct countStat * curStat;
+
+	if(length < 2*sizeof(uint64_t))
+		return false;
+	memcpy(&numActor, record + pos, sizeof(uint32_t));
+	pos += sizeof(uint32_t);
+	for(curActor = 0; curActor < numActor; curActor++)
+	{
+		if(pos + 4*sizeof(uint32_t) > length)
+			return false;
+		memcpy(&actorID, record + pos, sizeof(uint32_t));
+		memcpy(&numMolType, record + pos + 4, sizeof(uint32_t));
+		memcpy(&numObs, record + pos + 8, sizeof(uint32_t));
+		memcpy(&bTime, record + pos + 12, sizeof(uint32_t));
+		pos += 4*sizeof(uint32_t);
+		if(pos + 8*((numMolType + 1ULL)/2)
+			+ (bTime*sizeof(double) + numMolType*sizeof(uint64_t))*(uint64_t) numObs
+			> length)
+			return false;
+
+		// Skip to counts, then read counts of each molecule type
+		for(curMolInd = 0; curMolInd < numMolType; curMolInd++)
+		{
+			memcpy(&molID, record + pos + 4*curMolInd, sizeof(uint32_t));
+			curStat = findCountStat(stat, numStat, actorID, molID);
+			if(curStat == NULL)
+				continue;
+			for(curObs = 0; curObs < numObs; curObs++)
+			{
+				memcpy(&count, record + pos + 8*((numMolType + 1)/2)
+					+ bTime*sizeof(double)*numObs
+					+ sizeof(uint64_t)*((uint64_t) curMolInd*numObs + curObs),
+					sizeof(uint64_t));
+				curStat->numObs++;
+				curStat->sum += (double) count;
+				curStat->sumSq += (double) count * (double) count;
+				if(count > curStat->max)
+					curStat->max = count;
+			}
+		}
+		pos += 8*((numMolType + 1)/2)
+			+ (bTime*sizeof(double) + numMolType*sizeof(uint64_t))*numObs;
+	}
+	return pos == length;
+}
+
+// Find (or add) the statistics of an actor and molecule type
+static struct countStat * findCountStat(struct countStat stat[],
+	unsigned int * numStat,
+	const uint32_t actorID,
+	const uint32_t molID)
+{
+	unsigned int curStat;
+
+	for(curStat = 0; curStat < *numStat; curStat++)
+	{
+		if(stat[curStat].actorID == actorID && stat[curStat].molID == molID)
+			return &stat[curStat];
+	}
+	if(*numStat == MAX_COUNT_STAT)
+		return NULL;
+	stat[*numStat].actorID = actorID;
+	stat[*numStat].molID = molID;
+	stat[*numStat].numObs = 0;
+	stat[*numStat].sum = 0.;
+	stat[*numStat].sumSq = 0.;
+	stat[*numStat].max = 0;
+	return &stat[(*numStat)++];
+}
+
+// Wait for POLL_INTERVAL
+static void waitForRecord(void)
+{
+	struct timespec interval = {0, POLL_INTERVAL};
+
+	nanosleep(&interval, NULL);
+}
@@ -0,0 +1,278 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * shm_output.c - publish the observations of each realization to a POSIX
+ *				shared memory ring buffer so that a separate process can
+ *				analyze them while the simulation runs
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifdef __linux__
+	#define _POSIX_C_SOURCE 200112L // for shm_open(), ftruncate()
+	#include <sys/mman.h> // for shm_open(), mmap()
+	#include <sys/stat.h> // for permissions of segment
+	#include <fcntl.h> // for O_CREAT, O_RDWR
+	#include <unistd.h> // for ftruncate(), close()
+#endif // __linux__
+#include <string.h> // for strlen(), memcpy(), memset()
+#include <inttypes.h> // for PRIu64
+#include "shm_output.h"
+#include "output_writer.h" // for realizationOutput
+
+//
+// "Private" Declarations
+//
+
+// Find the number of observations that one actor has in a record and whether
+// their times are included
+static uint32_t countRecordObs(const struct realizationOutput * result,
+	const short curActorRecord,
+	const short curPassive,
+	const bool bRecordTime,
+	uint32_t * bTime);
+
+// Copy a value to a record and advance the position in the record
+static void writeRecordValue(unsigned char ** cursor,
+	const void * value,
+	const size_t numByte);
+
+//
+// Definitions
+//
+
+// Create (or reset) the shared memory segment of the simulation.
+// ringSize is the number of bytes of records
+void openShmOutput(struct shmOutput * shm,
+	const char * outputName,
+	const uint32_t seed,
+	const unsigned int numRepeat,
+	const short numActorRecord,
+	const uint64_t ringSize)
+{
+#ifdef __linux__
+	size_t i;
+	int fd;
+	void * map;
+	uint64_t capacity = ringSize - ringSize % 8;
+
+	shm->header = NULL;
+	shm->ring = NULL;
+	shm->name = malloc(strlen(outputName) + 2);
+	if(shm->name == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation for name of shared memory output.\n");
+		exit(EXIT_FAILURE);
+	}
+	shm->name[0] = '/';
+	for(i = 0; outputName[i] != '\0'; i++)
+		shm->name[i+1] = (outputName[i] == '/') ? '_' : outputName[i];
+	shm->name[i+1] = '\0';
+
+	shm->mapSize = sizeof(struct shmOutputHeader) + capacity;
+	fd = shm_open(shm->name, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+	if(fd < 0 || ftruncate(fd, (off_t) shm->mapSize) != 0)
+	{
+		fprintf(stderr, "ERROR: Shared memory output \"%s\" could not be created.\n",
+			shm->name);
+		exit(EXIT_FAILURE);
+	}
+	map = mmap(NULL, shm->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+	{
+		fprintf(stderr, "ERROR: Shared memory output \"%s\" could not be mapped.\n",
+			shm->name);
+		exit(EXIT_FAILURE);
+	}
+
+	shm->header = map;
+	shm->ring = (unsigned char *) map + sizeof(struct shmOutputHeader);
+	memset(shm->header->magic, 0, 8); // Segment may be left from a previous run
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	shm->header->headerSize = sizeof(struct shmOutputHeader);
+	shm->header->bFinished = 0;
+	shm->header->capacity = capacity;
+	shm->header->seed = seed;
+	shm->header->numRepeat = numRepeat;
+	shm->header->numActorRecord = (uint32_t) numActorRecord;
+	shm->header->reserve = 0;
+	shm->header->head = 0;
+	shm->header->lastRecord = 0;
+
+	// Readers wait for the magic value, so write it last
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(shm->header->magic, SHM_OUTPUT_MAGIC, 8);
+#else
+	fprintf(stderr, "WARNING: Shared memory output is only available on Linux.\n");
+	shm->header = NULL;
+	shm->ring = NULL;
+	shm->name = NULL;
+	shm->mapSize = 0;
+#endif // __linux__
+}
+
+// Write the observations of one realization to the ring
+void publishRealization(struct shmOutput * shm,
+	const struct realizationOutput * result,
+	const short numActorRecord,
+	const short actorRecordID[],
+	const struct actorStruct3D actorCommonArray[],
+	const struct actorPassiveStruct3D actorPassiveArray[])
+{
+	struct shmOutputHeader * header = shm->header;
+	short curActorRecord, curActor, curPassive;
+	unsigned short curMolInd, numMolType;
+	uint32_t numObs, value, bTime;
+	uint64_t length, head, start, pos, zero = 0;
+	const NodeObs3D * curObs;
+	unsigned char * cursor;
+
+	if(header == NULL)
+		return;
+
+	// Find the length of the record
+	length = 2*sizeof(uint64_t);
+	for(curActorRecord = 0; curActorRecord < numActorRecord; curActorRecord++)
+	{
+		curActor = actorRecordID[curActorRecord];
+		curPassive = actorCommonArray[curActor].passiveID;
+		numMolType = actorPassiveArray[curPassive].numMolRecordID;
+		numObs = countRecordObs(result, curActorRecord, curPassive,
+			actorCommonArray[curActor].spec.bRecordTime, &bTime);
+		length += 4*sizeof(uint32_t) + 8*((numMolType + 1)/2)
+			+ (bTime*sizeof(double) + numMolType*sizeof(uint64_t))*numObs;
+	}
+	if(length > header->capacity)
+	{
+		fprintf(stderr, "WARNING: Realization %u needs %" PRIu64 " bytes and does not fit in the shared memory output. It will not be published.\n",
+			result->curRepeat, length);
+		return;
+	}
+
+	// Find where the record starts. Skip the end of the ring if the record
+	// does not fit there
+	head = __atomic_load_n(&header->head, __ATOMIC_RELAXED);
+	pos = head % header->capacity;
+	start = (header->capacity - pos < length) ?
+		head + header->capacity - pos : head;
+
+	// Tell readers which bytes are about to be overwritten
+	__atomic_store_n(&header->reserve, start + length, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	if(start != head)
+		memcpy(shm->ring + pos, &zero, sizeof(uint64_t));
+
+	cursor = shm->ring + start % header->capacity;
+	writeRecordValue(&cursor, &length, sizeof(uint64_t));
+	value = result->curRepeat;
+	writeRecordValue(&cursor, &value, sizeof(uint32_t));
+	value = (uint32_t) numActorRecord;
+	writeRecordValue(&cursor, &value, sizeof(uint32_t));
+	for(curActorRecord = 0; curActorRecord < numActorRecord; curActorRecord++)
+	{
+		curActor = actorRecordID[curActorRecord];
+		curPassive = actorCommonArray[curActor].passiveID;
+		numMolType = actorPassiveArray[curPassive].numMolRecordID;
+		numObs = countRecordObs(result, curActorRecord, curPassive,
+			actorCommonArray[curActor].spec.bRecordTime, &bTime);
+
+		value = (uint32_t) curActor;
+		writeRecordValue(&cursor, &value, sizeof(uint32_t));
+		value = numMolType;
+		writeRecordValue(&cursor, &value, sizeof(uint32_t));
+		writeRecordValue(&cursor, &numObs, sizeof(uint32_t));
+		writeRecordValue(&cursor, &bTime, sizeof(uint32_t));
+		for(curMolInd = 0; curMolInd < numMolType; curMolInd++)
+		{
+			value = actorPassiveArray[curPassive].molRecordID[curMolInd];
+			writeRecordValue(&cursor, &value, sizeof(uint32_t));
+		}
+		if(numMolType % 2 == 1)
+			writeRecordValue(&cursor, &zero, sizeof(uint32_t));
+
+		if(bTime)
+		{
+			for(curObs = result->observationArray[curActorRecord].head;
+				curObs != NULL; curObs = curObs->next)
+				writeRecordValue(&cursor, &curObs->item.paramDouble[0],
+					sizeof(double));
+		}
+		for(curMolInd = 0; curMolInd < numMolType; curMolInd++)
+		{
+			if(result->absorbLog[curPassive] != NULL)
+			{
+				writeRecordValue(&cursor,
+					&result->absorbLog[curPassive][curMolInd].numEvent,
+					sizeof(uint64_t));
+				continue;
+			}
+			for(curObs = result->observationArray[curActorRecord].head;
+				curObs != NULL; curObs = curObs->next)
+				writeRecordValue(&cursor, &curObs->item.paramUllong[curMolInd],
+					sizeof(uint64_t));
+		}
+	}
+
+	// Publish the record
+	__atomic_store_n(&header->lastRecord, start, __ATOMIC_RELAXED);
+	__atomic_store_n(&header->head, start + length, __ATOMIC_RELEASE);
+}
+
+// Mark the simulation as finished and unmap the segment
+void closeShmOutput(struct shmOutput * shm)
+{
+#ifdef __linux__
+	if(shm->header != NULL)
+	{
+		__atomic_store_n(&shm->header->bFinished, 1, __ATOMIC_RELEASE);
+		munmap(shm->header, shm->mapSize);
+		shm->header = NULL;
+	}
+#endif // __linux__
+	if(shm->name != NULL)
+	{
+		free(shm->name);
+		shm->name = NULL;
+	}
+}
+
+// Find the number of observations that one actor has in a record and whether
+// their times are included
+static uint32_t countRecordObs(const struct realizationOutput * result,
+	const short curActorRecord,
+	const short curPassive,
+	const bool bRecordTime,
+	uint32_t * bTime)
+{
+	const NodeObs3D * curObs;
+	uint32_t numObs = 0;
+
+	*bTime = 0;
+	if(result->absorbLog[curPassive] != NULL)
+		return 1; // Counts are the numbers of absorption events
+
+	for(curObs = result->observationArray[curActorRecord].head;
+		curObs != NULL; curObs = curObs->next)
+		numObs++;
+	if(bRecordTime)
+		*bTime = 1;
+	return numObs;
+}
+
+// Copy a value to a record and advance the position in the record
+static void writeRecordValue(unsigned char ** cursor,
+	const void * value,
+	const size_t numByte)
+{
+	memcpy(*cursor, value, numByte);
+	*cursor += numByte;
+}
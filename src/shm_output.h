@@ -0,0 +1,128 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * shm_output.h - publish the observations of each realization to a POSIX
+ *				shared memory ring buffer so that a separate process can
+ *				analyze them while the simulation runs
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifndef SHM_OUTPUT_H
+#define SHM_OUTPUT_H
+
+#include <stdio.h> // for fprintf()
+#include <stdlib.h> // for exit(), malloc, free
+#include <stdbool.h> // for C++ bool naming, requires C99
+#include <stdint.h> // for uint32_t, uint64_t
+#include "actor.h"
+
+/* LAYOUT OF THE SHARED MEMORY SEGMENT
+*
+* The segment is named "/" followed by the output filename (which ends with
+* "_SEED#"), with any other "/" replaced by "_". It begins with a
+* shmOutputHeader and is followed by a ring of "capacity" bytes of records.
+* All values are in the byte order of the simulating machine and every
+* record starts on a multiple of 8 bytes. Byte positions in the header count
+* all bytes ever written, so record data at position p is at byte
+* (p % capacity) of the ring.
+*
+* A record has the observations of one realization:
+*	uint64_t length			// Bytes in record (including this value).
+*							// 0 means that the rest of the ring is unused and
+*							// the next record is at the start of the ring
+*	uint32_t realization	// Index of realization (starting from 0)
+*	uint32_t numActor		// Number of recorded passive actors
+*	For each recorded passive actor:
+*		uint32_t actorID	// Index of actor in configuration file
+*		uint32_t numMolType	// Number of recorded molecule types
+*		uint32_t numObs		// Number of observations
+*		uint32_t bTime		// Are observation times included?
+*		uint32_t molID[numMolType] // Recorded molecule types, followed by
+*							// 4 bytes of padding if numMolType is odd
+*		double time[numObs]	// Observation times (if bTime == 1)
+*		uint64_t count[numMolType][numObs] // Molecule counts
+*
+* An actor that logs absorption events has 1 "observation" whose counts are
+* the numbers of events in the realization.
+*
+* The simulation never waits for a reader. Before it writes a record, it
+* sets "reserve" to the position after the record. When the record is
+* complete, it sets "lastRecord" to the record's position and "head" to the
+* position after the record. A reader that has read up to position p can
+* read the record at p if p < head, and the data it read was valid if
+* reserve - p <= capacity afterwards. Otherwise, the reader fell behind and
+* can continue from lastRecord. "bFinished" is set to 1 after the last
+* record has been published. The segment is not removed by the simulation.
+*/
+
+//
+// Constant definitions
+//
+
+#define SHM_OUTPUT_MAGIC "ACSHM001"
+
+//
+// Data Type Declarations
+//
+
+struct realizationOutput; // Defined in output_writer.h
+
+/* The shmOutputHeader structure is the start of the shared memory segment
+* (64 bytes).
+*/
+struct shmOutputHeader {
+	char magic[8]; // SHM_OUTPUT_MAGIC (without terminating null)
+	uint32_t headerSize; // Bytes from start of segment to start of ring
+	uint32_t bFinished; // Has the simulation published every realization?
+	uint64_t capacity; // Bytes in ring
+	uint64_t seed; // Seed of the simulation
+	uint32_t numRepeat; // Number of realizations in the simulation
+	uint32_t numActorRecord; // Number of recorded passive actors
+	uint64_t reserve; // Position after the record being written
+	uint64_t head; // Position after the most recent complete record
+	uint64_t lastRecord; // Position of the most recent complete record
+};
+
+/* The shmOutput structure is the simulation's mapping of the shared memory
+* segment.
+*/
+struct shmOutput {
+	struct shmOutputHeader * header; // NULL if not publishing
+	unsigned char * ring; // Start of the ring of records
+	size_t mapSize; // Bytes in segment
+	char * name; // Name of segment
+};
+
+//
+// Function Declarations
+//
+
+// Create (or reset) the shared memory segment of the simulation.
+// ringSize is the number of bytes of records
+void openShmOutput(struct shmOutput * shm,
+	const char * outputName,
+	const uint32_t seed,
+	const unsigned int numRepeat,
+	const short numActorRecord,
+	const uint64_t ringSize);
+
+// Write the observations of one realization to the ring
+void publishRealization(struct shmOutput * shm,
+	const struct realizationOutput * result,
+	const short numActorRecord,
+	const short actorRecordID[],
+	const struct actorStruct3D actorCommonArray[],
+	const struct actorPassiveStruct3D actorPassiveArray[]);
+
+// Mark the simulation as finished and unmap the segment
+void closeShmOutput(struct shmOutput * shm);
+
+#endif // SHM_OUTPUT_H
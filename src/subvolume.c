@@ -10,10 +10,14 @@
  * subvolume.c - 	structure for storing subvolume properties. Simulation
  *					environment is partitioned into subvolumes
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added optional cache of subvolume neighbours on disk
+ * - added reset of the parameters that can change between the simulations of a sweep
+ *
  * Revision v0.5 (2016-04-15)
  * - corrected memory allocation for subvolume helper arrays
  * - added surface subvolumes
@@ -39,6 +43,7 @@
 #include <stdbool.h> // for C++ bool conventions
 #include <inttypes.h> // for extended integer type macros
 #include <limits.h> // For SHRT_MAX
+#include <string.h> // for memcpy()
 #include "subvolume.h" // for "Public" declarations
 
 //
@@ -325,7 +330,9 @@ void buildSubvolArray(const uint32_t numSub,
 	double DIFF_COEF[NUM_REGIONS][NUM_MOL_TYPES],
 	uint32_t subCoorInd[numSub][3],
 	uint32_t **** subID,
-	uint32_t (** subIDSize)[2])
+	uint32_t (** subIDSize)[2],
+	const uint32_t cacheNumNeigh[],
+	const uint32_t cacheNeighID[])
 {	
 	short int i,j, curRegion, neighRegion, sphRegion, rectRegion; // Current Region
 	unsigned short curMolType;
@@ -337,7 +344,6 @@ void buildSubvolArray(const uint32_t numSub,
 	uint32_t curBoundID = 0; // Current subvolume in region boundary list
 	uint32_t curMesoID = 0; // Current Mesoscopic Subvolume ID
 	uint32_t curNeighID = 0; // Current Subvolume neighbour ID
-	uint32_t neighID = 0; // Subvolume neighbour ID in master subvolume list
 	
 	uint32_t sphSub, rectSub; // IDs of subvolumes that are spherical, rectangular
 	unsigned short numFaceSph = 0; // Number of faces of subvolume that border a spherical region
@@ -359,17 +365,13 @@ void buildSubvolArray(const uint32_t numSub,
 	
 	double curSubBound[6]; // Boundary of current subvolume
 	double curNeighBound[6]; // Boundary of prospective neighbor subvolume
-	double boundOverlap[6]; // Overlap area of adjacent subvolumes
 	for(i=0; i < 6; i++)
 	{
 		curSubBound[i] = 0.;
 		curNeighBound[i] = 0.;
-		boundOverlap[i] = 0.;
 	}
 	unsigned short adjDirection = 0;
 	double boundAdjError = SUBVOL_BASE_SIZE * SUB_ADJ_RESOLUTION;
-	
-	double h_i, h_j; // Subvolume sizes (used for finding transition rates)
 			
 	// Store basic subvolume information based on the specification
 	// Populate subvolArray based on subvol_spec
@@ -664,8 +666,13 @@ void buildSubvolArray(const uint32_t numSub,
 	*numMesoSub = curMesoID;
 	
 	// Determine the neighbors of each subvolume that are in other regions
-	printf("Finding Neighbours of Each Subvolume...\n");
-	if(NUM_REGIONS > 1)
+	if(cacheNumNeigh != NULL)
+	{ // Neighbors are known. Replace the counts within each region
+		for(curID = 0; curID < numSub; curID++)
+			subvolArray[curID].num_neigh = (unsigned short) cacheNumNeigh[curID];
+	} else
+		printf("Finding Neighbours of Each Subvolume...\n");
+	if(NUM_REGIONS > 1 && cacheNumNeigh == NULL)
 	{ // Only need to continue if there is more than one region
 
 		for(curID = 0; curID < numSub; curID++)
@@ -727,7 +734,17 @@ void buildSubvolArray(const uint32_t numSub,
 	}
 		
 	// Find and store IDs of each subvolume's neighbors
-	for(curID = 0; curID < numSub; curID++)
+	if(cacheNeighID != NULL)
+	{ // Neighbors are known
+		curNeighID = 0;
+		for(curID = 0; curID < numSub; curID++)
+		{
+			memcpy(subvolArray[curID].neighID, &cacheNeighID[curNeighID],
+				subvolArray[curID].num_neigh*sizeof(uint32_t));
+			curNeighID += subvolArray[curID].num_neigh;
+		}
+	}
+	for(curID = 0; curID < numSub && cacheNeighID == NULL; curID++)
 	{
 		// Calculate neighbors in the same region
 		curRegion = subvolArray[curID].regionID;
@@ -833,7 +850,7 @@ void buildSubvolArray(const uint32_t numSub,
 	if(NUM_REGIONS > 1)
 	{ // Only need to enter if there is more than one region
 
-		// Determine transition rates out of mesoscopic subvolumes that are along
+		// Allocate transition rates out of mesoscopic subvolumes that are along
 		// the boundary of their respective region
 		for(curID = 0; curID < numSub; curID++)
 		{ // For each subvolume
@@ -858,87 +875,12 @@ void buildSubvolArray(const uint32_t numSub,
 					exit(EXIT_FAILURE);
 				}
 			}
-			
-			curRegion = subvolArray[curID].regionID;
-			h_i = regionArray[curRegion].actualSubSize;
-			
-			findSubvolCoor(curSubBound, regionArray[curRegion], subCoorInd[curID]);
-			
-			for(curNeighID = 0; curNeighID < subvolArray[curID].num_neigh;
-				curNeighID++)
-			{
-				// Find actual neighbor index and region
-				neighID = subvolArray[curID].neighID[curNeighID];
-				neighRegion = subvolArray[neighID].regionID;
-				if (curRegion == neighRegion)
-				{ // Transition rate only depends on source volume
-					for(curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
-					{
-						subvolArray[curID].diffRateNeigh[curMolType][curNeighID] =
-							DIFF_COEF[curRegion][curMolType]/h_i/h_i;
-					}						
-				} else
-				{
-					if(regionArray[curRegion].spec.type !=
-						regionArray[neighRegion].spec.type)
-					{
-						// Regions are not of the same type (at least one is a surface)
-						// Normal diffusion between these regions is not possible
-						for(curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
-						{
-							// TODO: Correct this preliminary solution which prevents
-							// any transition out of a meso subvolume to a surface.
-							// Correct implementation would base transition rate
-							// on corresponding chemical reaction probabilities
-							subvolArray[curID].diffRateNeigh[curMolType][curNeighID] = 0.;
-						}
-						continue;
-					}
-					
-					// TODO: Need to catch cases where a membrane lies in between two
-					// subvolumes so that the diffusion rate can be adjusted properly
-					
-					if(regionArray[neighRegion].spec.bMicro)
-						h_j = h_i;
-					else
-						h_j = regionArray[neighRegion].actualSubSize;
-					
-					// Determine overlap area
-					if(regionArray[neighRegion].spec.shape == RECTANGULAR_BOX)
-					{
-						findSubvolCoor(curNeighBound, regionArray[neighRegion],
-							subCoorInd[neighID]);
-						intersectBoundary(RECTANGULAR_BOX, curSubBound,
-							RECTANGULAR_BOX, curNeighBound, boundOverlap);
-					} else if (regionArray[neighRegion].spec.shape == SPHERE)
-					{
-						// Assume that overlap is entire subvolume face
-						boundOverlap[0] = 0;
-						boundOverlap[1] = h_i;
-						boundOverlap[2] = 0;
-						boundOverlap[3] = h_i;
-						boundOverlap[4] = 0;
-						boundOverlap[5] = 0;
-					}
-					
-					for(curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
-					{
-						subvolArray[curID].diffRateNeigh[curMolType][curNeighID] =
-							2*DIFF_COEF[curRegion][curMolType]/h_i/(h_i + h_j);
-						if(fabs(boundOverlap[0] - boundOverlap[1]) > boundAdjError)
-							subvolArray[curID].diffRateNeigh[curMolType][curNeighID] *=
-								(boundOverlap[1] - boundOverlap[0])/h_i;
-						if(fabs(boundOverlap[2] - boundOverlap[3]) > boundAdjError)
-							subvolArray[curID].diffRateNeigh[curMolType][curNeighID] *=
-								(boundOverlap[3] - boundOverlap[2])/h_i;
-						if(fabs(boundOverlap[4] - boundOverlap[5]) > boundAdjError)
-							subvolArray[curID].diffRateNeigh[curMolType][curNeighID] *=
-								(boundOverlap[5] - boundOverlap[4])/h_i;
-					}
-				}
-			}
 		}
 		
+		// Determine transition rates out of boundary subvolumes
+		findSubvolDiffRate(numSub, subvolArray, regionArray, NUM_REGIONS,
+			NUM_MOL_TYPES, SUBVOL_BASE_SIZE, DIFF_COEF, subCoorInd);
+		
 		// Initialize region knowledge of the subvolumes that are adjacent to it
 		initializeRegionSubNeighbor(regionArray, subvol_spec,
 			NUM_REGIONS, NUM_MOL_TYPES, SUBVOL_BASE_SIZE,
@@ -950,6 +892,112 @@ void buildSubvolArray(const uint32_t numSub,
 	return;
 }
 
+// Determine the transition rates out of mesoscopic subvolumes that are along
+// the boundary of their respective region. The rates must already be allocated
+void findSubvolDiffRate(const uint32_t numSub,
+	struct subvolume3D subvolArray[],
+	const struct region regionArray[],
+	const short NUM_REGIONS,
+	const unsigned short NUM_MOL_TYPES,
+	const double SUBVOL_BASE_SIZE,
+	double DIFF_COEF[NUM_REGIONS][NUM_MOL_TYPES],
+	uint32_t subCoorInd[numSub][3])
+{
+	short curRegion, neighRegion;
+	unsigned short curMolType;
+	uint32_t curID, curNeighID, neighID;
+	double curSubBound[6] = {0., 0., 0., 0., 0., 0.}; // Boundary of current subvolume
+	double curNeighBound[6] = {0., 0., 0., 0., 0., 0.}; // Boundary of prospective neighbor subvolume
+	double boundOverlap[6] = {0., 0., 0., 0., 0., 0.}; // Overlap area of adjacent subvolumes
+	double boundAdjError = SUBVOL_BASE_SIZE * SUB_ADJ_RESOLUTION;
+	double h_i, h_j; // Subvolume sizes
+	
+	for(curID = 0; curID < numSub; curID++)
+	{ // For each subvolume
+		if(!subvolArray[curID].bBoundary || regionArray[subvolArray[curID].regionID].spec.bMicro)
+			continue; // This subvolume is not meso and along the boundary
+		
+		curRegion = subvolArray[curID].regionID;
+		h_i = regionArray[curRegion].actualSubSize;
+		
+		findSubvolCoor(curSubBound, regionArray[curRegion], subCoorInd[curID]);
+		
+		for(curNeighID = 0; curNeighID < subvolArray[curID].num_neigh;
+			curNeighID++)
+		{
+			// Find actual neighbor index and region
+			neighID = subvolArray[curID].neighID[curNeighID];
+			neighRegion = subvolArray[neighID].regionID;
+			if (curRegion == neighRegion)
+			{ // Transition rate only depends on source volume
+				for(curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
+				{
+					subvolArray[curID].diffRateNeigh[curMolType][curNeighID] =
+						DIFF_COEF[curRegion][curMolType]/h_i/h_i;
+				}						
+			} else
+			{
+				if(regionArray[curRegion].spec.type !=
+					regionArray[neighRegion].spec.type)
+				{
+					// Regions are not of the same type (at least one is a surface)
+					// Normal diffusion between these regions is not possible
+					for(curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
+					{
+						// TODO: Correct this preliminary solution which prevents
+						// any transition out of a meso subvolume to a surface.
+						// Correct implementation would base transition rate
+						// on corresponding chemical reaction probabilities
+						subvolArray[curID].diffRateNeigh[curMolType][curNeighID] = 0.;
+					}
+					continue;
+				}
+				
+				// TODO: Need to catch cases where a membrane lies in between two
+				// subvolumes so that the diffusion rate can be adjusted properly
+				
+				if(regionArray[neighRegion].spec.bMicro)
+					h_j = h_i;
+				else
+					h_j = regionArray[neighRegion].actualSubSize;
+				
+				// Determine overlap area
+				if(regionArray[neighRegion].spec.shape == RECTANGULAR_BOX)
+				{
+					findSubvolCoor(curNeighBound, regionArray[neighRegion],
+						subCoorInd[neighID]);
+					intersectBoundary(RECTANGULAR_BOX, curSubBound,
+						RECTANGULAR_BOX, curNeighBound, boundOverlap);
+				} else if (regionArray[neighRegion].spec.shape == SPHERE)
+				{
+					// Assume that overlap is entire subvolume face
+					boundOverlap[0] = 0;
+					boundOverlap[1] = h_i;
+					boundOverlap[2] = 0;
+					boundOverlap[3] = h_i;
+					boundOverlap[4] = 0;
+					boundOverlap[5] = 0;
+				}
+				
+				for(curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
+				{
+					subvolArray[curID].diffRateNeigh[curMolType][curNeighID] =
+						2*DIFF_COEF[curRegion][curMolType]/h_i/(h_i + h_j);
+					if(fabs(boundOverlap[0] - boundOverlap[1]) > boundAdjError)
+						subvolArray[curID].diffRateNeigh[curMolType][curNeighID] *=
+							(boundOverlap[1] - boundOverlap[0])/h_i;
+					if(fabs(boundOverlap[2] - boundOverlap[3]) > boundAdjError)
+						subvolArray[curID].diffRateNeigh[curMolType][curNeighID] *=
+							(boundOverlap[3] - boundOverlap[2])/h_i;
+					if(fabs(boundOverlap[4] - boundOverlap[5]) > boundAdjError)
+						subvolArray[curID].diffRateNeigh[curMolType][curNeighID] *=
+							(boundOverlap[5] - boundOverlap[4])/h_i;
+				}
+			}
+		}
+	}
+}
+
 // Determine whether two subvolumes in neighboring regions are neighbors themselves
 // Assert that each subvolume is along its own region's boundary
 // If subvolumes are neighbors, then the direction from curID towards neighID
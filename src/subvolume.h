@@ -10,10 +10,14 @@
  * subvolume.h - 	structure for storing subvolume properties. Simulation
  *					environment is partitioned into subvolumes
  *
- * Last revised for AcCoRD v0.5 (2016-04-15)
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - added optional cache of subvolume neighbours on disk
+ * - added reset of the parameters that can change between the simulations of a sweep
+ *
  * Revision v0.5 (2016-04-15)
  * - corrected memory allocation for subvolume helper arrays
  * - added surface subvolumes
@@ -127,7 +131,10 @@ void deleteSubvolHelper(uint32_t subCoorInd[][3],
 
 // Construct the array of structures with details of each subvolume
 /* Each structure in the array subvol_spec defines a square/cube region of
-* subvolumes with common properties */
+* subvolumes with common properties.
+* If cacheNumNeigh and cacheNeighID are not NULL, then they are the numbers
+* and IDs of the neighbours of every subvolume (e.g., from a geometry cache)
+* and the neighbours are not searched for */
 void buildSubvolArray(const uint32_t numSub,
 	uint32_t * numMesoSub,
 	struct subvolume3D subvolArray[],
@@ -140,7 +147,20 @@ void buildSubvolArray(const uint32_t numSub,
 	double DIFF_COEF[NUM_REGIONS][NUM_MOL_TYPES],
 	uint32_t subCoorInd[numSub][3],
 	uint32_t **** subID,
-	uint32_t (** subIDSize)[2]);
+	uint32_t (** subIDSize)[2],
+	const uint32_t cacheNumNeigh[],
+	const uint32_t cacheNeighID[]);
+
+// Determine the transition rates out of mesoscopic subvolumes that are along
+// the boundary of their respective region. The rates must already be allocated
+void findSubvolDiffRate(const uint32_t numSub,
+	struct subvolume3D subvolArray[],
+	const struct region regionArray[],
+	const short NUM_REGIONS,
+	const unsigned short NUM_MOL_TYPES,
+	const double SUBVOL_BASE_SIZE,
+	double DIFF_COEF[NUM_REGIONS][NUM_MOL_TYPES],
+	uint32_t subCoorInd[numSub][3]);
 
 // Determine whether two subvolumes in neighboring regions are neighbors themselves
 // Assert that each subvolume is along its own region's boundary
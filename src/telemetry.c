@@ -0,0 +1,250 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * telemetry.c - periodic records of the progress and resource use of a
+ *				running simulation, appended to a file or named pipe so
+ *				that stalled or exploding jobs can be detected early
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifdef __linux__
+	#define _POSIX_C_SOURCE 200112L // for getrusage(), sysconf()
+	#include <errno.h> // for EPIPE
+	#include <sys/resource.h> // for getrusage()
+	#include <sys/stat.h> // for permissions of file
+	#include <fcntl.h> // for open()
+	#include <unistd.h> // for write(), close(), sysconf()
+	#include <signal.h> // for ignoring SIGPIPE
+#endif // __linux__
+#include <string.h> // for strlen(), memcpy()
+#include "telemetry.h"
+#include "profile.h" // for profileNow()
+#include "cJSON.h"
+
+//
+// "Private" Declarations
+//
+
+// Find the current and largest resident memory of the simulation (in bytes)
+static void findMemoryUse(uint64_t * rss,
+	uint64_t * peakRSS);
+
+// Append one line to the telemetry file without waiting for a reader
+static void appendTelemetryRecord(struct telemetry * tel,
+	const char * record);
+
+//
+// Definitions
+//
+
+// Initialize telemetry and start its clock
+void initializeTelemetry(struct telemetry * tel,
+	char * name,
+	const double interval)
+{
+	tel->name = name;
+	tel->interval = interval;
+	tel->startTime = profileNow();
+	tel->lastTime = tel->startTime;
+	tel->numMesoEvent = 0;
+	tel->lastMesoEvent = 0;
+	tel->numEventSinceCheck = 0;
+	tel->fd = -1;
+
+#ifdef __linux__
+	// A reader of a named pipe could close it while a record is written
+	if(name != NULL)
+		signal(SIGPIPE, SIG_IGN);
+#endif // __linux__
+}
+
+// Is a new record due? Only checks the clock every TELEMETRY_CHECK_EVENTS
+// calls unless bCheckClock is true
+bool bTelemetryDue(struct telemetry * tel,
+	const bool bCheckClock)
+{
+	if(tel->name == NULL)
+		return false;
+	if(!bCheckClock && ++tel->numEventSinceCheck < TELEMETRY_CHECK_EVENTS)
+		return false;
+	tel->numEventSinceCheck = 0;
+	return profileNow() - tel->lastTime >= tel->interval;
+}
+
+// Append a record to the telemetry file. numMesoEventCur is the number of
+// mesoscopic events so far in the current realization
+void writeTelemetry(struct telemetry * tel,
+	const bool bFinished,
+	const unsigned int numRealization,
+	const unsigned int NUM_REPEAT,
+	const double tCur,
+	const uint64_t numMesoEventCur,
+	const uint64_t numOutputBytes,
+	const short NUM_REGIONS,
+	const unsigned short NUM_MOL_TYPES,
+	const struct region regionArray[],
+	ListMol3D microMolList[NUM_REGIONS][NUM_MOL_TYPES],
+	const uint32_t numSub,
+	const struct subvolume3D subvolArray[])
+{
+	cJSON * root, * countObj, * curArray;
+	char * recordText;
+	short curRegion;
+	unsigned short curMolType;
+	uint32_t curSub;
+	uint64_t * numMol;
+	uint64_t rss, peakRSS, numMesoEvent;
+	NodeMol3D * curNode;
+	double now = profileNow();
+
+	if(tel->name == NULL)
+		return;
+
+	numMol = malloc(NUM_REGIONS*NUM_MOL_TYPES*sizeof(uint64_t));
+	if(numMol == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation for telemetry molecule counts.\n");
+		exit(EXIT_FAILURE);
+	}
+
+	// Count molecules in every region
+	for(curRegion = 0; curRegion < NUM_REGIONS; curRegion++)
+	{
+		for(curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
+		{
+			numMol[curRegion*NUM_MOL_TYPES + curMolType] = 0;
+			if(!regionArray[curRegion].spec.bMicro)
+				continue;
+			for(curNode = microMolList[curRegion][curMolType];
+				curNode != NULL; curNode = curNode->next)
+				numMol[curRegion*NUM_MOL_TYPES + curMolType]++;
+		}
+	}
+	for(curSub = 0; curSub < numSub; curSub++)
+	{
+		curRegion = subvolArray[curSub].regionID;
+		if(regionArray[curRegion].spec.bMicro)
+			continue;
+		for(curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
+			numMol[curRegion*NUM_MOL_TYPES + curMolType] +=
+				subvolArray[curSub].num_mol[curMolType];
+	}
+
+	numMesoEvent = tel->numMesoEvent + numMesoEventCur;
+	findMemoryUse(&rss, &peakRSS);
+
+	root = cJSON_CreateObject();
+	cJSON_AddNumberToObject(root, "WallTime", now - tel->startTime);
+	cJSON_AddNumberToObject(root, "Realization", numRealization);
+	cJSON_AddNumberToObject(root, "NumRepeat", NUM_REPEAT);
+	cJSON_AddNumberToObject(root, "SimTime", tCur);
+	cJSON_AddNumberToObject(root, "MesoEventRate", (now > tel->lastTime) ?
+		(numMesoEvent - tel->lastMesoEvent) / (now - tel->lastTime) : 0.);
+	cJSON_AddNumberToObject(root, "OutputBytes", (double) numOutputBytes);
+	cJSON_AddNumberToObject(root, "RSS", (double) rss);
+	cJSON_AddNumberToObject(root, "PeakRSS", (double) peakRSS);
+	cJSON_AddItemToObject(root, "RegionMolCount", countObj = cJSON_CreateObject());
+	for(curRegion = 0; curRegion < NUM_REGIONS; curRegion++)
+	{
+		cJSON_AddItemToObject(countObj, regionArray[curRegion].spec.label,
+			curArray = cJSON_CreateArray());
+		for(curMolType = 0; curMolType < NUM_MOL_TYPES; curMolType++)
+			cJSON_AddItemToArray(curArray, cJSON_CreateNumber(
+				(double) numMol[curRegion*NUM_MOL_TYPES + curMolType]));
+	}
+	cJSON_AddItemToObject(root, "bFinished",
+		bFinished ? cJSON_CreateTrue() : cJSON_CreateFalse());
+
+	recordText = cJSON_PrintUnformatted(root);
+	appendTelemetryRecord(tel, recordText);
+	free(recordText);
+	cJSON_Delete(root);
+	free(numMol);
+
+	tel->lastTime = now;
+	tel->lastMesoEvent = numMesoEvent;
+}
+
+// Close the telemetry file
+void closeTelemetry(struct telemetry * tel)
+{
+#ifdef __linux__
+	if(tel->fd >= 0)
+		close(tel->fd);
+#endif // __linux__
+	tel->fd = -1;
+}
+
+// Find the current and largest resident memory of the simulation (in bytes)
+static void findMemoryUse(uint64_t * rss,
+	uint64_t * peakRSS)
+{
+#ifdef __linux__
+	FILE * statm;
+	unsigned long numPage, numPageResident;
+	struct rusage usage;
+#endif // __linux__
+
+	*rss = 0;
+	*peakRSS = 0;
+#ifdef __linux__
+	statm = fopen("/proc/self/statm", "r");
+	if(statm != NULL)
+	{
+		if(fscanf(statm, "%lu %lu", &numPage, &numPageResident) == 2)
+			*rss = (uint64_t) numPageResident * (uint64_t) sysconf(_SC_PAGESIZE);
+		fclose(statm);
+	}
+	if(getrusage(RUSAGE_SELF, &usage) == 0)
+		*peakRSS = (uint64_t) usage.ru_maxrss * 1024; // ru_maxrss is in kB
+	if(*rss > *peakRSS)
+		*peakRSS = *rss; // ru_maxrss can lag behind
+#endif // __linux__
+}
+
+// Append one line to the telemetry file without waiting for a reader
+static void appendTelemetryRecord(struct telemetry * tel,
+	const char * record)
+{
+#ifdef __linux__
+	size_t length = strlen(record);
+	char * line;
+
+	// Opening a named pipe fails if it has no reader
+	if(tel->fd < 0)
+		tel->fd = open(tel->name, O_WRONLY | O_APPEND | O_CREAT | O_NONBLOCK,
+			S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if(tel->fd < 0)
+		return;
+
+	// Write record and newline in one call so that a short record is not
+	// split. The record is dropped if the pipe is full
+	line = malloc(length + 1);
+	if(line == NULL)
+	{
+		fprintf(stderr, "ERROR: Memory allocation for telemetry record.\n");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(line, record, length);
+	line[length] = '\n';
+	if(write(tel->fd, line, length + 1) < 0 && errno == EPIPE)
+		closeTelemetry(tel); // Reader closed pipe. Wait for a new reader
+	free(line);
+#else
+	FILE * file;
+
+	file = fopen(tel->name, "a");
+	if(file == NULL)
+		return;
+	fprintf(file, "%s\n", record);
+	fclose(file);
+#endif // __linux__
+}
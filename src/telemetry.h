@@ -0,0 +1,107 @@
+/*
+ * The AcCoRD Simulator
+ * (Actor-based Communication via Reaction-Diffusion)
+ *
+ * For license details, read LICENSE.txt in the root AcCoRD directory
+ * For user documentation, read README.txt in the root AcCoRD directory
+ *
+ * telemetry.h - periodic records of the progress and resource use of a
+ *				running simulation, appended to a file or named pipe so
+ *				that stalled or exploding jobs can be detected early
+ *
+ * Last revised for AcCoRD LATEST_VERSION
+ *
+ * Revision history:
+ *
+ * Created 2026-10-16
+*/
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdio.h> // for fprintf()
+#include <stdlib.h> // for exit(), malloc, free
+#include <stdbool.h> // for C++ bool naming, requires C99
+#include <stdint.h> // for uint64_t
+#include "region.h"
+#include "subvolume.h"
+#include "micro_molecule.h"
+
+/* FORMAT OF TELEMETRY RECORDS
+*
+* Each record is one line with a JSON object:
+*	"WallTime": Seconds since the simulation started
+*	"Realization": Number of completed realizations
+*	"NumRepeat": Total number of realizations
+*	"SimTime": Simulation time of the current realization
+*	"MesoEventRate": Mesoscopic events per second since the previous record
+*	"OutputBytes": Bytes written to the output file
+*	"RSS": Resident memory of the simulation in bytes (0 if unknown)
+*	"PeakRSS": Largest resident memory so far in bytes (0 if unknown)
+*	"RegionMolCount": Object with the number of molecules of each type in
+*		each region, by region label
+*	"bFinished": true in the last record of the simulation
+*
+* The simulation never waits for the reader of a named pipe. Records are
+* skipped while the pipe has no reader or is full, and the pipe is opened
+* again when a reader closes it.
+*/
+
+//
+// Constant definitions
+//
+
+// Number of simulation events between checks of the clock (the clock is
+// always checked at microscopic time steps)
+#define TELEMETRY_CHECK_EVENTS 4096
+
+//
+// Data Type Declarations
+//
+
+/* The telemetry structure has the state of the telemetry of a simulation.
+*/
+struct telemetry {
+	char * name; // File or named pipe that records are appended to
+	double interval; // Wall time between records (seconds)
+	double startTime; // Wall time when the simulation started
+	double lastTime; // Wall time of the previous record
+	uint64_t numMesoEvent; // Mesoscopic events in completed realizations
+	uint64_t lastMesoEvent; // Mesoscopic events before the previous record
+	unsigned int numEventSinceCheck; // Events since the clock was checked
+	int fd; // Descriptor of open telemetry file (-1 if closed; Linux only)
+};
+
+//
+// Function Declarations
+//
+
+// Initialize telemetry and start its clock
+void initializeTelemetry(struct telemetry * tel,
+	char * name,
+	const double interval);
+
+// Is a new record due? Only checks the clock every TELEMETRY_CHECK_EVENTS
+// calls unless bCheckClock is true
+bool bTelemetryDue(struct telemetry * tel,
+	const bool bCheckClock);
+
+// Append a record to the telemetry file. numMesoEventCur is the number of
+// mesoscopic events so far in the current realization
+void writeTelemetry(struct telemetry * tel,
+	const bool bFinished,
+	const unsigned int numRealization,
+	const unsigned int NUM_REPEAT,
+	const double tCur,
+	const uint64_t numMesoEventCur,
+	const uint64_t numOutputBytes,
+	const short NUM_REGIONS,
+	const unsigned short NUM_MOL_TYPES,
+	const struct region regionArray[],
+	ListMol3D microMolList[NUM_REGIONS][NUM_MOL_TYPES],
+	const uint32_t numSub,
+	const struct subvolume3D subvolArray[]);
+
+// Close the telemetry file
+void closeTelemetry(struct telemetry * tel);
+
+#endif // TELEMETRY_H
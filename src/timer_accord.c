@@ -11,10 +11,15 @@
  *						heap to store the next action time by all actors
  * 						and the micro and meso simulation regimes
  *
- * Last revised for AcCoRD v0.4.1
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - indexed the timer heap with 32-bit IDs and stored the keys inline
+ * - started actor timers at the times already set by resetActors
+ * - added opt-in profiling of simulation phases
+ *
  * Revision v0.4.1
  * - improved use and format of error messages
  *
@@ -29,18 +34,34 @@
  * Created 2015-03-02
 */
 #include "timer_accord.h"
+#include "profile.h" // for counting heap updates
 
 //
 // "Private" Declarations
 //
 
+// Does heap node 1 belong above heap node 2?
+static bool bTimerBefore(const struct timerHeapNode * node1,
+	const struct timerHeapNode * node2);
+
+// Move heap node towards the top of the heap until its parent is smaller
+static uint32_t heapTimerSiftUp(struct timerStruct timerArray[],
+	struct timerHeapNode heapTimer[],
+	uint32_t heapID);
+
+// Move heap node towards the bottom of the heap until its children are larger
+static uint32_t heapTimerSiftDown(const uint32_t NUM_TIMERS,
+	struct timerStruct timerArray[],
+	struct timerHeapNode heapTimer[],
+	uint32_t heapID);
+
 //
 // Definitions
 //
 
 /* Allocate space for an array of timer values
 */
-void allocateTimerArray(const short NUM_TIMERS,
+void allocateTimerArray(const uint32_t NUM_TIMERS,
 	struct timerStruct ** timerArray)
 {
 	
@@ -52,21 +73,16 @@ void allocateTimerArray(const short NUM_TIMERS,
 	}
 }
 
-/* Allocate space for the heap of IDs pointing to the array of timers
- * timer structures, a 2D array listing the child IDs of each heap element,
- * and a 2D array of bools indicating whether each child is valid
+/* Allocate space for the heap of timers. Each heap node stores its timer's ID
+ * and a copy of its value. The children of node i are nodes 2i+1 and 2i+2
 */
-void allocateTimerHeapArray(const short NUM_TIMERS,
-	short ** heapTimer,
-	short (**heapTimerChildID)[2],
-	bool (**b_heapTimerChildValid)[2])
+void allocateTimerHeapArray(const uint32_t NUM_TIMERS,
+	struct timerHeapNode ** heapTimer)
 {
 	
-	*heapTimer = malloc(NUM_TIMERS*sizeof(short));
-	*heapTimerChildID = malloc(NUM_TIMERS*sizeof(short [2]));
-	*b_heapTimerChildValid = malloc(NUM_TIMERS*sizeof(bool [2]));
+	*heapTimer = malloc(NUM_TIMERS*sizeof(struct timerHeapNode));
 		
-	if(*heapTimer == NULL || *heapTimerChildID == NULL || *b_heapTimerChildValid == NULL)
+	if(*heapTimer == NULL)
 	{
 		fprintf(stderr, "ERROR: Memory allocation for heap of timer structures.\n");
 		exit(EXIT_FAILURE);
@@ -79,10 +95,10 @@ void deleteTimerHeapArray(struct timerStruct timerArray[])
 }
 
 // Initialize Array of pointers to Timer values
-void initializeTimerArray(const short NUM_TIMERS,
+void initializeTimerArray(const uint32_t NUM_TIMERS,
 	struct timerStruct timerArray[])
 {
-	short curTimer;
+	uint32_t curTimer;
 	
 	for(curTimer=0; curTimer < NUM_TIMERS; curTimer++)
 	{
@@ -92,221 +108,141 @@ void initializeTimerArray(const short NUM_TIMERS,
 }
 
 // Reset initial times for all timers
-void resetTimerArray(const short NUM_TIMERS,
+void resetTimerArray(const uint32_t NUM_TIMERS,
 	struct timerStruct timerArray[],
 	const short NUM_ACTORS,
 	const struct actorStruct3D actorCommonArray[],
-	const short MESO_TIMER_ID,
+	const uint32_t MESO_TIMER_ID,
 	const double tMeso,
-	const short MICRO_TIMER_ID,
+	const uint32_t MICRO_TIMER_ID,
 	const double DT_MICRO)
 {
 	short curTimer;
 	
+	// Actor times have already been reset by resetActors
 	for(curTimer = 0; curTimer < NUM_ACTORS; curTimer++)
 	{
-		timerArray[curTimer].nextTime = actorCommonArray[curTimer].spec.startTime;
+		timerArray[curTimer].nextTime = actorCommonArray[curTimer].nextTime;
 	}
 	
 	timerArray[MESO_TIMER_ID].nextTime = tMeso;
 	timerArray[MICRO_TIMER_ID].nextTime = DT_MICRO;
 }
 
-// Update next time of timer
-// NOTE: heapTimerUpdate should be called IMMEDIATELY after (i.e., before another
-// call to this function), otherwise the heap won't be properly sorted
-void updateTimer(const short curTimer,
-	const short NUM_TIMERS,
+// Update next time of timer and its place in the heap. The heap is only
+// changed if the time is different from the current timer value
+void updateTimer(const uint32_t curTimer,
+	const uint32_t NUM_TIMERS,
 	struct timerStruct timerArray[],
-	double tCur)
-{
-	return;
-}
-
-// Build 2D array listing children of heap elements
-void heapTimerFindChildren(const short NUM_TIMERS,
-	short heapTimerChildID[][2],
-	bool b_heapTimerChildValid[][2])
+	struct timerHeapNode heapTimer[],
+	double tNext)
 {
-	short i;
-	
-	for(i = 0; i < NUM_TIMERS; i++){ // parent == i
-		heapTimerChildID[i][0] = (short) 2*i + 1;
-		heapTimerChildID[i][1] = (short) 2*i + 2;
-		
-		if (heapTimerChildID[i][1] < NUM_TIMERS){ // Both children valid
-			b_heapTimerChildValid[i][0] = true;
-			b_heapTimerChildValid[i][1] = true;
-		} else if (heapTimerChildID[i][0] < NUM_TIMERS){ // First child valid
-			b_heapTimerChildValid[i][0] = true;
-			b_heapTimerChildValid[i][1] = false;
-		} else { // No valid children
-			b_heapTimerChildValid[i][0] = false;
-			b_heapTimerChildValid[i][1] = false;
-		}			
-	}
+	if(timerArray[curTimer].nextTime == tNext)
+		return;
 	
-	return;
+	timerArray[curTimer].nextTime = tNext;
+	heapTimer[timerArray[curTimer].heapID].nextTime = tNext;
+	heapTimerUpdate(NUM_TIMERS, timerArray, heapTimer,
+		timerArray[curTimer].heapID);
 }
 
-// Free memory of heap arrays
-void heapTimerDelete(short heapTimer[],
-	short heapTimerChildID[][2],
-	bool b_heapTimerChildValid[][2])
+// Free memory of heap array
+void heapTimerDelete(struct timerHeapNode heapTimer[])
 {	
 	if(heapTimer != NULL) free(heapTimer);
-	if(heapTimerChildID != NULL) free(heapTimerChildID);
-	if(b_heapTimerChildValid != NULL) free(b_heapTimerChildValid);
 }
 
 // Build Heap of Timers
-void heapTimerBuild(const short NUM_TIMERS,
+void heapTimerBuild(const uint32_t NUM_TIMERS,
 	struct timerStruct timerArray[],
-	short heapTimer[],
-	const unsigned int numHeapLevels,
-	short heapTimerChildID[][2],
-	bool b_heapTimerChildValid[][2])
+	struct timerHeapNode heapTimer[])
 {
-	int i,j;
-	short levelFirst, levelLast; // First and last elements in current level
-	short parent, parentNew, parentOld;
+	uint32_t i;
 	
-	// Initialize heap with ordered (but unsorted) indices
-	for(i=0;i<NUM_TIMERS;i++){
-		heapTimer[i] = i;
+	// Initialize heap with ordered (but unsorted) timers
+	for(i = 0; i < NUM_TIMERS; i++){
+		heapTimer[i].nextTime = timerArray[i].nextTime;
+		heapTimer[i].timerID = i;
 		timerArray[i].heapID = i;
 	}
 	
-	// Make heap a "min-heap" using next reaction times
-	for(i = numHeapLevels-2; i >= 0; i--){ // For each level in heap
-		levelFirst = 1;
-		for(j=0; j<i; j++) levelFirst *= 2;
-		levelLast = 2*levelFirst - 2; // Last element is 2^(i+1)-2
-		levelFirst--; // First element is 2^i - 1
-		for(parent = levelFirst; parent <= levelLast; parent++){
-			// Compare element with its two children
-			parentOld = parent;
-			parentNew = heapTimerCompareDown(NUM_TIMERS, timerArray, heapTimer,
-				parent, heapTimerChildID, b_heapTimerChildValid);
-			while(parentNew != parentOld){
-				// Keep comparing with children until this parent is the min
-				parentOld = parentNew;
-				parentNew = heapTimerCompareDown(NUM_TIMERS, timerArray, heapTimer,
-					parentOld, heapTimerChildID, b_heapTimerChildValid);
-			}
-		}
-	}
+	// Make heap a "min-heap" using next action times, starting from the
+	// last element that has a child
+	for(i = NUM_TIMERS/2; i > 0; i--)
+		heapTimerSiftDown(NUM_TIMERS, timerArray, heapTimer, i-1);
 }
 
 // Update Placement of Single Heap Element Based on Updated Value
-short heapTimerUpdate(const short NUM_TIMERS,
+// Return new location of element
+uint32_t heapTimerUpdate(const uint32_t NUM_TIMERS,
 	struct timerStruct timerArray[],
-	short heapTimer[],
-	const short heapID,
-	short heapTimerChildID[][2],
-	bool b_heapTimerChildValid[][2])
+	struct timerHeapNode heapTimer[],
+	const uint32_t heapID)
 {
-	short newID, oldID; // Updated current and previous placement in heap
-	
-	// See if element needs to move "down" (i.e., lower priority)
-	oldID = heapID;
-	newID = heapTimerCompareDown(NUM_TIMERS, timerArray, heapTimer, heapID,
-		heapTimerChildID, b_heapTimerChildValid);
-	while(newID != oldID){
-		oldID = newID;
-		newID = heapTimerCompareDown(NUM_TIMERS, timerArray, heapTimer, oldID,
-			heapTimerChildID, b_heapTimerChildValid);
-	}
-	if (newID == heapID && heapID > 0){
-		// Element did not move down and it is not already at the top of the heap.
-		// See if it needs to move "up" (i.e., higher priority)
-		newID = heapTimerCompareUp(NUM_TIMERS, timerArray, heapTimer, heapID);
-		while(newID != oldID){
-			oldID = newID;
-			newID = heapTimerCompareUp(NUM_TIMERS, timerArray, heapTimer, oldID);
-		}
-	}
-	return newID;
+	PROFILE_COUNT(PROFILE_TIMER_HEAP_UPDATE, 1);
+	if (heapID > 0 && bTimerBefore(&heapTimer[heapID], &heapTimer[(heapID-1)/2]))
+		return heapTimerSiftUp(timerArray, heapTimer, heapID);
+	else
+		return heapTimerSiftDown(NUM_TIMERS, timerArray, heapTimer, heapID);
 }
 
-// Compare parent node with its children. Swap if parent does not have smallest value
-// Return (possibly new) location of parent node
-short heapTimerCompareDown(const short NUM_TIMERS,
-	struct timerStruct timerArray[],
-	short heapTimer[],
-	const short parent,
-	short heapTimerChildID[][2],
-	bool b_heapTimerChildValid[][2])
+// Does heap node 1 belong above heap node 2?
+static bool bTimerBefore(const struct timerHeapNode * node1,
+	const struct timerHeapNode * node2)
 {
-		
-	short child1 = heapTimerChildID[parent][0];
-	short child2 = heapTimerChildID[parent][1];
-	
-	if (b_heapTimerChildValid[parent][1]){
-		if (timerArray[heapTimer[parent]].nextTime <
-			timerArray[heapTimer[child1]].nextTime){
-			if (timerArray[heapTimer[parent]].nextTime >
-				timerArray[heapTimer[child2]].nextTime){
-				// child2 is smallest
-				heapTimerSwap(timerArray,heapTimer,parent,child2);
-				return child2;
-			} // else parent is smallest (do nothing)
-		} else if (timerArray[heapTimer[child2]].nextTime <
-			timerArray[heapTimer[child1]].nextTime){
-			// child2 is smallest
-			heapTimerSwap(timerArray,heapTimer,parent,child2);
-			return child2;
-		} else {
-			// child1 is smallest
-			heapTimerSwap(timerArray,heapTimer,parent,child1);
-			return child1;
-		}
-	} else if (b_heapTimerChildValid[parent][0]
-		&& timerArray[heapTimer[parent]].nextTime >
-		timerArray[heapTimer[child1]].nextTime) {
-		// child1 is smallest
-		heapTimerSwap(timerArray,heapTimer,parent,child1);
-		return child1;
-	}
-	return parent;
+	if (node1->nextTime != node2->nextTime)
+		return node1->nextTime < node2->nextTime;
+	return node1->timerID < node2->timerID;
 }
 
-// Compare node with its parent. Swap if parent has a larger value
-// Return (possibly new) location of node
-short heapTimerCompareUp(const short NUM_TIMERS,
-	struct timerStruct timerArray[],
-	short heapTimer[],
-	const short child){
-	
-	if (child == 0) // Node is at top of heap. No parent exists
-		return child;
-	
-	short parent = child/2;
-	if(child % 2 == 0) // Element is even
-		parent--;
-	
-	if (timerArray[heapTimer[parent]].nextTime >
-		timerArray[heapTimer[child]].nextTime){
-		// Child is smaller. Swap
-		heapTimerSwap(timerArray,heapTimer,parent,child);
-		return parent;
-	} else // Parent is smaller. Do not swap
-		return child;
+// Move heap node towards the top of the heap until its parent is smaller
+// Return new location of node
+static uint32_t heapTimerSiftUp(struct timerStruct timerArray[],
+	struct timerHeapNode heapTimer[],
+	uint32_t heapID)
+{
+	struct timerHeapNode node = heapTimer[heapID];
+	uint32_t parent;
+	
+	while (heapID > 0){
+		parent = (heapID-1)/2;
+		if (!bTimerBefore(&node, &heapTimer[parent]))
+			break;
+		// Parent is larger. Move it down
+		heapTimer[heapID] = heapTimer[parent];
+		timerArray[heapTimer[heapID].timerID].heapID = heapID;
+		heapID = parent;
+		PROFILE_COUNT(PROFILE_TIMER_HEAP_SHIFT, 1);
+	}
+	heapTimer[heapID] = node;
+	timerArray[node.timerID].heapID = heapID;
+	return heapID;
 }
 
-// Swap the positions of two elements in the heap
-void heapTimerSwap(struct timerStruct timerArray[],
-	short heapTimer[],
-	short index1,
-	short index2){
-	
-	short tempID;
-	
-	// Update heap IDs associated with the timers whose heap positions are being swapped
-	timerArray[heapTimer[index1]].heapID = index2;
-	timerArray[heapTimer[index2]].heapID = index1;
-	
-	tempID = heapTimer[index1];
-	heapTimer[index1] = heapTimer[index2];
-	heapTimer[index2] = tempID;
+// Move heap node towards the bottom of the heap until its children are larger
+// Return new location of node
+static uint32_t heapTimerSiftDown(const uint32_t NUM_TIMERS,
+	struct timerStruct timerArray[],
+	struct timerHeapNode heapTimer[],
+	uint32_t heapID)
+{
+	struct timerHeapNode node = heapTimer[heapID];
+	uint32_t child;
+	
+	while ((child = 2*heapID + 1) < NUM_TIMERS){
+		// Find smaller child
+		if (child + 1 < NUM_TIMERS
+			&& bTimerBefore(&heapTimer[child + 1], &heapTimer[child]))
+			child++;
+		if (!bTimerBefore(&heapTimer[child], &node))
+			break;
+		// Child is smaller. Move it up
+		heapTimer[heapID] = heapTimer[child];
+		timerArray[heapTimer[heapID].timerID].heapID = heapID;
+		heapID = child;
+		PROFILE_COUNT(PROFILE_TIMER_HEAP_SHIFT, 1);
+	}
+	heapTimer[heapID] = node;
+	timerArray[node.timerID].heapID = heapID;
+	return heapID;
 }
@@ -11,10 +11,13 @@
  *						heap to store the next action time by all actors
  * 						and the micro and meso simulation regimes
  *
- * Last revised for AcCoRD v0.4.1
+ * Last revised for AcCoRD LATEST_VERSION
  *
  * Revision history:
  *
+ * Revision LATEST_RELEASE
+ * - indexed the timer heap with 32-bit IDs and stored the keys inline
+ *
  * Revision v0.4.1
  * - improved use and format of error messages
  *
@@ -34,6 +37,7 @@
 #include <stdio.h> // for printf, scanf
 #include <stdlib.h> // for exit(), malloc
 #include <stdbool.h> // for C++ bool conventions
+#include <stdint.h> // for uint32_t
 #include <math.h> // for INFINITY
 #include "actor.h"  // for actor start times
 #include "region.h" // for region parameters (each micro region has an associated time)
@@ -53,87 +57,72 @@
 */
 struct timerStruct{
 	
-	short heapID; // Index of timer in timer heap
+	uint32_t heapID; // Index of timer in timer heap
 	
 	double nextTime; // Timer value (time of next action)
 	
 	// FUTURE MEMBERS
 };
 
+/* The timerHeapNode structure is one element of the timer heap. The timer
+* value is copied into the node so that comparisons do not need to look up
+* the timer array. Timers with equal values are ordered by ID, so actors act
+* before the micro and meso regimes at the same time.
+*/
+struct timerHeapNode{
+	
+	double nextTime; // Copy of timer value
+	
+	uint32_t timerID; // Index of timer in timer array
+};
+
 //
 // Function Declarations
 //
 
 // Allocate Array of pointers to Timer values
-void allocateTimerArray(const short NUM_TIMERS,
+void allocateTimerArray(const uint32_t NUM_TIMERS,
 	struct timerStruct ** timerArray);
 
-// Allocate Heap (sorted timer IDs) and associated arrays
-void allocateTimerHeapArray(const short NUM_TIMERS,
-	short ** heapTimer,
-	short (**heapTimerChildID)[2],
-	bool (**b_heapTimerChildValid)[2]);
+// Allocate Heap (sorted timers)
+void allocateTimerHeapArray(const uint32_t NUM_TIMERS,
+	struct timerHeapNode ** heapTimer);
 
 // Free memory allocated to array of Timer values
 void deleteTimerHeapArray(struct timerStruct timerArray[]);
 
 // Initialize Array of pointers to Timer values
-void initializeTimerArray(const short NUM_TIMERS,
+void initializeTimerArray(const uint32_t NUM_TIMERS,
 	struct timerStruct timerArray[]);
 	
 // Reset initial times for all timers
-void resetTimerArray(const short NUM_TIMERS,
+void resetTimerArray(const uint32_t NUM_TIMERS,
 	struct timerStruct timerArray[],
 	const short NUM_ACTORS,
 	const struct actorStruct3D actorCommonArray[],
-	const short MESO_TIMER_ID,
+	const uint32_t MESO_TIMER_ID,
 	const double tMeso,
-	const short MICRO_TIMER_ID,
+	const uint32_t MICRO_TIMER_ID,
 	const double DT_MICRO);
 
-// Update next time of timer
-void updateTimer(const short curTimer,
-	const short NUM_TIMERS,
+// Update next time of timer and its place in the heap. The heap is only
+// changed if the time is different from the current timer value
+void updateTimer(const uint32_t curTimer,
+	const uint32_t NUM_TIMERS,
 	struct timerStruct timerArray[],
-	double tCur);
+	struct timerHeapNode heapTimer[],
+	double tNext);
 
 // Heap Operations
-void heapTimerFindChildren(const short NUM_TIMERS,
-	short heapTimerChildID[][2],
-	bool b_heapTimerChildValid[][2]);
+void heapTimerDelete(struct timerHeapNode heapTimer[]);
 	
-void heapTimerDelete(short heapTimer[],
-	short heapTimerChildID[][2],
-	bool b_heapTimerChildValid[][2]);
-	
-void heapTimerBuild(const short NUM_TIMERS,
-	struct timerStruct timerArray[],
-	short heapTimer[],
-	const unsigned int numHeapLevels,
-	short heapTimerChildID[][2],
-	bool b_heapTimerChildValid[][2]);
-	
-short heapTimerUpdate(const short NUM_TIMERS,
+void heapTimerBuild(const uint32_t NUM_TIMERS,
 	struct timerStruct timerArray[],
-	short heapTimer[],
-	const short heapID,
-	short heapTimerChildID[][2],
-	bool b_heapTimerChildValid[][2]);
+	struct timerHeapNode heapTimer[]);
 	
-short heapTimerCompareDown(const short NUM_TIMERS,
+uint32_t heapTimerUpdate(const uint32_t NUM_TIMERS,
 	struct timerStruct timerArray[],
-	short heapTimer[],
-	const short parent,
-	short heapTimerChildID[][2],
-	bool b_heapTimerChildValid[][2]);
-	
-short heapTimerCompareUp(const short NUM_TIMERS,
-	struct timerStruct timerArray[],
-	short heapTimer[],
-	const short child);
-	
-void heapTimerSwap(struct timerStruct timerArray[],
-	short heapTimer[],
-	short index1, short index2);
+	struct timerHeapNode heapTimer[],
+	const uint32_t heapID);
 	
 #endif // TIMER_ACCORD_H